@@ -0,0 +1,119 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "allocation_tracking.h"
+
+#include <algorithm>
+
+#include "per_thread.h"
+
+namespace AllocationTracking
+{
+    struct ThreadState
+    {
+        unsigned long long count[Source_Count];
+        unsigned long long bytes[Source_Count];
+
+        // may go below zero when memory is freed by another thread than
+        // the one which allocated it
+        long long live[Source_Count];
+        long long peak[Source_Count];
+    };
+
+    // plain data, no allocation on first use, operator new may call in
+    static GDIPP_THREAD_LOCAL ThreadState threadState;
+
+    const char * GetSourceName(Source source)
+    {
+        switch (source)
+        {
+        case Source_Pugixml:
+            return "pugixml";
+        case Source_Heap:
+            return "heap";
+        case Source_Arena:
+            return "arena";
+        default:
+            return "unknown";
+        }
+    }
+
+    void RecordAllocation(Source source, size_t size)
+    {
+        ThreadState & state = threadState;
+
+        ++state.count[source];
+        state.bytes[source] += size;
+        state.live[source] += static_cast<long long>(size);
+        state.peak[source] = std::max(state.peak[source], state.live[source]);
+    }
+
+    void RecordDeallocation(Source source, size_t size)
+    {
+        threadState.live[source] -= static_cast<long long>(size);
+    }
+
+    Statistics::Statistics()
+        : count(0),
+          bytes(0),
+          peakBytes(0)
+    {
+
+    }
+
+    Scope::Scope()
+    {
+        ThreadState & state = threadState;
+
+        for (int s = 0; s < Source_Count; ++s)
+        {
+            startCount[s] = state.count[s];
+            startBytes[s] = state.bytes[s];
+            startLive[s] = state.live[s];
+
+            outerPeak[s] = state.peak[s];
+            state.peak[s] = state.live[s];
+        }
+    }
+
+    Scope::~Scope()
+    {
+        ThreadState & state = threadState;
+
+        for (int s = 0; s < Source_Count; ++s)
+        {
+            state.peak[s] = std::max(outerPeak[s], state.peak[s]);
+        }
+    }
+
+    Statistics Scope::Get(Source source) const
+    {
+        const ThreadState & state = threadState;
+        Statistics statistics;
+
+        statistics.count = state.count[source] - startCount[source];
+        statistics.bytes = state.bytes[source] - startBytes[source];
+        statistics.peakBytes = static_cast<unsigned long long>(std::max(state.peak[source] - startLive[source], 0LL));
+
+        return statistics;
+    }
+} // namespace AllocationTracking
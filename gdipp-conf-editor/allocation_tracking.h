@@ -0,0 +1,91 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace AllocationTracking
+{
+    /*
+    *   Allocation count, bytes and peak of the configuration core per
+    *   operation. pugixml reports through the memory management functions
+    *   Memory installs (arena.h) as Source_Pugixml, whether the block comes
+    *   from malloc or the arena; the arena reports what it hands out as
+    *   Source_Arena as well. The heap (Util and Values strings,
+    *   everything else using operator new) reports when a program replaces
+    *   the global operator new and calls RecordAllocation from it, as
+    *   gdipp-benchmark does.
+    *
+    *   Everything is counted per thread, a Scope sees the allocations of
+    *   the thread that created it.
+    */
+
+    enum Source
+    {
+        Source_Pugixml = 0,
+        Source_Heap,
+        Source_Arena,
+        Source_Count
+    };
+
+    extern const char * GetSourceName(Source source);
+
+    extern void RecordAllocation(Source source, size_t size);
+    extern void RecordDeallocation(Source source, size_t size);
+
+    class Statistics
+    {
+    public:
+        Statistics();
+
+        unsigned long long count;
+        unsigned long long bytes;
+
+        // most bytes held at once above the level at the scope start
+        unsigned long long peakBytes;
+    };
+
+    class Scope
+    {
+        /*
+        *   Allocations from construction on, scopes nest.
+        */
+
+    public:
+        Scope();
+        ~Scope();
+
+        Statistics Get(Source source) const;
+
+    private:
+        unsigned long long startCount[Source_Count];
+        unsigned long long startBytes[Source_Count];
+        long long startLive[Source_Count];
+
+        // peak of the enclosing scope, restored on destruction
+        long long outerPeak[Source_Count];
+
+        Scope(const Scope &);
+        Scope & operator=(const Scope &);
+    };
+}
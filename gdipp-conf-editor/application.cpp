@@ -28,10 +28,14 @@
 #include "gdipp_configuration_writer.h"
 #include "gdipp_configuration_values.h"
 #include "gdipp_preview.h"
+#include "trace.h"
+#include "metrics.h"
+#include "util.h"
 
 #include <commctrl.h>
 #include <windowsx.h>
 #include <shlwapi.h>
+#include <shellapi.h>
 
 #pragma comment(lib, "Comctl32.lib")
 #pragma comment(linker,"/manifestdependency:\"type='win32' name='Microsoft.Windows.Common-Controls' ""version='6.0.0.0' processorArchitecture='*' publicKeyToken='6595b64144ccf1df' language='*'\"")
@@ -52,6 +56,9 @@ namespace GDIPPConfigurationEditor
 
     int Application::Run()
     {
+        // trace=<file>, Chrome trace of the whole editor session
+        Trace::Session traceSession(GetArgument(TEXT("trace")));
+
         INITCOMMONCONTROLSEX comctlInfo;
 
         memset(&comctlInfo, 0, sizeof(INITCOMMONCONTROLSEX));
@@ -113,6 +120,12 @@ namespace GDIPPConfigurationEditor
 
         case WM_COMMAND:
             {
+                if (HIWORD(wparam) == EN_CHANGE || HIWORD(wparam) == CBN_SELCHANGE)
+                {
+                    app->OnEditValues();
+                    break;
+                }
+
                 switch (LOWORD(wparam))
                 {
                 case IDC_SAVE_CONFIGURATION:
@@ -132,6 +145,12 @@ namespace GDIPPConfigurationEditor
                         app->OnClickHelp();
                         break;
                     }
+
+                case IDC_DIAGNOSTICS:
+                    {
+                        app->OnClickDiagnostics();
+                        break;
+                    }
                 }
                 break;
             }
@@ -168,6 +187,34 @@ namespace GDIPPConfigurationEditor
         return programFiles;
     }
 
+    MetaString Application::GetArgument(const MetaString & name) const
+    {
+        int argc = 0;
+        LPWSTR * arguments = CommandLineToArgvW(GetCommandLineW(), &argc);
+
+        if (arguments == NULL)
+        {
+            return MetaString();
+        }
+
+        const MetaString prefix = name + TEXT("=");
+        MetaString value;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const MetaString argument = Util::CreateMetaString(std::wstring(arguments[i]));
+
+            if (argument.compare(0, prefix.length(), prefix) == 0)
+            {
+                value = argument.substr(prefix.length());
+            }
+        }
+
+        LocalFree(arguments);
+
+        return value;
+    }
+
     GDIPPConfiguration::Values Application::GetValuesFromControls() const
     {
         GDIPPConfiguration::Values values;
@@ -395,6 +442,7 @@ namespace GDIPPConfigurationEditor
 			ApplyValuesToControls(values);
 			preview = new GDIPPPreview(hwnd);
 			preview->UpdateView();
+			preview->UpdateComparison(values, values);
 		}
 		catch (const std::runtime_error & e )
 		{
@@ -427,6 +475,25 @@ namespace GDIPPConfigurationEditor
         EndPaint(hwnd, &ps);
     }
 
+    void Application::OnEditValues()
+    {
+        if (preview == NULL)
+        {
+            // the controls are being filled in
+            return;
+        }
+
+        const GDIPPConfiguration::Values candidate = GetValuesFromControls();
+
+        // half-typed values are not previewed
+        if (candidate.Validate().GetStatus() == false)
+        {
+            return;
+        }
+
+        preview->UpdateComparison(values, candidate);
+    }
+
     // button click events
     void Application::OnClickSaveConfiguration()
     {
@@ -459,7 +526,12 @@ namespace GDIPPConfigurationEditor
             {
                 GDIPPConfiguration::Writer writer(configurationDirectory + TEXT("\\gdipp_setting.xml"));
                 writer.Save(values);
+
+                // the saved values are the new current side
+                this->values = values;
+
                 preview->UpdateView();
+                preview->UpdateComparison(this->values, values);
             }
         }
         catch (const std::exception & e)
@@ -480,4 +552,17 @@ namespace GDIPPConfigurationEditor
     {
 
     }
+
+    void Application::OnClickDiagnostics()
+    {
+        std::ostringstream report;
+        report.precision(3);
+
+        Metrics::Snapshot().Write(report);
+
+        MessageBox(hwnd,
+                   Util::CreateMetaString(report.str()).c_str(),
+                   TEXT("GDIPP Configuration editor: Diagnostics"),
+                   MB_ICONINFORMATION);
+    }
 } // namespace GDIPPConfigurationEditor
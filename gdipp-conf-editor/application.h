@@ -60,6 +60,10 @@ namespace GDIPPConfigurationEditor
                                    LPARAM lparam);
 
         MetaString GetGDIPPDirectory() const;
+
+        // value of a `name=value` program argument, empty when not given
+        MetaString GetArgument(const MetaString & name) const;
+
         GDIPPConfiguration::Values GetValuesFromControls() const;
         void ApplyValuesToControls(const GDIPPConfiguration::Values & values);
         void InitializeGUI();
@@ -75,9 +79,15 @@ namespace GDIPPConfigurationEditor
         void OnClose();
         void OnPaint();
 
+        // a value control changed, compares the edit with the saved values
+        void OnEditValues();
+
         // button click events
         void OnClickSaveConfiguration();
         void OnClickAbout();
         void OnClickHelp();
+
+        // latency histograms and counters of this session
+        void OnClickDiagnostics();
     };
 } // namespace GDIPPConfigurationEditor
@@ -0,0 +1,322 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "arena.h"
+
+#include <new>
+#include <cstdlib>
+#include <algorithm>
+
+#if !defined(_WIN32)
+    #include <pthread.h>
+#endif
+
+#include "per_thread.h"
+#include "allocation_tracking.h"
+#include "pugixml/pugixml.hpp"
+
+namespace Memory
+{
+    static const size_t Alignment = 16;
+
+    // in front of every pugixml block, keeps its alignment
+    struct BlockHeader
+    {
+        size_t size;
+        size_t fromArena;
+    };
+
+    static const size_t HeaderSize = (sizeof(BlockHeader) + Alignment - 1) / Alignment * Alignment;
+
+    static volatile long arenasEnabled = 1;
+
+    static GDIPP_THREAD_LOCAL Arena * threadArena = NULL;
+    static GDIPP_THREAD_LOCAL int scopeDepth = 0;
+
+    static size_t AlignSize(size_t size)
+    {
+        return (size + Alignment - 1) / Alignment * Alignment;
+    }
+
+    class ThreadArenaKey
+    {
+        /*
+        *   Thread locals have no destructors, the arena of a thread is
+        *   registered here as well and deleted when the thread exits.
+        */
+
+    public:
+        ThreadArenaKey()
+        {
+#if defined(_WIN32)
+            index = FlsAlloc(DeleteArena);
+#else
+            pthread_key_create(&key, DeleteArena);
+#endif
+        }
+
+        void Set(Arena * arena)
+        {
+#if defined(_WIN32)
+            if (index != FLS_OUT_OF_INDEXES)
+            {
+                FlsSetValue(index, arena);
+            }
+#else
+            pthread_setspecific(key, arena);
+#endif
+        }
+
+    private:
+#if defined(_WIN32)
+        DWORD index;
+
+        static VOID WINAPI DeleteArena(PVOID arena)
+        {
+            delete static_cast<Arena *>(arena);
+        }
+#else
+        pthread_key_t key;
+
+        static void DeleteArena(void * arena)
+        {
+            delete static_cast<Arena *>(arena);
+        }
+#endif
+    };
+
+    // static initialization, before any thread asks for its arena
+    static ThreadArenaKey threadArenaKey;
+
+    Arena::Arena(size_t chunkSize)
+        : chunkSize(chunkSize),
+          first(NULL),
+          current(NULL)
+    {
+
+    }
+
+    Arena::~Arena()
+    {
+        Release();
+    }
+
+    unsigned char * Arena::GetData(Chunk * chunk)
+    {
+        return reinterpret_cast<unsigned char *>(chunk) + AlignSize(sizeof(Chunk));
+    }
+
+    void * Arena::Allocate(size_t size)
+    {
+        size = AlignSize(size ? size : 1);
+
+        // the chunks after the current one are free, filled in order
+        while (current != NULL && current->size - current->used < size && current->next != NULL)
+        {
+            current = current->next;
+        }
+
+        if (current == NULL || current->size - current->used < size)
+        {
+            const size_t dataSize = std::max(chunkSize, size);
+            Chunk * chunk = static_cast<Chunk *>(malloc(AlignSize(sizeof(Chunk)) + dataSize));
+
+            if (chunk == NULL)
+            {
+                throw std::bad_alloc();
+            }
+
+            chunk->size = dataSize;
+            chunk->used = 0;
+
+            if (current == NULL)
+            {
+                chunk->next = first;
+                first = chunk;
+            }
+            else
+            {
+                chunk->next = current->next;
+                current->next = chunk;
+            }
+
+            current = chunk;
+        }
+
+        void * block = GetData(current) + current->used;
+        current->used += size;
+
+        AllocationTracking::RecordAllocation(AllocationTracking::Source_Arena, size);
+
+        return block;
+    }
+
+    void Arena::Reset()
+    {
+        AllocationTracking::RecordDeallocation(AllocationTracking::Source_Arena, GetUsedBytes());
+
+        for (Chunk * chunk = first; chunk != NULL; chunk = chunk->next)
+        {
+            chunk->used = 0;
+        }
+
+        current = first;
+    }
+
+    void Arena::Release()
+    {
+        AllocationTracking::RecordDeallocation(AllocationTracking::Source_Arena, GetUsedBytes());
+
+        while (first != NULL)
+        {
+            Chunk * next = first->next;
+            free(first);
+            first = next;
+        }
+
+        current = NULL;
+    }
+
+    size_t Arena::GetUsedBytes() const
+    {
+        size_t used = 0;
+
+        for (const Chunk * chunk = first; chunk != NULL; chunk = chunk->next)
+        {
+            used += chunk->used;
+        }
+
+        return used;
+    }
+
+    size_t Arena::GetReservedBytes() const
+    {
+        size_t reserved = 0;
+
+        for (const Chunk * chunk = first; chunk != NULL; chunk = chunk->next)
+        {
+            reserved += chunk->size;
+        }
+
+        return reserved;
+    }
+
+    Arena & Arena::GetThreadArena()
+    {
+        if (threadArena == NULL)
+        {
+            threadArena = new Arena;
+            threadArenaKey.Set(threadArena);
+        }
+
+        return * threadArena;
+    }
+
+    ArenaScope::ArenaScope()
+    {
+        ++scopeDepth;
+    }
+
+    ArenaScope::~ArenaScope()
+    {
+        if (--scopeDepth == 0)
+        {
+            Arena::GetThreadArena().Reset();
+        }
+    }
+
+    bool ArenaScope::IsActive()
+    {
+        return scopeDepth > 0;
+    }
+
+    void EnableArenas(bool enable)
+    {
+        arenasEnabled = enable ? 1 : 0;
+    }
+
+    static void * AllocatePugixml(size_t size)
+    {
+        unsigned char * block = NULL;
+        const bool fromArena = arenasEnabled != 0 && ArenaScope::IsActive();
+
+        if (fromArena)
+        {
+            try
+            {
+                block = static_cast<unsigned char *>(Arena::GetThreadArena().Allocate(size + HeaderSize));
+            }
+            catch (const std::bad_alloc &)
+            {
+                return NULL;
+            }
+        }
+        else
+        {
+            block = static_cast<unsigned char *>(malloc(size + HeaderSize));
+
+            if (block == NULL)
+            {
+                return NULL;
+            }
+        }
+
+        BlockHeader * header = reinterpret_cast<BlockHeader *>(block);
+        header->size = size;
+        header->fromArena = fromArena ? 1 : 0;
+
+        AllocationTracking::RecordAllocation(AllocationTracking::Source_Pugixml, size);
+
+        return block + HeaderSize;
+    }
+
+    static void DeallocatePugixml(void * pointer)
+    {
+        if (pointer == NULL)
+        {
+            return;
+        }
+
+        unsigned char * block = static_cast<unsigned char *>(pointer) - HeaderSize;
+        const BlockHeader * header = reinterpret_cast<const BlockHeader *>(block);
+
+        AllocationTracking::RecordDeallocation(AllocationTracking::Source_Pugixml, header->size);
+
+        // arena blocks are given back with the whole arena
+        if (!header->fromArena)
+        {
+            free(block);
+        }
+    }
+
+    class PugixmlAllocatorInstaller
+    {
+    public:
+        PugixmlAllocatorInstaller()
+        {
+            pugi::set_memory_management_functions(AllocatePugixml, DeallocatePugixml);
+        }
+    };
+
+    // static initialization, before any document can exist
+    static PugixmlAllocatorInstaller pugixmlAllocatorInstaller;
+} // namespace Memory
@@ -0,0 +1,105 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace Memory
+{
+    class Arena
+    {
+        /*
+        *   Bump allocator over a list of chunks. Blocks are never freed one
+        *   by one: Reset releases all of them at once and keeps the chunks
+        *   for the next round, Release gives the chunks back to the system.
+        *   Not synchronized, every thread has an arena of its own.
+        *
+        *   Reported to AllocationTracking as Source_Arena, a block counts
+        *   as live until the arena is reset.
+        */
+
+    public:
+        static const size_t DefaultChunkSize = 256 * 1024;
+
+        explicit Arena(size_t chunkSize = DefaultChunkSize);
+        ~Arena();
+
+        // 16-byte aligned, throws std::bad_alloc
+        void * Allocate(size_t size);
+
+        void Reset();
+        void Release();
+
+        size_t GetUsedBytes() const;
+        size_t GetReservedBytes() const;
+
+        // the arena of the calling thread, deleted with its chunks when
+        // the thread exits
+        static Arena & GetThreadArena();
+
+    private:
+        struct Chunk
+        {
+            Chunk * next;
+            size_t size;
+            size_t used;
+        };
+
+        size_t chunkSize;
+        Chunk * first;
+        Chunk * current;
+
+        static unsigned char * GetData(Chunk * chunk);
+
+        Arena(const Arena &);
+        Arena & operator=(const Arena &);
+    };
+
+    class ArenaScope
+    {
+        /*
+        *   One operation on the thread arena: pugixml allocations of the
+        *   calling thread come from the arena until the scope ends, the
+        *   outermost scope resets the arena. Documents created in a scope
+        *   must be destroyed before it ends.
+        *
+        *   pugixml is routed through Memory before main() runs, so no
+        *   document ever holds blocks of another allocator.
+        */
+
+    public:
+        ArenaScope();
+        ~ArenaScope();
+
+        // a scope is open on the calling thread
+        static bool IsActive();
+
+    private:
+        ArenaScope(const ArenaScope &);
+        ArenaScope & operator=(const ArenaScope &);
+    };
+
+    // on by default; off, pugixml allocates with malloc inside scopes too,
+    // for comparing the two
+    extern void EnableArenas(bool enable);
+}
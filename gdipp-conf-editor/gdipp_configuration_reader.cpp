@@ -25,6 +25,9 @@
 #include "gdipp_configuration_values.h"
 #include "pugixml/pugixml.hpp"
 #include "util.h"
+#include "trace.h"
+#include "metrics.h"
+#include "arena.h"
 
 #include <exception>
 
@@ -38,8 +41,15 @@ namespace GDIPPConfiguration
 
     GDIPPConfiguration::Values Reader::GetValues() const
     {
+        GDIPP_TRACE_SCOPE("Reader::GetValues");
+        Metrics::ScopedLatency latency(Metrics::Histogram_Load);
+
         Values values;
 
+        // the document lives in the thread arena, released at once when
+        // the read ends
+        Memory::ArenaScope arenaScope;
+
         pugi::xml_document doc;
         pugi::xml_parse_result result = doc.load_file(fileName.c_str());
 
@@ -187,7 +197,10 @@ namespace GDIPPConfiguration
                     pugi::xml_node offsetYNode = shadowNode.child("offset_y");
                     pugi::xml_node alphaNode = shadowNode.child("alpha");
 
-                    int offsetX, offsetY, alpha;
+                    // INT_MIN marks a value missing from the file
+                    int offsetX = INT_MIN;
+                    int offsetY = INT_MIN;
+                    int alpha = INT_MIN;
 
                     if (!offsetXNode.empty())
                     {
@@ -24,6 +24,9 @@
 
 #include <limits>
 
+#include "trace.h"
+#include "metrics.h"
+
 namespace GDIPPConfiguration
 {
     Values::Values()
@@ -38,6 +41,9 @@ namespace GDIPPConfiguration
 
     Values::ValidationResult Values::Validate() const
     {
+        GDIPP_TRACE_SCOPE("Values::Validate");
+        Metrics::ScopedLatency latency(Metrics::Histogram_Validate);
+
         ValidationResult validationResult;
 
         if (autoHintingMode == AutoHintingMode::NotSet)
@@ -25,8 +25,11 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <climits>
 
+#if defined(_WIN32)
 #include <windows.h>
+#endif
 
 #include "util.h"
 
@@ -289,8 +292,37 @@ namespace GDIPPConfiguration
                 return b;
             }
 
+            // numeric values, 0.0 when the text is not a number
+            double GetRValue() const
+            {
+                return ToNumber(r);
+            }
+
+            double GetGValue() const
+            {
+                return ToNumber(g);
+            }
+
+            double GetBValue() const
+            {
+                return ToNumber(b);
+            }
+
         private:
             MetaString r, g, b;
+
+            static double ToNumber(const MetaString & text)
+            {
+                MetaStream stream(text);
+                double value = 0.0;
+
+                if (!(stream >> value))
+                {
+                    return 0.0;
+                }
+
+                return value;
+            }
         };
 
 
@@ -23,12 +23,114 @@
 #include "gdipp_configuration_writer.h"
 
 #include "util.h"
+#include "trace.h"
+#include "metrics.h"
+#include "arena.h"
 #include "gdipp_configuration_values.h"
 
 #include "pugixml/pugixml.hpp"
 
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
 namespace GDIPPConfiguration
 {
+    class ArenaBuffer
+    {
+        /*
+        *   Bytes in the thread arena, valid until the enclosing ArenaScope
+        *   ends. Growing leaves the old block to the next reset.
+        */
+
+    public:
+        ArenaBuffer()
+            : data(NULL),
+              size(0),
+              capacity(0)
+        {
+
+        }
+
+        void Resize(size_t newSize)
+        {
+            if (newSize > capacity)
+            {
+                const size_t newCapacity = std::max(newSize, capacity * 2);
+                char * newData = static_cast<char *>(Memory::Arena::GetThreadArena().Allocate(newCapacity));
+
+                if (size > 0)
+                {
+                    memcpy(newData, data, size);
+                }
+
+                data = newData;
+                capacity = newCapacity;
+            }
+
+            size = newSize;
+        }
+
+        void Append(const void * bytes, size_t count)
+        {
+            const size_t offset = size;
+
+            Resize(size + count);
+            memcpy(data + offset, bytes, count);
+        }
+
+        char * data;
+        size_t size;
+
+    private:
+        size_t capacity;
+    };
+
+    class ArenaBufferWriter : public pugi::xml_writer
+    {
+    public:
+        explicit ArenaBufferWriter(ArenaBuffer & output)
+            : output(output)
+        {
+
+        }
+
+        virtual void write(const void * data, size_t size)
+        {
+            output.Append(data, size);
+        }
+
+    private:
+        ArenaBuffer & output;
+    };
+
+    // whole file, empty when it cannot be opened, throws when it cannot
+    // be read
+    static void ReadFileContents(const MetaString & fileName, ArenaBuffer & contents)
+    {
+        std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+
+        if (file)
+        {
+            file.seekg(0, std::ios::end);
+            const std::streamoff size = file.tellg();
+
+            if (size < 0)
+            {
+                throw std::runtime_error("Unable to read GDIPP configuration XML file.");
+            }
+
+            contents.Resize(static_cast<size_t>(size));
+            file.seekg(0, std::ios::beg);
+
+            if (contents.size > 0 && !file.read(contents.data, static_cast<std::streamsize>(contents.size)))
+            {
+                throw std::runtime_error("Unable to read GDIPP configuration XML file.");
+            }
+        }
+    }
+
     Writer::Writer(const MetaString & fileName)
         : fileName(fileName)
     {
@@ -37,8 +139,18 @@ namespace GDIPPConfiguration
 
     void Writer::Save(const GDIPPConfiguration::Values & values)
     {
+        GDIPP_TRACE_SCOPE("Writer::Save");
+        Metrics::ScopedLatency latency(Metrics::Histogram_Save);
+
+        // the document and both copies of the file live in the thread
+        // arena, released at once when the save ends
+        Memory::ArenaScope arenaScope;
+
+        ArenaBuffer original;
+        ReadFileContents(fileName, original);
+
         pugi::xml_document doc;
-        pugi::xml_parse_result result = doc.load_file(fileName.c_str());
+        pugi::xml_parse_result result = doc.load_buffer(original.data, original.size);
 
         if (!result)
         {
@@ -204,9 +316,20 @@ namespace GDIPPConfiguration
             }
         }
 
-        if (doc.save_file(fileName.c_str()) == false)
+        // the same output save_file produces
+        ArenaBuffer contents;
+        ArenaBufferWriter writer(contents);
+        doc.save(writer);
+
+        std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(contents.data, static_cast<std::streamsize>(contents.size));
+        file.close();
+
+        if (!file)
         {
             throw std::runtime_error("Unable to save configuration XML file.");
         }
+
+        Metrics::Add(Metrics::Counter_BytesWritten, contents.size);
     }
 } // namespace GDIPPConfiguration
@@ -27,6 +27,8 @@
 #include <iostream>
 
 #include "util.h"
+#include "trace.h"
+#include "metrics.h"
 
 GDIPPPreview::GDIPPPreview(HWND targetWindow)
     : targetWindow(targetWindow),
@@ -35,6 +37,19 @@ GDIPPPreview::GDIPPPreview(HWND targetWindow)
 {
     using namespace Gdiplus;
 
+    TCHAR windowsDirectory[MAX_PATH];
+
+    if (GetWindowsDirectory(windowsDirectory, MAX_PATH) != 0)
+    {
+        comparisonRequest.fontFileName = MetaString(windowsDirectory) + TEXT("\\Fonts\\arial.ttf");
+    }
+
+    comparisonRequest.lines.push_back(L"The quick brown fox jumps over the lazy dog. 0123456789");
+    comparisonRequest.pixelSizes.push_back(11);
+    comparisonRequest.pixelSizes.push_back(13);
+    comparisonRequest.pixelSizes.push_back(16);
+    comparisonRequest.margin = 8;
+
     GdiplusStartupInput gdiplusStartupInput;
     
 
@@ -71,6 +86,9 @@ void GDIPPPreview::UpdateView()
 {
     using namespace Gdiplus;
 
+    GDIPP_TRACE_SCOPE("GDIPPPreview::UpdateView");
+    Metrics::ScopedLatency latency(Metrics::Histogram_PreviewRender);
+
     PROCESS_INFORMATION demoProcess;
     MetaString bitmapFileName;
 
@@ -79,8 +97,16 @@ void GDIPPPreview::UpdateView()
     try
     {
         bitmapFileName = GenerateTemporaryFileName();
-        demoProcess = StartGDIPPDemoProcess(bitmapFileName);
-        WaitForSingleObject(demoProcess.hProcess, INFINITE);
+
+        {
+            GDIPP_TRACE_SCOPE("GDIPPPreview::StartGDIPPDemoProcess");
+            demoProcess = StartGDIPPDemoProcess(bitmapFileName);
+        }
+
+        {
+            GDIPP_TRACE_SCOPE("GDIPPPreview::WaitForDemoProcess");
+            WaitForSingleObject(demoProcess.hProcess, INFINITE);
+        }
 
         CloseHandle(demoProcess.hThread);
         CloseHandle(demoProcess.hProcess);
@@ -91,7 +117,11 @@ void GDIPPPreview::UpdateView()
             fontPreviewImage = NULL;
         }
 
-        fontPreviewImage = Image::FromFile(Util::MetaStringToUnicode(bitmapFileName).c_str());
+        {
+            GDIPP_TRACE_SCOPE("GDIPPPreview::LoadImage");
+            fontPreviewImage = Image::FromFile(Util::MetaStringToUnicode(bitmapFileName).c_str());
+        }
+
         DeleteFile(bitmapFileName.c_str());
         RedrawWindow(targetWindow, NULL, NULL, RDW_ERASE | RDW_INVALIDATE );
     }
@@ -158,18 +188,91 @@ PROCESS_INFORMATION GDIPPPreview::StartGDIPPDemoProcess(const MetaString & bitma
     return processInfo;
 }
 
+void GDIPPPreview::UpdateComparison(const GDIPPConfiguration::Values & current,
+                                    const GDIPPConfiguration::Values & candidate)
+{
+    GDIPP_TRACE_SCOPE("GDIPPPreview::UpdateComparison");
+
+    try
+    {
+        comparison.Render(comparisonRequest, current, candidate);
+    }
+    catch (const std::exception & e)
+    {
+        std::cerr << "Unable to generate comparison. (" << e.what() << ")" << std::endl;
+        return;
+    }
+
+    const POINT origin = GetComparisonOrigin();
+    const std::vector<GDIPPRenderer::ImageTile> & tiles = comparison.GetChangedTiles();
+
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        RECT rect;
+        rect.left = origin.x + tiles[i].x;
+        rect.top = origin.y + tiles[i].y;
+        rect.right = rect.left + tiles[i].width;
+        rect.bottom = rect.top + tiles[i].height;
+
+        InvalidateRect(targetWindow, &rect, FALSE);
+    }
+}
+
+POINT GDIPPPreview::GetComparisonOrigin() const
+{
+    // below the gdipp preview: current | candidate | difference
+    POINT origin;
+    origin.x = 800;
+    origin.y = 50 + (fontPreviewImage ? static_cast<LONG>(fontPreviewImage->GetHeight()) : 0) + 16;
+
+    return origin;
+}
+
 void GDIPPPreview::DrawWidgetToDC(HDC dc)
 {
     using namespace Gdiplus;
 
-    if (fontPreviewImage == NULL)
+    GDIPP_TRACE_SCOPE("GDIPPPreview::DrawWidgetToDC");
+
+    if (fontPreviewImage != NULL)
+    {
+        Graphics graphics(dc);
+        graphics.DrawImage(fontPreviewImage, PointF(800, 50));
+    }
+
+    const GDIPPRenderer::RenderedImage & sheet = comparison.GetSheet();
+
+    if (sheet.IsEmpty())
     {
-        // nothing to draw
         return;
     }
 
-    Graphics graphics(dc);
-    graphics.DrawImage(fontPreviewImage, PointF(800, 50));
+    // the sheet has the DIB section layout, top-down
+    BITMAPINFO bitmapInfo;
+    memset(&bitmapInfo, 0, sizeof(BITMAPINFO));
+
+    bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bitmapInfo.bmiHeader.biWidth = sheet.GetWidth();
+    bitmapInfo.bmiHeader.biHeight = -sheet.GetHeight();
+    bitmapInfo.bmiHeader.biPlanes = 1;
+    bitmapInfo.bmiHeader.biBitCount = 32;
+    bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+    // clipped to the invalidated tiles by BeginPaint
+    const POINT origin = GetComparisonOrigin();
+
+    SetDIBitsToDevice(dc,
+                      origin.x,
+                      origin.y,
+                      sheet.GetWidth(),
+                      sheet.GetHeight(),
+                      0,
+                      0,
+                      0,
+                      sheet.GetHeight(),
+                      sheet.GetRow(0),
+                      &bitmapInfo,
+                      DIB_RGB_COLORS);
 }
 
 MetaString GDIPPPreview::GenerateTemporaryFileName() const
@@ -26,6 +26,9 @@
 #include <gdiplus.h>
 
 #include "local_types.h"
+#include "gdipp_configuration_values.h"
+
+#include "../gdipp_preview_renderer/ab_preview.h"
 
 class GDIPPPreview
 {
@@ -35,11 +38,21 @@ public:
     void UpdateView();
     void DrawWidgetToDC(HDC dc);
 
+    // renders the saved (current) and the edited (candidate) values with the
+    // portable renderer, below the gdipp preview; invalidates only the
+    // tiles which changed, a failed render keeps the last comparison
+    void UpdateComparison(const GDIPPConfiguration::Values & current,
+                          const GDIPPConfiguration::Values & candidate);
+
 private:
     HWND targetWindow;
     Gdiplus::Image * fontPreviewImage;
     ULONG_PTR gdiplusToken;
 
+    GDIPPRenderer::PreviewRequest comparisonRequest;
+    GDIPPRenderer::ABPreview comparison;
+
     PROCESS_INFORMATION StartGDIPPDemoProcess(const MetaString & bitmapFileName);
     MetaString GenerateTemporaryFileName() const;
+    POINT GetComparisonOrigin() const;
 };
@@ -32,3 +32,12 @@
     typedef std::string MetaString;
     typedef std::stringstream MetaStream;
 #endif
+
+#if !defined(_WIN32) && !defined(TEXT)
+    // windows.h is not available, provide the string literal macro
+    #if defined(UNICODE) || defined(_UNICODE)
+        #define TEXT(quote) L##quote
+    #else
+        #define TEXT(quote) quote
+    #endif
+#endif
@@ -0,0 +1,291 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "metrics.h"
+
+#include <algorithm>
+
+#include "per_thread.h"
+
+namespace Metrics
+{
+    static const int SubBucketBits = 5;
+    static const unsigned int SubBucketCount = 1 << SubBucketBits;
+
+    // values from 2^MaxBits ticks on share the last bucket
+    static const int MaxBits = 48;
+    static const unsigned int BucketCount = SubBucketCount + (MaxBits - SubBucketBits) * SubBucketCount;
+
+    struct ThreadBlock
+    {
+        // bucket counts are unsigned int, 32-bit on every target (unsigned
+        // long is 64-bit on LP64 ones), a store is never seen half done
+        volatile unsigned int buckets[Histogram_Count][BucketCount];
+        volatile unsigned long long totalTicks[Histogram_Count];
+        volatile unsigned long long maxTicks[Histogram_Count];
+        volatile unsigned long long counters[Counter_Count];
+
+        ThreadBlock * next;
+    };
+
+    static ThreadBlock * volatile threadBlocks = NULL;
+    static GDIPP_THREAD_LOCAL ThreadBlock * threadBlock = NULL;
+
+    static ThreadBlock & GetThreadBlock()
+    {
+        if (threadBlock == NULL)
+        {
+            // value-initialized, all zero
+            ThreadBlock * block = new ThreadBlock();
+
+            PerThread::Push(threadBlocks, block);
+            threadBlock = block;
+        }
+
+        return * threadBlock;
+    }
+
+    static int GetHighestBit(unsigned long long value)
+    {
+        int bit = 0;
+
+        for (int shift = 32; shift > 0; shift /= 2)
+        {
+            if (value >> shift)
+            {
+                value >>= shift;
+                bit += shift;
+            }
+        }
+
+        return bit;
+    }
+
+    static unsigned int GetBucket(unsigned long long ticks)
+    {
+        if (ticks < SubBucketCount)
+        {
+            return static_cast<unsigned int>(ticks);
+        }
+
+        const int highestBit = GetHighestBit(ticks);
+
+        if (highestBit >= MaxBits)
+        {
+            return BucketCount - 1;
+        }
+
+        // the SubBucketBits bits below the highest one pick the sub-bucket
+        const int shift = highestBit - SubBucketBits;
+        const unsigned int subBucket = static_cast<unsigned int>(ticks >> shift) - SubBucketCount;
+
+        return SubBucketCount + shift * SubBucketCount + subBucket;
+    }
+
+    static unsigned long long GetBucketUpperBound(unsigned int bucket)
+    {
+        if (bucket < SubBucketCount)
+        {
+            return bucket;
+        }
+
+        const int shift = (bucket - SubBucketCount) / SubBucketCount;
+        const unsigned long long subBucket = (bucket - SubBucketCount) % SubBucketCount;
+
+        return ((SubBucketCount + subBucket + 1) << shift) - 1;
+    }
+
+    const char * GetHistogramName(Histogram histogram)
+    {
+        switch (histogram)
+        {
+        case Histogram_Load:
+            return "load";
+        case Histogram_Save:
+            return "save";
+        case Histogram_Validate:
+            return "validate";
+        case Histogram_PreviewRender:
+            return "preview_render";
+        case Histogram_PreviewRasterize:
+            return "preview_rasterize";
+        default:
+            return "unknown";
+        }
+    }
+
+    const char * GetCounterName(Counter counter)
+    {
+        switch (counter)
+        {
+        case Counter_GlyphCacheHits:
+            return "glyph_cache_hits";
+        case Counter_GlyphCacheMisses:
+            return "glyph_cache_misses";
+        case Counter_GammaTableHits:
+            return "gamma_table_hits";
+        case Counter_GammaTableMisses:
+            return "gamma_table_misses";
+        case Counter_BytesWritten:
+            return "bytes_written";
+        default:
+            return "unknown";
+        }
+    }
+
+    void RecordLatency(Histogram histogram, unsigned long long ticks)
+    {
+        ThreadBlock & block = GetThreadBlock();
+
+        block.buckets[histogram][GetBucket(ticks)] += 1;
+        block.totalTicks[histogram] += ticks;
+
+        if (ticks > block.maxTicks[histogram])
+        {
+            block.maxTicks[histogram] = ticks;
+        }
+    }
+
+    void Add(Counter counter, unsigned long long amount)
+    {
+        GetThreadBlock().counters[counter] += amount;
+    }
+
+    HistogramSnapshot::HistogramSnapshot()
+        : buckets(BucketCount, 0),
+          count(0),
+          totalTicks(0),
+          maxTicks(0),
+          secondsPerTick(1.0 / Trace::GetTicksPerSecond())
+    {
+
+    }
+
+    double HistogramSnapshot::GetPercentileSeconds(double percentile) const
+    {
+        if (count == 0)
+        {
+            return 0.0;
+        }
+
+        const double clamped = std::min(std::max(percentile, 0.0), 100.0);
+        const unsigned long long rank = std::max(static_cast<unsigned long long>(clamped / 100.0 * count + 0.999999), 1ULL);
+
+        unsigned long long seen = 0;
+
+        for (unsigned int i = 0; i < BucketCount; ++i)
+        {
+            seen += buckets[i];
+
+            if (seen >= rank)
+            {
+                return std::min(GetBucketUpperBound(i), maxTicks) * secondsPerTick;
+            }
+        }
+
+        return maxTicks * secondsPerTick;
+    }
+
+    double HistogramSnapshot::GetMeanSeconds() const
+    {
+        return count == 0 ? 0.0 : totalTicks * secondsPerTick / count;
+    }
+
+    double HistogramSnapshot::GetMaxSeconds() const
+    {
+        return maxTicks * secondsPerTick;
+    }
+
+    double HistogramSnapshot::GetTotalSeconds() const
+    {
+        return totalTicks * secondsPerTick;
+    }
+
+    Snapshot::Snapshot()
+    {
+        std::fill(counters, counters + Counter_Count, 0ULL);
+
+        for (ThreadBlock * block = threadBlocks; block != NULL; block = block->next)
+        {
+            for (int h = 0; h < Histogram_Count; ++h)
+            {
+                HistogramSnapshot & histogram = histograms[h];
+
+                for (unsigned int i = 0; i < BucketCount; ++i)
+                {
+                    const unsigned int bucket = block->buckets[h][i];
+
+                    histogram.buckets[i] += bucket;
+                    histogram.count += bucket;
+                }
+
+                histogram.totalTicks += PerThread::ReadStable(block->totalTicks[h]);
+                histogram.maxTicks = std::max(histogram.maxTicks, PerThread::ReadStable(block->maxTicks[h]));
+            }
+
+            for (int c = 0; c < Counter_Count; ++c)
+            {
+                counters[c] += PerThread::ReadStable(block->counters[c]);
+            }
+        }
+    }
+
+    void Snapshot::Write(std::ostream & stream) const
+    {
+        for (int h = 0; h < Histogram_Count; ++h)
+        {
+            const HistogramSnapshot & histogram = histograms[h];
+
+            stream << "histogram=" << GetHistogramName(static_cast<Histogram>(h))
+                   << " count=" << histogram.GetCount()
+                   << " p50_ms=" << histogram.GetPercentileSeconds(50) * 1000.0
+                   << " p90_ms=" << histogram.GetPercentileSeconds(90) * 1000.0
+                   << " p99_ms=" << histogram.GetPercentileSeconds(99) * 1000.0
+                   << " max_ms=" << histogram.GetMaxSeconds() * 1000.0
+                   << " mean_ms=" << histogram.GetMeanSeconds() * 1000.0
+                   << "\n";
+        }
+
+        for (int c = 0; c < Counter_Count; ++c)
+        {
+            stream << "counter=" << GetCounterName(static_cast<Counter>(c))
+                   << " value=" << counters[c]
+                   << "\n";
+        }
+    }
+
+    Report::Report(bool enabled, std::ostream & stream)
+        : enabled(enabled),
+          stream(stream)
+    {
+
+    }
+
+    Report::~Report()
+    {
+        if (enabled)
+        {
+            Snapshot().Write(stream);
+            stream.flush();
+        }
+    }
+} // namespace Metrics
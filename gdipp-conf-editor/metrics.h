@@ -0,0 +1,152 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include "trace.h"
+
+namespace Metrics
+{
+    /*
+    *   Always-on latency histograms and counters. Every thread updates a
+    *   block of its own with plain stores, no locks or interlocked
+    *   instructions; a snapshot adds the blocks of all threads up.
+    *
+    *   Histograms keep HDR-style buckets: exact below 32 ticks, above
+    *   that 32 buckets per power of two, a recorded value is off by at
+    *   most 1/32 of itself.
+    */
+
+    enum Histogram
+    {
+        Histogram_Load = 0,
+        Histogram_Save,
+        Histogram_Validate,
+        Histogram_PreviewRender,
+        Histogram_PreviewRasterize,
+        Histogram_Count
+    };
+
+    enum Counter
+    {
+        Counter_GlyphCacheHits = 0,
+        Counter_GlyphCacheMisses,
+        Counter_GammaTableHits,
+        Counter_GammaTableMisses,
+        Counter_BytesWritten,
+        Counter_Count
+    };
+
+    extern const char * GetHistogramName(Histogram histogram);
+    extern const char * GetCounterName(Counter counter);
+
+    // duration in Trace::GetTicks units
+    extern void RecordLatency(Histogram histogram, unsigned long long ticks);
+    extern void Add(Counter counter, unsigned long long amount = 1);
+
+    class HistogramSnapshot
+    {
+    public:
+        HistogramSnapshot();
+
+        unsigned long long GetCount() const
+        {
+            return count;
+        }
+
+        // upper bound of the bucket of the percentile (nearest rank, 0..100)
+        double GetPercentileSeconds(double percentile) const;
+        double GetMeanSeconds() const;
+        double GetMaxSeconds() const;
+
+        // all recorded durations added up
+        double GetTotalSeconds() const;
+
+    private:
+        friend class Snapshot;
+
+        std::vector<unsigned long long> buckets;
+        unsigned long long count;
+        unsigned long long totalTicks;
+        unsigned long long maxTicks;
+        double secondsPerTick;
+    };
+
+    class Snapshot
+    {
+    public:
+        // sums the blocks of every thread
+        Snapshot();
+
+        HistogramSnapshot histograms[Histogram_Count];
+        unsigned long long counters[Counter_Count];
+
+        // histogram=<name> count p50_ms p90_ms p99_ms max_ms mean_ms and
+        // counter=<name> value, one line each
+        void Write(std::ostream & stream) const;
+    };
+
+    class ScopedLatency
+    {
+    public:
+        explicit ScopedLatency(Histogram histogram)
+            : histogram(histogram),
+              begin(Trace::GetTicks())
+        {
+
+        }
+
+        ~ScopedLatency()
+        {
+            RecordLatency(histogram, Trace::GetTicks() - begin);
+        }
+
+    private:
+        Histogram histogram;
+        unsigned long long begin;
+
+        ScopedLatency(const ScopedLatency &);
+        ScopedLatency & operator=(const ScopedLatency &);
+    };
+
+    class Report
+    {
+        /*
+        *   --stats of the tools: writes a snapshot to the stream when
+        *   destroyed, nothing when not enabled.
+        */
+
+    public:
+        Report(bool enabled, std::ostream & stream);
+        ~Report();
+
+    private:
+        bool enabled;
+        std::ostream & stream;
+
+        Report(const Report &);
+        Report & operator=(const Report &);
+    };
+}
@@ -0,0 +1,98 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#if defined(_WIN32)
+    #include <windows.h>
+
+    #define GDIPP_THREAD_LOCAL __declspec(thread)
+#else
+    #define GDIPP_THREAD_LOCAL __thread
+#endif
+
+namespace PerThread
+{
+    /*
+    *   Building blocks of the per-thread buffers of Trace and Metrics: a
+    *   thread allocates its block on first use, pushes it onto a global
+    *   list and from then on is the only writer of it. Blocks stay on the
+    *   list until the process exits, readers walk the list without locks.
+    */
+
+    inline void MemoryFence()
+    {
+#if defined(_WIN32)
+        MemoryBarrier();
+#else
+        __sync_synchronize();
+#endif
+    }
+
+    inline long AtomicIncrement(volatile long * value)
+    {
+#if defined(_WIN32)
+        return InterlockedIncrement(value);
+#else
+        return __sync_add_and_fetch(value, 1);
+#endif
+    }
+
+    // Block needs a `Block * next` member
+    template <typename Block>
+    void Push(Block * volatile & head, Block * block)
+    {
+        while (true)
+        {
+            Block * first = head;
+            block->next = first;
+
+#if defined(_WIN32)
+            if (InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile *>(&head), block, first) == first)
+#else
+            if (__sync_bool_compare_and_swap(&head, first, block))
+#endif
+            {
+                return;
+            }
+        }
+    }
+
+    // a 64-bit value another thread may be storing, on 32-bit targets the
+    // store is two instructions: read until two reads agree
+    inline unsigned long long ReadStable(const volatile unsigned long long & value)
+    {
+        unsigned long long result = value;
+
+        while (true)
+        {
+            const unsigned long long again = value;
+
+            if (again == result)
+            {
+                return result;
+            }
+
+            result = again;
+        }
+    }
+}
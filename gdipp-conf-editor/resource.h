@@ -46,6 +46,7 @@
 #define IDC_RENDERMODE_GRAYSCALE        1022
 #define IDC_RENDERMODE3                 1023
 #define IDC_RENDERMODE_SUBPIXEL         1023
+#define IDC_DIAGNOSTICS                 1024
 #define IDC_SHOW_HELP                   7676
 
 // Next default values for new objects
@@ -54,7 +55,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        103
 #define _APS_NEXT_COMMAND_VALUE         40001
-#define _APS_NEXT_CONTROL_VALUE         1022
+#define _APS_NEXT_CONTROL_VALUE         1025
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif
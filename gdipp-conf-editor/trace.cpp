@@ -0,0 +1,289 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "trace.h"
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <vector>
+
+#include "util.h"
+#include "per_thread.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+namespace Trace
+{
+    struct Event
+    {
+        const char * name;
+        unsigned long long begin;
+        unsigned long long end;
+    };
+
+    struct ThreadBuffer
+    {
+        Event events[EventsPerThread];
+
+        // events written so far, only the owning thread stores it; unsigned
+        // int is 32-bit on every target (unsigned long is 64-bit on LP64
+        // ones), so the store is a single aligned word; the ring index
+        // survives the wrap around as EventsPerThread divides 2^32
+        volatile unsigned int written;
+
+        long threadId;
+        ThreadBuffer * next;
+    };
+
+    // a thread that ends leaves its events for the export
+    static ThreadBuffer * volatile threadBuffers = NULL;
+    static volatile long threadCount = 0;
+    static volatile long recording = 0;
+    static volatile unsigned long long sessionBegin = 0;
+
+    static GDIPP_THREAD_LOCAL ThreadBuffer * threadBuffer = NULL;
+
+    static long GetTraceProcessId()
+    {
+#if defined(_WIN32)
+        return static_cast<long>(GetCurrentProcessId());
+#else
+        return static_cast<long>(getpid());
+#endif
+    }
+
+    static ThreadBuffer * GetThreadBuffer()
+    {
+        if (threadBuffer == NULL)
+        {
+            ThreadBuffer * buffer = new ThreadBuffer;
+
+            buffer->written = 0;
+            buffer->threadId = PerThread::AtomicIncrement(&threadCount);
+            buffer->next = NULL;
+
+            PerThread::Push(threadBuffers, buffer);
+
+            threadBuffer = buffer;
+        }
+
+        return threadBuffer;
+    }
+
+    static void WriteJsonString(std::ostream & stream, const char * text)
+    {
+        stream << '"';
+
+        for (; * text != 0; ++text)
+        {
+            const unsigned char character = static_cast<unsigned char>(* text);
+
+            if (character == '"' || character == '\\')
+            {
+                stream << '\\' << * text;
+            }
+            else if (character < 0x20)
+            {
+                stream << ' ';
+            }
+            else
+            {
+                stream << * text;
+            }
+        }
+
+        stream << '"';
+    }
+
+    void Start()
+    {
+        sessionBegin = GetTicks();
+        PerThread::MemoryFence();
+        recording = 1;
+    }
+
+    void Stop()
+    {
+        recording = 0;
+        PerThread::MemoryFence();
+    }
+
+    bool IsRecording()
+    {
+        return recording != 0;
+    }
+
+    unsigned long long GetTicks()
+    {
+#if defined(_WIN32)
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+
+        return static_cast<unsigned long long>(counter.QuadPart);
+#else
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        return static_cast<unsigned long long>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+#endif
+    }
+
+    unsigned long long GetTicksPerSecond()
+    {
+#if defined(_WIN32)
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+
+        return static_cast<unsigned long long>(frequency.QuadPart);
+#else
+        return 1000000000ULL;
+#endif
+    }
+
+    void Record(const char * name, unsigned long long begin, unsigned long long end)
+    {
+        ThreadBuffer * buffer = GetThreadBuffer();
+        const unsigned int index = buffer->written;
+
+        Event & event = buffer->events[index % EventsPerThread];
+        event.name = name;
+        event.begin = begin;
+        event.end = end;
+
+        // the event has to be complete before an export can see it
+        PerThread::MemoryFence();
+        buffer->written = index + 1;
+    }
+
+    void WriteChromeTrace(std::ostream & stream)
+    {
+        const double microsecondsPerTick = 1000000.0 / GetTicksPerSecond();
+        const unsigned long long origin = sessionBegin;
+        const long processId = GetTraceProcessId();
+
+        std::vector<Event> events;
+        bool first = true;
+
+        stream << "{\"traceEvents\":[";
+        stream << std::fixed << std::setprecision(3);
+
+        for (ThreadBuffer * buffer = threadBuffers; buffer != NULL; buffer = buffer->next)
+        {
+            /*
+            *   The thread may keep recording meanwhile: copy the newest
+            *   events, then drop those it could have overwritten during the
+            *   copy.
+            */
+
+            const unsigned int written = buffer->written;
+            PerThread::MemoryFence();
+
+            const unsigned int count = written < EventsPerThread ? written : EventsPerThread;
+            events.resize(static_cast<size_t>(count));
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                events[static_cast<size_t>(i)] = buffer->events[(written - count + i) % EventsPerThread];
+            }
+
+            PerThread::MemoryFence();
+            const unsigned int overwritten = buffer->written - written;
+            const size_t valid = overwritten >= count ? events.size() : static_cast<size_t>(overwritten);
+
+            for (size_t i = valid; i < events.size(); ++i)
+            {
+                const Event & event = events[i];
+
+                if (event.begin < origin)
+                {
+                    continue;
+                }
+
+                stream << (first ? "\n" : ",\n");
+                first = false;
+
+                stream << "{\"name\":";
+                WriteJsonString(stream, event.name);
+                stream << ",\"cat\":\"gdipp\",\"ph\":\"X\""
+                       << ",\"ts\":" << (event.begin - origin) * microsecondsPerTick
+                       << ",\"dur\":" << (event.end - event.begin) * microsecondsPerTick
+                       << ",\"pid\":" << processId
+                       << ",\"tid\":" << buffer->threadId
+                       << "}";
+            }
+        }
+
+        stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    void SaveChromeTrace(const MetaString & fileName)
+    {
+        std::ofstream file(fileName.c_str());
+
+        if (!file)
+        {
+            throw std::runtime_error("Trace: unable to create " + Util::MetaStringToAnsi(fileName));
+        }
+
+        WriteChromeTrace(file);
+
+        if (!file)
+        {
+            throw std::runtime_error("Trace: unable to write " + Util::MetaStringToAnsi(fileName));
+        }
+    }
+
+    Session::Session(const MetaString & fileName)
+        : fileName(fileName)
+    {
+        if (!fileName.empty())
+        {
+            Start();
+        }
+    }
+
+    Session::~Session()
+    {
+        if (fileName.empty())
+        {
+            return;
+        }
+
+        Stop();
+
+        try
+        {
+            SaveChromeTrace(fileName);
+        }
+        catch (const std::exception & e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+} // namespace Trace
@@ -0,0 +1,115 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <ostream>
+
+#include "local_types.h"
+
+/*
+*   GDIPP_TRACE_SCOPE("Reader::GetValues") records the time spent in the
+*   enclosing scope while a trace session runs (Trace::Start). Defining
+*   GDIPP_TRACE_DISABLE removes every trace point at compile time.
+*/
+#if defined(GDIPP_TRACE_DISABLE)
+    #define GDIPP_TRACE_SCOPE(name) ((void) 0)
+#else
+    #define GDIPP_TRACE_CONCAT_(a, b) a##b
+    #define GDIPP_TRACE_CONCAT(a, b) GDIPP_TRACE_CONCAT_(a, b)
+    #define GDIPP_TRACE_SCOPE(name) Trace::Scope GDIPP_TRACE_CONCAT(traceScope, __LINE__)(name)
+#endif
+
+namespace Trace
+{
+    /*
+    *   Every thread writes its events into a ring buffer of its own, the
+    *   last EventsPerThread events are kept. Nothing is allocated or
+    *   locked until a thread records its first event in a session.
+    */
+
+    static const unsigned int EventsPerThread = 16384;
+
+    // starts a session, events recorded before are not exported
+    extern void Start();
+    extern void Stop();
+    extern bool IsRecording();
+
+    // Chrome trace event JSON (chrome://tracing, ui.perfetto.dev) of the
+    // events of the current, or the last, session
+    extern void WriteChromeTrace(std::ostream & stream);
+    extern void SaveChromeTrace(const MetaString & fileName);
+
+    // monotonic clock
+    extern unsigned long long GetTicks();
+    extern unsigned long long GetTicksPerSecond();
+
+    // name must outlive the session, normally a string literal
+    extern void Record(const char * name, unsigned long long begin, unsigned long long end);
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char * name)
+            : name(name),
+              recording(IsRecording()),
+              begin(recording ? GetTicks() : 0)
+        {
+
+        }
+
+        ~Scope()
+        {
+            if (recording)
+            {
+                Record(name, begin, GetTicks());
+            }
+        }
+
+    private:
+        const char * name;
+        bool recording;
+        unsigned long long begin;
+
+        Scope(const Scope &);
+        Scope & operator=(const Scope &);
+    };
+
+    class Session
+    {
+        /*
+        *   trace=<file> of the tools: records from construction on and
+        *   saves the trace when destroyed, does nothing for an empty file
+        *   name. The destructor reports errors on std::cerr.
+        */
+
+    public:
+        explicit Session(const MetaString & fileName);
+        ~Session();
+
+    private:
+        MetaString fileName;
+
+        Session(const Session &);
+        Session & operator=(const Session &);
+    };
+}
@@ -24,7 +24,13 @@
 
 #include <sstream>
 
+#if defined(_WIN32)
 #include <windows.h>
+#else
+#include <unistd.h>
+#include <limits.h>
+#endif
+
 #include <iostream>
 
 namespace Util
@@ -45,6 +51,7 @@ namespace Util
         return stream.str();
     }
 
+#if defined(_WIN32)
     std::string UnicodeToAnsi(const std::wstring & input)
     {
         char * buffer = NULL;
@@ -139,6 +146,112 @@ namespace Util
 
        return result;
     }
+#else
+    std::string UnicodeToAnsi(const std::wstring & input)
+    {
+        /*
+        *   No code page conversion API outside of Windows, encode as UTF-8
+        *   (same as the CP_UTF8 conversion above).
+        */
+
+        std::string result;
+        result.reserve(input.length());
+
+        for (size_t i = 0; i < input.length(); ++i)
+        {
+            unsigned long codePoint = static_cast<unsigned long>(input[i]);
+
+            if (codePoint < 0x80)
+            {
+                result += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800)
+            {
+                result += static_cast<char>(0xC0 | (codePoint >> 6));
+                result += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else if (codePoint < 0x10000)
+            {
+                result += static_cast<char>(0xE0 | (codePoint >> 12));
+                result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                result += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else
+            {
+                result += static_cast<char>(0xF0 | (codePoint >> 18));
+                result += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                result += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        return result;
+    }
+
+    std::wstring AnsiToUnicode(const std::string & input)
+    {
+        /*
+        *   Decode UTF-8, invalid sequences are replaced with U+FFFD.
+        */
+
+        std::wstring result;
+        result.reserve(input.length());
+
+        size_t i = 0;
+
+        while (i < input.length())
+        {
+            unsigned char lead = static_cast<unsigned char>(input[i]);
+            unsigned long codePoint = 0xFFFD;
+            size_t length = 1;
+
+            if (lead < 0x80)
+            {
+                codePoint = lead;
+            }
+            else if ((lead & 0xE0) == 0xC0)
+            {
+                codePoint = lead & 0x1F;
+                length = 2;
+            }
+            else if ((lead & 0xF0) == 0xE0)
+            {
+                codePoint = lead & 0x0F;
+                length = 3;
+            }
+            else if ((lead & 0xF8) == 0xF0)
+            {
+                codePoint = lead & 0x07;
+                length = 4;
+            }
+
+            if (i + length > input.length())
+            {
+                codePoint = 0xFFFD;
+                length = 1;
+            }
+
+            for (size_t j = 1; j < length; ++j)
+            {
+                unsigned char next = static_cast<unsigned char>(input[i + j]);
+
+                if ((next & 0xC0) != 0x80)
+                {
+                    codePoint = 0xFFFD;
+                    length = j;
+                    break;
+                }
+
+                codePoint = (codePoint << 6) | (next & 0x3F);
+            }
+
+            result += static_cast<wchar_t>(codePoint);
+            i += length;
+        }
+
+        return result;
+    }
+#endif
 
     MetaString CreateMetaString(const std::string & input)
     {
@@ -187,6 +300,7 @@ namespace Util
 		*	The result is including last path terminator.
 		*/
 
+#if defined(_WIN32)
 		TCHAR processImageName[MAX_PATH];
 
 		if (GetModuleFileName(NULL, processImageName, MAX_PATH) > 0)
@@ -201,6 +315,23 @@ namespace Util
 				return result;
 			}
 		}
+#else
+		char processImageName[PATH_MAX];
+		ssize_t length = readlink("/proc/self/exe", processImageName, PATH_MAX - 1);
+
+		if (length > 0)
+		{
+			processImageName[length] = 0;
+
+			MetaString completeName = CreateMetaString(std::string(processImageName));
+			size_t delimPos = completeName.rfind(TEXT("/"));
+
+			if (delimPos != MetaString::npos)
+			{
+				return completeName.substr(0, delimPos + 1);
+			}
+		}
+#endif
 
 		return MetaString();
 	}
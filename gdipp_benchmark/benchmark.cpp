@@ -0,0 +1,210 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace GDIPPBenchmark
+{
+    Options::Options(int argc, char ** argv)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string argument = argv[i];
+            size_t equalSignPos = argument.find('=');
+
+            if (equalSignPos == std::string::npos)
+            {
+                // flag argument
+                values[argument] = argument;
+            }
+            else
+            {
+                values[argument.substr(0, equalSignPos)] = argument.substr(equalSignPos + 1);
+            }
+        }
+    }
+
+    std::string Options::Get(const std::string & name, const std::string & defaultValue) const
+    {
+        std::map<std::string, std::string>::const_iterator it = values.find(name);
+
+        if (it == values.end())
+        {
+            return defaultValue;
+        }
+
+        return it->second;
+    }
+
+    int Options::GetInt(const std::string & name, int defaultValue) const
+    {
+        std::string value = Get(name, std::string());
+
+        if (value.empty())
+        {
+            return defaultValue;
+        }
+
+        return atoi(value.c_str());
+    }
+
+    double Options::GetDouble(const std::string & name, double defaultValue) const
+    {
+        std::string value = Get(name, std::string());
+
+        if (value.empty())
+        {
+            return defaultValue;
+        }
+
+        return atof(value.c_str());
+    }
+
+    double GetTimeSeconds()
+    {
+#if defined(_WIN32)
+        LARGE_INTEGER frequency, counter;
+
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&counter);
+
+        return static_cast<double>(counter.QuadPart) / frequency.QuadPart;
+#else
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+    }
+
+    Timer::Timer()
+    {
+        Restart();
+    }
+
+    void Timer::Restart()
+    {
+        start = GetTimeSeconds();
+    }
+
+    double Timer::GetElapsedSeconds() const
+    {
+        return GetTimeSeconds() - start;
+    }
+
+    Result::Result(const std::string & suite, const std::string & name)
+    {
+        Add("suite", suite);
+        Add("case", name);
+    }
+
+    Result & Result::Add(const std::string & key, const std::string & value)
+    {
+        fields.push_back(std::make_pair(key, value));
+        return * this;
+    }
+
+    Result & Result::Add(const std::string & key, double value)
+    {
+        std::stringstream stream;
+        stream << value;
+
+        return Add(key, stream.str());
+    }
+
+    void Result::Print() const
+    {
+        for (size_t i = 0; i < fields.size(); ++i)
+        {
+            std::cout << (i ? " " : "") << fields[i].first << "=" << fields[i].second;
+        }
+
+        std::cout << std::endl;
+    }
+
+    LatencySamples::LatencySamples()
+        : sorted(true)
+    {
+
+    }
+
+    void LatencySamples::Add(double seconds)
+    {
+        samples.push_back(seconds);
+        sorted = false;
+    }
+
+    double LatencySamples::GetPercentile(double percentile) const
+    {
+        if (samples.empty())
+        {
+            return 0.0;
+        }
+
+        if (!sorted)
+        {
+            std::sort(samples.begin(), samples.end());
+            sorted = true;
+        }
+
+        size_t rank = static_cast<size_t>(percentile / 100.0 * samples.size() + 0.999999);
+        rank = std::max(rank, static_cast<size_t>(1));
+
+        return samples[std::min(rank, samples.size()) - 1];
+    }
+
+    double LatencySamples::GetMean() const
+    {
+        double sum = 0.0;
+
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            sum += samples[i];
+        }
+
+        return samples.empty() ? 0.0 : sum / samples.size();
+    }
+
+    void LatencySamples::Print(const std::string & suite, const std::string & name, const std::string & stage) const
+    {
+        Result(suite, name)
+            .Add("stage", stage)
+            .Add("samples", static_cast<double>(samples.size()))
+            .Add("p50_ms", GetPercentile(50) * 1e3)
+            .Add("p95_ms", GetPercentile(95) * 1e3)
+            .Add("p99_ms", GetPercentile(99) * 1e3)
+            .Add("mean_ms", GetMean() * 1e3)
+            .Add("max_ms", GetPercentile(100) * 1e3)
+            .Print();
+    }
+} // namespace GDIPPBenchmark
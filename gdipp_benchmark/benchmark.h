@@ -0,0 +1,133 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "../gdipp_preview_renderer/preview_renderer.h"
+
+namespace GDIPPBenchmark
+{
+    class Options
+    {
+        /*
+        *   Program arguments in the `name=value` form, the same convention
+        *   gdipp_demo_render uses.
+        */
+
+    public:
+        Options(int argc, char ** argv);
+
+        std::string Get(const std::string & name, const std::string & defaultValue) const;
+        int GetInt(const std::string & name, int defaultValue) const;
+        double GetDouble(const std::string & name, double defaultValue) const;
+
+    private:
+        std::map<std::string, std::string> values;
+    };
+
+    class Timer
+    {
+    public:
+        Timer();
+
+        void Restart();
+        double GetElapsedSeconds() const;
+
+    private:
+        double start;
+    };
+
+    extern double GetTimeSeconds();
+
+    class Result
+    {
+        /*
+        *   One line of output, `key=value` pairs separated by spaces, so the
+        *   results can be collected and compared by scripts.
+        */
+
+    public:
+        Result(const std::string & suite, const std::string & name);
+
+        Result & Add(const std::string & key, const std::string & value);
+        Result & Add(const std::string & key, double value);
+
+        void Print() const;
+
+    private:
+        std::vector<std::pair<std::string, std::string> > fields;
+    };
+
+    class LatencySamples
+    {
+        /*
+        *   Durations of one repeated step, reported as percentiles.
+        */
+
+    public:
+        LatencySamples();
+
+        void Add(double seconds);
+
+        // nearest rank, percentile 0..100
+        double GetPercentile(double percentile) const;
+        double GetMean() const;
+
+        // stage=<stage> samples p50_ms p95_ms p99_ms mean_ms max_ms
+        void Print(const std::string & suite, const std::string & name, const std::string & stage) const;
+
+    private:
+        mutable std::vector<double> samples;
+        mutable bool sorted;
+    };
+
+    extern void RunLCDFilterBenchmark(const Options & options);
+    extern void RunGammaBenchmark(const Options & options);
+    extern void RunCompositeBenchmark(const Options & options);
+    extern void RunEmboldenBenchmark(const Options & options);
+    extern void RunRenderBenchmark(const Options & options);
+    extern void RunSweepBenchmark(const Options & options);
+    extern void RunLayoutBenchmark(const Options & options);
+    extern void RunEncodeBenchmark(const Options & options);
+    extern void RunConfigBenchmark(const Options & options);
+    extern void RunPreviewBenchmark(const Options & options);
+
+    // generate=<file>, writes a synthetic gdipp_setting.xml instead of
+    // running benchmarks
+    extern void RunConfigurationGenerator(const Options & options);
+
+    // suite=golden or golden=<directory>, compares renders with stored
+    // golden images instead of running benchmarks, returns the number of
+    // images that failed or have no golden
+    extern int RunGoldenImages(const Options & options);
+
+    // paragraph sheet and settings shared by the renderer benchmarks
+    extern std::string GetDefaultFontFileName();
+    extern GDIPPRenderer::PreviewRequest CreateParagraphRequest(const Options & options);
+    extern GDIPPConfiguration::Values CreateBenchmarkValues();
+    extern unsigned long long HashImage(const GDIPPRenderer::RenderedImage & image);
+}
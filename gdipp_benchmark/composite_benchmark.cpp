@@ -0,0 +1,100 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <vector>
+#include <cstdlib>
+
+#include "../gdipp_preview_renderer/coverage_bitmap.h"
+#include "../gdipp_preview_renderer/rendered_image.h"
+#include "../gdipp_preview_renderer/compositor.h"
+#include "../gdipp_preview_renderer/shadow.h"
+#include "../gdipp_preview_renderer/simd.h"
+
+namespace GDIPPBenchmark
+{
+    void RunCompositeBenchmark(const Options & options)
+    {
+        /*
+        *   Recomposites a preview sheet the way a shadow change does:
+        *   background fill, shadow layer, text layer.
+        */
+
+        const int width = options.GetInt("width", 2048);
+        const int height = options.GetInt("height", 1024);
+        const double minimumSeconds = options.GetDouble("seconds", 0.5);
+
+        GDIPPRenderer::CoverageBitmap channels(width * 3, height);
+
+        srand(1);
+
+        for (int y = 0; y < height; ++y)
+        {
+            unsigned char * row = channels.GetRow(y);
+
+            for (int x = 0; x < width * 3; ++x)
+            {
+                // mostly empty sheet with lines of text
+                row[x] = ((y / 12) % 2 == 0) ? static_cast<unsigned char>(rand() & 0xFF) : 0;
+            }
+        }
+
+        const char * names[] = { "text", "text_shadow" };
+
+        for (int withShadow = 0; withShadow < 2; ++withShadow)
+        {
+            const GDIPPRenderer::ShadowParameters shadow(
+                GDIPPConfiguration::Values::Shadow(2, 2, withShadow ? 100 : 0));
+            const int padding = shadow.GetPadding();
+
+            GDIPPRenderer::RenderedImage image;
+            int iterations = 0;
+            Timer timer;
+
+            do
+            {
+                image.Resize(width + 2 * padding, height + 2 * padding, 0xFFFFFF);
+
+                std::vector<GDIPPRenderer::CoverageLayer> layers;
+                GDIPPRenderer::AddShadowLayer(layers, channels, padding, padding, shadow);
+                layers.push_back(GDIPPRenderer::CoverageLayer(channels, padding, padding, 255));
+
+                GDIPPRenderer::CompositeLayers(image, layers, 0x000000);
+
+                ++iterations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            const double seconds = timer.GetElapsedSeconds();
+
+            Result("composite", names[withShadow])
+                .Add("simd", GDIPPRenderer::GetSimdLevelName())
+                .Add("width", width)
+                .Add("height", height)
+                .Add("iterations", iterations)
+                .Add("ms_per_sheet", seconds * 1e3 / iterations)
+                .Add("mpixels_per_second", static_cast<double>(width) * height * iterations / 1e6 / seconds)
+                .Print();
+        }
+    }
+} // namespace GDIPPBenchmark
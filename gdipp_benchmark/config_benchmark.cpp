@@ -0,0 +1,317 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "../gdipp-conf-editor/util.h"
+#include "../gdipp-conf-editor/gdipp_configuration_reader.h"
+#include "../gdipp-conf-editor/gdipp_configuration_writer.h"
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+#include "../gdipp-conf-editor/allocation_tracking.h"
+#include "../gdipp-conf-editor/arena.h"
+
+#include "config_generator.h"
+
+namespace GDIPPBenchmark
+{
+    static void WriteFile(const std::string & fileName, const std::string & content)
+    {
+        std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+
+        if (!file)
+        {
+            throw std::runtime_error("Unable to write " + fileName);
+        }
+    }
+
+    class Measurement
+    {
+        /*
+        *   Repeats an operation for at least the given time and reports the
+        *   time, the heap, pugixml and arena allocations and bytes per
+        *   operation, and the most bytes one operation held at once.
+        */
+
+    public:
+        Measurement(const std::string & name, double minimumSeconds)
+            : name(name),
+              minimumSeconds(minimumSeconds)
+        {
+
+        }
+
+        template <typename Operation>
+        void Run(Operation & operation, double inputBytes)
+        {
+            // warm-up, also fails early on errors
+            operation();
+
+            long long operations = 0;
+            AllocationTracking::Scope allocations;
+            Timer timer;
+
+            do
+            {
+                operation();
+                ++operations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            const double seconds = timer.GetElapsedSeconds();
+
+            const AllocationTracking::Statistics heap = allocations.Get(AllocationTracking::Source_Heap);
+            const AllocationTracking::Statistics pugixml = allocations.Get(AllocationTracking::Source_Pugixml);
+            const AllocationTracking::Statistics arena = allocations.Get(AllocationTracking::Source_Arena);
+
+            Result result("config", name);
+            result.Add("ns_per_op", seconds * 1e9 / operations)
+                  .Add("allocs_per_op", static_cast<double>(heap.count) / operations)
+                  .Add("bytes_per_op", static_cast<double>(heap.bytes) / operations)
+                  .Add("peak_bytes", static_cast<double>(heap.peakBytes))
+                  .Add("pugixml_allocs_per_op", static_cast<double>(pugixml.count) / operations)
+                  .Add("pugixml_bytes_per_op", static_cast<double>(pugixml.bytes) / operations)
+                  .Add("pugixml_peak_bytes", static_cast<double>(pugixml.peakBytes))
+                  .Add("arena_allocs_per_op", static_cast<double>(arena.count) / operations)
+                  .Add("arena_bytes_per_op", static_cast<double>(arena.bytes) / operations)
+                  .Add("arena_peak_bytes", static_cast<double>(arena.peakBytes));
+
+            if (inputBytes > 0)
+            {
+                result.Add("input_bytes", inputBytes);
+            }
+
+            result.Print();
+        }
+
+    private:
+        std::string name;
+        double minimumSeconds;
+    };
+
+    class ReadOperation
+    {
+    public:
+        ReadOperation(const MetaString & fileName)
+            : reader(fileName)
+        {
+
+        }
+
+        void operator()()
+        {
+            values = reader.GetValues();
+        }
+
+        GDIPPConfiguration::Reader reader;
+        GDIPPConfiguration::Values values;
+    };
+
+    class SaveOperation
+    {
+    public:
+        SaveOperation(const MetaString & fileName, const GDIPPConfiguration::Values & values)
+            : writer(fileName),
+              values(values)
+        {
+
+        }
+
+        void operator()()
+        {
+            writer.Save(values);
+        }
+
+        GDIPPConfiguration::Writer writer;
+        GDIPPConfiguration::Values values;
+    };
+
+    class ValidateOperation
+    {
+    public:
+        ValidateOperation(const GDIPPConfiguration::Values & values)
+            : values(values),
+              incorrect(0)
+        {
+
+        }
+
+        void operator()()
+        {
+            incorrect += values.Validate().GetStatus() ? 0 : 1;
+        }
+
+        GDIPPConfiguration::Values values;
+        int incorrect;
+    };
+
+    class IntFromStrOperation
+    {
+    public:
+        IntFromStrOperation()
+            : sum(0)
+        {
+            inputs.push_back(TEXT("0"));
+            inputs.push_back(TEXT("1"));
+            inputs.push_back(TEXT("-1000"));
+            inputs.push_back(TEXT("2147483647"));
+            inputs.push_back(TEXT("1.8"));
+            inputs.push_back(TEXT("not a number"));
+        }
+
+        void operator()()
+        {
+            for (size_t i = 0; i < inputs.size(); ++i)
+            {
+                // wraps around, 2147483647 overflows an int sum
+                sum += static_cast<unsigned int>(Util::TryIntFromStr(inputs[i], 0));
+            }
+        }
+
+        std::vector<MetaString> inputs;
+        unsigned int sum;
+    };
+
+    class IntToStrOperation
+    {
+    public:
+        IntToStrOperation()
+            : length(0)
+        {
+
+        }
+
+        void operator()()
+        {
+            static const int inputs[] = { 0, 1, -1000, 2147483647, INT_MIN, 42 };
+
+            for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i)
+            {
+                length += Util::IntToStr(inputs[i]).length();
+            }
+        }
+
+        size_t length;
+    };
+
+    template <typename Input>
+    class CreateMetaStringOperation
+    {
+    public:
+        CreateMetaStringOperation(const Input & input)
+            : input(input),
+              length(0)
+        {
+
+        }
+
+        void operator()()
+        {
+            length += Util::CreateMetaString(input).length();
+        }
+
+        Input input;
+        size_t length;
+    };
+
+    void RunConfigBenchmark(const Options & options)
+    {
+        /*
+        *   The configuration core over generated files: a small one (the
+        *   defaults only), a typical one (a few overrides) and a
+        *   pathological one (thousands of overrides, megabytes); the
+        *   conversions per call of 6 inputs. Heap, pugixml and arena
+        *   allocations are counted per operation, arena=0 gives pugixml
+        *   documents malloc instead of the thread arena. The generator
+        *   options (seed=, comments=, whitespace=, encoding=) apply to all
+        *   three files.
+        */
+
+        Memory::EnableArenas(options.GetInt("arena", 1) != 0);
+
+        const double minimumSeconds = options.GetDouble("seconds", 0.5);
+        const std::string directory = options.Get("directory", ".");
+
+        const char * sizeNames[] = { "small", "typical", "pathological" };
+        const int overrideBlocks[] = { 0, 8, options.GetInt("overrides", 10000) };
+
+        GDIPPConfiguration::Values loaded;
+
+        for (int s = 0; s < 3; ++s)
+        {
+            GeneratorSettings settings = GetGeneratorSettings(options);
+            settings.overrideBlocks = overrideBlocks[s];
+
+            const GeneratedConfiguration configuration = GenerateConfiguration(settings);
+            const std::string & content = configuration.data;
+            const std::string fileName = directory + "/gdipp_benchmark_" + sizeNames[s] + ".xml";
+
+            WriteFile(fileName, content);
+
+            try
+            {
+                ReadOperation read(Util::CreateMetaString(fileName));
+                Measurement(std::string("read_") + sizeNames[s], minimumSeconds).Run(read, static_cast<double>(content.size()));
+
+                if (!EqualValues(read.values, configuration.expected))
+                {
+                    throw std::runtime_error("Reader returned other values than " + fileName + " was generated with.");
+                }
+
+                SaveOperation save(Util::CreateMetaString(fileName), read.values);
+                Measurement(std::string("save_") + sizeNames[s], minimumSeconds).Run(save, static_cast<double>(content.size()));
+
+                loaded = read.values;
+            }
+            catch (...)
+            {
+                remove(fileName.c_str());
+                throw;
+            }
+
+            remove(fileName.c_str());
+        }
+
+        ValidateOperation validateComplete(loaded);
+        Measurement("validate_complete", minimumSeconds).Run(validateComplete, 0);
+
+        // every value missing, one report line each
+        ValidateOperation validateEmpty((GDIPPConfiguration::Values()));
+        Measurement("validate_empty", minimumSeconds).Run(validateEmpty, 0);
+
+        IntFromStrOperation intFromStr;
+        Measurement("try_int_from_str", minimumSeconds).Run(intFromStr, 0);
+
+        IntToStrOperation intToStr;
+        Measurement("int_to_str", minimumSeconds).Run(intToStr, 0);
+
+        CreateMetaStringOperation<std::string> fromAnsi("Demo Text !@#$%^&*()_+{ } ( )");
+        Measurement("create_meta_string_ansi", minimumSeconds).Run(fromAnsi, 0);
+
+        CreateMetaStringOperation<std::wstring> fromUnicode(L"Demo Text !@#$%^&*()_+{ } ( )");
+        Measurement("create_meta_string_unicode", minimumSeconds).Run(fromUnicode, 0);
+    }
+} // namespace GDIPPBenchmark
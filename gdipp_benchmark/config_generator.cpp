@@ -0,0 +1,549 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "config_generator.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "../gdipp-conf-editor/util.h"
+#include "../gdipp-conf-editor/gdipp_configuration_reader.h"
+
+#include "benchmark.h"
+
+namespace GDIPPBenchmark
+{
+    ConfigurationEncoding ParseConfigurationEncoding(const std::string & name)
+    {
+        if (name == "utf-8")
+        {
+            return Encoding_Utf8;
+        }
+
+        if (name == "utf-8-bom")
+        {
+            return Encoding_Utf8Bom;
+        }
+
+        if (name == "utf-16le")
+        {
+            return Encoding_Utf16LE;
+        }
+
+        if (name == "utf-16be")
+        {
+            return Encoding_Utf16BE;
+        }
+
+        if (name == "latin1")
+        {
+            return Encoding_Latin1;
+        }
+
+        throw std::runtime_error("Unknown encoding: " + name);
+    }
+
+    GeneratorSettings::GeneratorSettings()
+        : seed(1),
+          overrideBlocks(0),
+          comments(false),
+          oddWhitespace(false),
+          encoding(Encoding_Utf8)
+    {
+
+    }
+
+    class ConfigurationGenerator
+    {
+        /*
+        *   Writes the document as UTF-16 text (every character is in the
+        *   BMP), encoded at the end. The random numbers come from xorshift,
+        *   so the output does not depend on the C library.
+        */
+
+    public:
+        ConfigurationGenerator(const GeneratorSettings & settings)
+            : settings(settings),
+              state(settings.seed ? settings.seed : 0x9E3779B9U),
+              depth(0)
+        {
+
+        }
+
+        GeneratedConfiguration Generate()
+        {
+            GeneratedConfiguration result;
+
+            Text(L"<?xml version=\"1.0\" encoding=\"");
+            Text(GetEncodingName());
+            Text(L"\"?>");
+            NewLine();
+            Comment();
+
+            Open(L"gdipp", L"");
+            Open(L"gdimm", L"");
+
+            // the defaults, the blocks Reader takes
+            Open(L"process", L"");
+            Open(L"freetype", L"");
+            result.expected.lcdFilter = GDIPPConfiguration::Values::LCDFilter(Util::IntToStr(LCDFilter()));
+            Element(L"lcd_filter", result.expected.lcdFilter());
+            Close(L"freetype");
+            Close(L"process");
+
+            Comment();
+            FontBlock(L"", result.expected);
+
+            for (int i = 0; i < settings.overrideBlocks; ++i)
+            {
+                Comment();
+
+                GDIPPConfiguration::Values unused;
+
+                if (Random(2) == 0)
+                {
+                    Open(L"process", Attribute(L"name", ProcessName()));
+                    Open(L"freetype", L"");
+                    Element(L"lcd_filter", LCDFilter());
+                    Close(L"freetype");
+                    Close(L"process");
+                }
+                else
+                {
+                    std::wstring attributes = Attribute(L"name", FontName());
+
+                    if (Random(3) == 0)
+                    {
+                        attributes += Attribute(L"weight", Number(Random(9) * 100 + 100));
+                    }
+
+                    if (Random(4) == 0)
+                    {
+                        attributes += Attribute(L"italic", Number(Random(2)));
+                    }
+
+                    if (Random(4) == 0)
+                    {
+                        attributes += Attribute(L"max_height", Number(Random(64) + 8));
+                    }
+
+                    FontBlock(attributes, unused);
+                }
+            }
+
+            Close(L"gdimm");
+
+            Open(L"exclude", L"");
+
+            for (int i = 0; i < 3; ++i)
+            {
+                Element(L"process", ProcessName());
+            }
+
+            Close(L"exclude");
+            Close(L"gdipp");
+
+            result.data = Encode();
+
+            return result;
+        }
+
+    private:
+        const GeneratorSettings & settings;
+        unsigned int state;
+        int depth;
+        std::wstring text;
+
+        unsigned int Random(unsigned int range)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            return state % range;
+        }
+
+        const wchar_t * GetEncodingName() const
+        {
+            switch (settings.encoding)
+            {
+            case Encoding_Utf16LE:
+            case Encoding_Utf16BE:
+                return L"utf-16";
+            case Encoding_Latin1:
+                return L"ISO-8859-1";
+            default:
+                return L"utf-8";
+            }
+        }
+
+        static std::wstring Number(int value)
+        {
+            return Util::MetaStringToUnicode(Util::IntToStr(value));
+        }
+
+        void Text(const std::wstring & value)
+        {
+            text += value;
+        }
+
+        void NewLine()
+        {
+            if (settings.oddWhitespace)
+            {
+                text += Random(3) == 0 ? L"\r\n" : L"\n";
+
+                if (Random(8) == 0)
+                {
+                    text += L"  \t\n";
+                }
+            }
+            else
+            {
+                text += L"\n";
+            }
+        }
+
+        void Indent()
+        {
+            for (int i = 0; i < depth; ++i)
+            {
+                text += settings.oddWhitespace && Random(3) == 0 ? L"\t" : L"  ";
+            }
+        }
+
+        // optional spaces before the end of a tag
+        std::wstring TagEnd()
+        {
+            if (settings.oddWhitespace && Random(4) == 0)
+            {
+                return Random(2) ? L" >" : L"\t >";
+            }
+
+            return L">";
+        }
+
+        std::wstring Attribute(const std::wstring & name, const std::wstring & value)
+        {
+            if (settings.oddWhitespace && Random(3) == 0)
+            {
+                return L" " + name + L" = \'" + value + L"\'";
+            }
+
+            return L" " + name + L"=\"" + value + L"\"";
+        }
+
+        void Open(const std::wstring & name, const std::wstring & attributes)
+        {
+            Indent();
+            text += L"<" + name + attributes + TagEnd();
+            NewLine();
+            ++depth;
+        }
+
+        void Close(const std::wstring & name)
+        {
+            --depth;
+            Indent();
+
+            text += L"</" + name + TagEnd();
+            NewLine();
+        }
+
+        void Element(const std::wstring & name, const std::wstring & value)
+        {
+            Indent();
+            text += L"<" + name + TagEnd() + value + L"</" + name + TagEnd();
+            NewLine();
+        }
+
+        void Element(const std::wstring & name, int value)
+        {
+            Element(name, Number(value));
+        }
+
+        void Comment()
+        {
+            static const wchar_t * comments[] =
+            {
+                L" gdipp settings, see the documentation ",
+                L" override for a single application ",
+                L"\u00A0non-breaking space & <markup> in a comment ",
+                L" disabled: <font name=\"Tahoma\"><hinting>0</hinting></font> "
+            };
+
+            if (settings.comments && Random(2) == 0)
+            {
+                Indent();
+                text += L"<!--";
+                text += comments[Random(sizeof(comments) / sizeof(comments[0]))];
+                text += L"-->";
+                NewLine();
+            }
+        }
+
+        int LCDFilter()
+        {
+            static const int filters[] = { 0, 1, 2, 16 };
+            return filters[Random(4)];
+        }
+
+        std::wstring ProcessName()
+        {
+            static const wchar_t * names[] =
+            {
+                L"explorer", L"firefox", L"thunderbird", L"devenv", L"notepad++", L"putty"
+            };
+
+            return names[Random(sizeof(names) / sizeof(names[0]))] + Number(Random(10000)) + L".exe";
+        }
+
+        std::wstring FontName()
+        {
+            // Latin-1 files can only hold the first ones
+            static const wchar_t * names[] =
+            {
+                L"Arial", L"Segoe UI", L"Tahoma", L"Courier New", L"Caf\u00E9 Sans",
+                L"Meiryo \u30E1\u30A4\u30EA\u30AA", L"\u5FAE\u8F6F\u96C5\u9ED1", L"\u0413\u0430\u0440\u043D\u0438\u0442\u0443\u0440\u0430"
+            };
+
+            const unsigned int count = settings.encoding == Encoding_Latin1 ? 5 : sizeof(names) / sizeof(names[0]);
+
+            return names[Random(count)] + std::wstring(L" ") + Number(Random(1000));
+        }
+
+        std::wstring Gamma()
+        {
+            return Number(1 + Random(2)) + L"." + Number(Random(10));
+        }
+
+        void FontBlock(const std::wstring & attributes, GDIPPConfiguration::Values & values)
+        {
+            typedef GDIPPConfiguration::Values Values;
+
+            Open(L"font", attributes);
+
+            values.autoHintingMode = Values::AutoHintingMode(Util::IntToStr(Random(3)));
+            Element(L"auto_hinting", values.autoHintingMode());
+
+            values.embeddedBitmap = Random(2);
+            Element(L"embedded_bitmap", values.embeddedBitmap);
+
+            values.embolden = Random(4) == 0 ? Random(64) : 0;
+            Element(L"embolden", values.embolden);
+
+            Comment();
+
+            const std::wstring red = Gamma();
+            const std::wstring green = Gamma();
+            const std::wstring blue = Gamma();
+
+            values.gamma = Values::Gamma(Util::CreateMetaString(red), Util::CreateMetaString(green), Util::CreateMetaString(blue));
+
+            Open(L"gamma", L"");
+            Element(L"red", red);
+            Element(L"green", green);
+            Element(L"blue", blue);
+            Close(L"gamma");
+
+            values.hinting = Random(4);
+            Element(L"hinting", values.hinting);
+
+            values.kerning = Random(2);
+            Element(L"kerning", values.kerning);
+
+            const int mono = Random(3);
+            const int gray = Random(3);
+            const int subpixel = Random(3);
+
+            values.renderMode = Values::RenderMode(Util::IntToStr(mono), Util::IntToStr(gray), Util::IntToStr(subpixel));
+            values.pixelGeometry = Values::PixelGeometry(Util::IntToStr(Random(2)));
+            values.aliasedText = Random(2);
+
+            Open(L"render_mode", L"");
+            Element(L"mono", mono);
+            Element(L"gray", gray);
+            Element(L"subpixel", subpixel);
+            Element(L"pixel_geometry", values.pixelGeometry());
+            Element(L"aliased_text", values.aliasedText);
+            Close(L"render_mode");
+
+            values.renderer = Random(4);
+            Element(L"renderer", values.renderer);
+
+            values.shadow = Values::Shadow(static_cast<int>(Random(7)) - 3, static_cast<int>(Random(7)) - 3, Random(256));
+
+            Open(L"shadow", L"");
+            Element(L"offset_x", values.shadow.GetOffsetX());
+            Element(L"offset_y", values.shadow.GetOffsetY());
+            Element(L"alpha", values.shadow.GetAlpha());
+            Close(L"shadow");
+
+            Close(L"font");
+        }
+
+        std::string Encode() const
+        {
+            std::string data;
+            data.reserve(text.length() * 2 + 3);
+
+            if (settings.encoding == Encoding_Utf8Bom)
+            {
+                data += "\xEF\xBB\xBF";
+            }
+            else if (settings.encoding == Encoding_Utf16LE)
+            {
+                data += "\xFF\xFE";
+            }
+            else if (settings.encoding == Encoding_Utf16BE)
+            {
+                data += "\xFE\xFF";
+            }
+
+            for (size_t i = 0; i < text.length(); ++i)
+            {
+                const unsigned int character = static_cast<unsigned int>(text[i]) & 0xFFFF;
+
+                switch (settings.encoding)
+                {
+                case Encoding_Utf16LE:
+                    data += static_cast<char>(character & 0xFF);
+                    data += static_cast<char>(character >> 8);
+                    break;
+                case Encoding_Utf16BE:
+                    data += static_cast<char>(character >> 8);
+                    data += static_cast<char>(character & 0xFF);
+                    break;
+                case Encoding_Latin1:
+                    data += static_cast<char>(character);
+                    break;
+                default:
+                    if (character < 0x80)
+                    {
+                        data += static_cast<char>(character);
+                    }
+                    else if (character < 0x800)
+                    {
+                        data += static_cast<char>(0xC0 | (character >> 6));
+                        data += static_cast<char>(0x80 | (character & 0x3F));
+                    }
+                    else
+                    {
+                        data += static_cast<char>(0xE0 | (character >> 12));
+                        data += static_cast<char>(0x80 | ((character >> 6) & 0x3F));
+                        data += static_cast<char>(0x80 | (character & 0x3F));
+                    }
+                    break;
+                }
+            }
+
+            return data;
+        }
+
+        ConfigurationGenerator(const ConfigurationGenerator &);
+        ConfigurationGenerator & operator=(const ConfigurationGenerator &);
+    };
+
+    GeneratedConfiguration GenerateConfiguration(const GeneratorSettings & settings)
+    {
+        return ConfigurationGenerator(settings).Generate();
+    }
+
+    bool EqualValues(const GDIPPConfiguration::Values & left, const GDIPPConfiguration::Values & right)
+    {
+        return left.autoHintingMode() == right.autoHintingMode()
+            && left.embeddedBitmap == right.embeddedBitmap
+            && left.embolden == right.embolden
+            && left.lcdFilter() == right.lcdFilter()
+            && left.gamma.GetR() == right.gamma.GetR()
+            && left.gamma.GetG() == right.gamma.GetG()
+            && left.gamma.GetB() == right.gamma.GetB()
+            && left.hinting == right.hinting
+            && left.kerning == right.kerning
+            && left.renderMode.GetMonoMode() == right.renderMode.GetMonoMode()
+            && left.renderMode.GetGrayMode() == right.renderMode.GetGrayMode()
+            && left.renderMode.GetSubpixelMode() == right.renderMode.GetSubpixelMode()
+            && left.renderer == right.renderer
+            && left.pixelGeometry() == right.pixelGeometry()
+            && left.shadow.GetOffsetX() == right.shadow.GetOffsetX()
+            && left.shadow.GetOffsetY() == right.shadow.GetOffsetY()
+            && left.shadow.GetAlpha() == right.shadow.GetAlpha()
+            && left.aliasedText == right.aliasedText;
+    }
+
+    GeneratorSettings GetGeneratorSettings(const Options & options)
+    {
+        GeneratorSettings settings;
+
+        settings.seed = static_cast<unsigned int>(options.GetInt("seed", 1));
+        settings.overrideBlocks = options.GetInt("overrides", 0);
+        settings.comments = options.GetInt("comments", 0) != 0;
+        settings.oddWhitespace = options.Get("whitespace", "plain") == "odd";
+        settings.encoding = ParseConfigurationEncoding(options.Get("encoding", "utf-8"));
+
+        return settings;
+    }
+
+    void RunConfigurationGenerator(const Options & options)
+    {
+        /*
+        *   generate=<file>|- [seed=1] [overrides=0] [comments=0|1]
+        *   [whitespace=plain|odd] [encoding=utf-8] - writes one synthetic
+        *   gdipp_setting.xml. A file is read back with Reader and checked
+        *   against the values it was generated from.
+        */
+
+        const std::string fileName = options.Get("generate", "-");
+        const GeneratedConfiguration configuration = GenerateConfiguration(GetGeneratorSettings(options));
+
+        if (fileName == "-")
+        {
+            std::cout.write(configuration.data.data(), static_cast<std::streamsize>(configuration.data.size()));
+            std::cout.flush();
+            return;
+        }
+
+        {
+            std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+            file.write(configuration.data.data(), static_cast<std::streamsize>(configuration.data.size()));
+
+            if (!file)
+            {
+                throw std::runtime_error("Unable to write " + fileName);
+            }
+        }
+
+        const GDIPPConfiguration::Values values = GDIPPConfiguration::Reader(Util::CreateMetaString(fileName)).GetValues();
+
+        if (!EqualValues(values, configuration.expected))
+        {
+            throw std::runtime_error("Reader returned other values than " + fileName + " was generated with.");
+        }
+
+        Result("generate", fileName)
+            .Add("bytes", static_cast<double>(configuration.data.size()))
+            .Add("verified", "yes")
+            .Print();
+    }
+} // namespace GDIPPBenchmark
@@ -0,0 +1,85 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+
+#include "benchmark.h"
+
+namespace GDIPPBenchmark
+{
+    enum ConfigurationEncoding
+    {
+        Encoding_Utf8 = 0,
+        Encoding_Utf8Bom,
+        Encoding_Utf16LE,
+        Encoding_Utf16BE,
+        Encoding_Latin1
+    };
+
+    // "utf-8", "utf-8-bom", "utf-16le", "utf-16be" or "latin1"
+    extern ConfigurationEncoding ParseConfigurationEncoding(const std::string & name);
+
+    class GeneratorSettings
+    {
+    public:
+        GeneratorSettings();
+
+        // the same settings always give the same file
+        unsigned int seed;
+
+        // process and font override blocks after the defaults
+        int overrideBlocks;
+
+        // comments between and inside the blocks
+        bool comments;
+
+        // tabs, CRLF line ends, blank lines and spaces inside tags
+        bool oddWhitespace;
+
+        ConfigurationEncoding encoding;
+    };
+
+    class GeneratedConfiguration
+    {
+    public:
+        // the file contents, in the chosen encoding
+        std::string data;
+
+        // what Reader has to read from it
+        GDIPPConfiguration::Values expected;
+    };
+
+    // A valid gdipp_setting.xml in the layout Reader expects: defaults in
+    // the first gdipp/gdimm/process/freetype and gdipp/gdimm/font, then
+    // randomized process and font overrides, then an exclude list.
+    extern GeneratedConfiguration GenerateConfiguration(const GeneratorSettings & settings);
+
+    // every field Reader sets
+    extern bool EqualValues(const GDIPPConfiguration::Values & left, const GDIPPConfiguration::Values & right);
+
+    // seed=, overrides=, comments=0|1, whitespace=plain|odd, encoding=
+    extern GeneratorSettings GetGeneratorSettings(const Options & options);
+}
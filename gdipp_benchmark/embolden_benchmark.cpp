@@ -0,0 +1,86 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <cstdlib>
+
+#include "../gdipp_preview_renderer/coverage_bitmap.h"
+#include "../gdipp_preview_renderer/embolden.h"
+#include "../gdipp_preview_renderer/simd.h"
+
+namespace GDIPPBenchmark
+{
+    void RunEmboldenBenchmark(const Options & options)
+    {
+        /*
+        *   Emboldens and thins a 3x oversampled sheet, the time per sheet
+        *   should not depend on the strength.
+        */
+
+        const int width = options.GetInt("width", 2048);
+        const int height = options.GetInt("height", 1024);
+        const double minimumSeconds = options.GetDouble("seconds", 0.5);
+
+        GDIPPRenderer::CoverageBitmap source(width * 3, height);
+
+        srand(1);
+
+        for (int y = 0; y < height; ++y)
+        {
+            unsigned char * row = source.GetRow(y);
+
+            for (int x = 0; x < width * 3; ++x)
+            {
+                row[x] = ((x / 9 + y / 12) % 3 == 0) ? 0xFF : static_cast<unsigned char>(rand() & 0x3F);
+            }
+        }
+
+        const int strengths[] = { 32, 64, 256, 1000, -64, -1000 };
+
+        for (int i = 0; i < 6; ++i)
+        {
+            GDIPPRenderer::CoverageBitmap coverage;
+            int iterations = 0;
+            Timer timer;
+
+            do
+            {
+                coverage = source;
+                GDIPPRenderer::Embolden(coverage, strengths[i], 3);
+                ++iterations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            const double seconds = timer.GetElapsedSeconds();
+
+            Result("embolden", strengths[i] > 0 ? "dilate" : "erode")
+                .Add("simd", GDIPPRenderer::GetSimdLevelName())
+                .Add("strength", strengths[i])
+                .Add("width", width)
+                .Add("height", height)
+                .Add("iterations", iterations)
+                .Add("ms_per_sheet", seconds * 1e3 / iterations)
+                .Print();
+        }
+    }
+} // namespace GDIPPBenchmark
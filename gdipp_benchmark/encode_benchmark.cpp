@@ -0,0 +1,180 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../gdipp_preview_renderer/software_renderer.h"
+#include "../gdipp_preview_renderer/image_writer.h"
+#include "../gdipp_preview_renderer/deflate_stream.h"
+#include "../gdipp_preview_renderer/inflate_stream.h"
+
+namespace GDIPPBenchmark
+{
+    static GDIPPRenderer::ImageWriter * CreateWriter(const std::string & name, std::ostream & stream)
+    {
+        if (name == "raw")
+        {
+            return new GDIPPRenderer::RawImageWriter(stream);
+        }
+
+        if (name == "bmp")
+        {
+            return new GDIPPRenderer::BmpImageWriter(stream);
+        }
+
+        return new GDIPPRenderer::PngImageWriter(stream, name == "png_fast");
+    }
+
+    // compresses data in pieces of the given size and inflates it back,
+    // throws std::runtime_error when the result differs
+    static size_t CheckDeflateRoundTrip(const std::vector<unsigned char> & data, bool compress, size_t pieceSize)
+    {
+        std::vector<unsigned char> compressed;
+        GDIPPRenderer::DeflateStream deflate(compressed, compress);
+
+        for (size_t position = 0; position < data.size(); position += pieceSize)
+        {
+            deflate.Write(&data[position], std::min(pieceSize, data.size() - position));
+        }
+
+        deflate.Finish();
+
+        std::vector<unsigned char> inflated;
+        GDIPPRenderer::Inflate(&compressed[0], compressed.size(), inflated);
+
+        if (inflated != data)
+        {
+            throw std::runtime_error("DeflateStream output does not inflate to its input.");
+        }
+
+        return compressed.size();
+    }
+
+    static void RunDeflateRoundTrip(const GDIPPRenderer::RenderedImage & image)
+    {
+        /*
+        *   Noise fills whole blocks, which are then stored. A match ending
+        *   a block right before Finish codes the trailing literals makes
+        *   the largest block there is; seeds vary the bytes so that some
+        *   blocks are stored and some are not.
+        */
+
+        std::vector<std::vector<unsigned char> > inputs;
+        inputs.push_back(std::vector<unsigned char>(image.GetRow(0), image.GetRow(0) + image.GetStride() * image.GetHeight()));
+
+        srand(1);
+
+        for (int seed = 0; seed < 16; ++seed)
+        {
+            std::vector<unsigned char> data(65276 + 258 + 2);
+
+            for (size_t i = 0; i < data.size(); ++i)
+            {
+                data[i] = static_cast<unsigned char>(rand() & 0xFF);
+            }
+
+            // a repeat of earlier bytes within the window
+            std::copy(data.begin() + 40000, data.begin() + 40000 + 258, data.begin() + 65276);
+            inputs.push_back(data);
+        }
+
+        std::vector<unsigned char> noise(300000);
+
+        for (size_t i = 0; i < noise.size(); ++i)
+        {
+            noise[i] = static_cast<unsigned char>(rand() & 0xFF);
+        }
+
+        inputs.push_back(noise);
+
+        int checks = 0;
+
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            for (int compress = 0; compress < 2; ++compress)
+            {
+                CheckDeflateRoundTrip(inputs[i], compress != 0, inputs[i].size());
+                CheckDeflateRoundTrip(inputs[i], compress != 0, 4093);
+                checks += 2;
+            }
+        }
+
+        Result("encode", "deflate_round_trip")
+            .Add("checks", checks)
+            .Add("match", 1)
+            .Print();
+    }
+
+    void RunEncodeBenchmark(const Options & options)
+    {
+        /*
+        *   Encoding the rendered paragraph sheet into memory with every
+        *   built-in image format. The deflate round trip is checked first,
+        *   a mismatch throws.
+        */
+
+        const double minimumSeconds = options.GetDouble("seconds", 0.5);
+
+        GDIPPRenderer::SoftwareRenderer renderer;
+        const GDIPPRenderer::RenderedImage & image = renderer.Render(CreateParagraphRequest(options), CreateBenchmarkValues());
+
+        RunDeflateRoundTrip(image);
+
+        const double megabytes = static_cast<double>(image.GetWidth()) * image.GetHeight() * 4 / (1024.0 * 1024.0);
+        const char * formats[] = { "raw", "bmp", "png_store", "png_fast" };
+
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+        {
+            size_t bytes = 0;
+            int iterations = 0;
+            Timer timer;
+
+            do
+            {
+                std::ostringstream stream;
+                GDIPPRenderer::ImageWriter * writer = CreateWriter(formats[f], stream);
+
+                GDIPPRenderer::WriteImage(* writer, image);
+                delete writer;
+
+                bytes = stream.str().size();
+                ++iterations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            const double seconds = timer.GetElapsedSeconds() / iterations;
+
+            Result("encode", formats[f])
+                .Add("width", image.GetWidth())
+                .Add("height", image.GetHeight())
+                .Add("ms", seconds * 1e3)
+                .Add("mb_per_s", megabytes / seconds)
+                .Add("bytes", static_cast<double>(bytes))
+                .Print();
+        }
+    }
+} // namespace GDIPPBenchmark
@@ -0,0 +1,103 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <cstdlib>
+
+#include "../gdipp_preview_renderer/coverage_bitmap.h"
+#include "../gdipp_preview_renderer/gamma_table.h"
+
+namespace GDIPPBenchmark
+{
+    void RunGammaBenchmark(const Options & options)
+    {
+        /*
+        *   Measures what a gamma change costs in the preview: building the
+        *   per-channel tables and applying them to a sheet of channels.
+        */
+
+        const int width = options.GetInt("width", 2048);
+        const int height = options.GetInt("height", 1024);
+        const double minimumSeconds = options.GetDouble("seconds", 0.5);
+
+        GDIPPRenderer::CoverageBitmap source(width * 3, height);
+        GDIPPRenderer::CoverageBitmap destination;
+
+        srand(1);
+
+        for (int y = 0; y < height; ++y)
+        {
+            unsigned char * row = source.GetRow(y);
+
+            for (int x = 0; x < width * 3; ++x)
+            {
+                row[x] = static_cast<unsigned char>(rand() & 0xFF);
+            }
+        }
+
+        // table rebuild
+        {
+            GDIPPRenderer::GammaTable table;
+            int iterations = 0;
+            Timer timer;
+
+            do
+            {
+                table.Build(1.0 + (iterations & 7) * 0.1, 1.2, 1.4);
+                ++iterations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            Result("gamma", "build")
+                .Add("iterations", iterations)
+                .Add("us_per_build", timer.GetElapsedSeconds() * 1e6 / iterations)
+                .Print();
+        }
+
+        // table application
+        {
+            GDIPPRenderer::GammaTable table;
+            table.Build(1.4, 1.2, 1.0);
+
+            int iterations = 0;
+            Timer timer;
+
+            do
+            {
+                table.Apply(source, destination);
+                ++iterations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            const double seconds = timer.GetElapsedSeconds();
+            const double megapixels = static_cast<double>(width) * height * iterations / 1e6;
+
+            Result("gamma", "apply")
+                .Add("width", width)
+                .Add("height", height)
+                .Add("iterations", iterations)
+                .Add("mpixels_per_second", megapixels / seconds)
+                .Print();
+        }
+    }
+} // namespace GDIPPBenchmark
@@ -0,0 +1,303 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "../gdipp-conf-editor/util.h"
+#include "../gdipp_preview_renderer/parameter_sweep.h"
+#include "../gdipp_preview_renderer/thread_pool.h"
+#include "../gdipp_preview_renderer/image_writer.h"
+#include "../gdipp_preview_renderer/image_compare.h"
+
+// the checked-in goldens and the font they are rendered with; CMake defines
+// the absolute path, the msvc2010 project runs in gdipp_benchmark
+#if !defined(GDIPP_GOLDEN_DIRECTORY)
+#define GDIPP_GOLDEN_DIRECTORY "golden"
+#endif
+
+namespace GDIPPBenchmark
+{
+    // hinting, embolden, LCD filter, pixel geometry and gamma, every image
+    // has the mono, gray and subpixel modes of CreateBenchmarkValues
+    static const char * const DefaultGoldenAxes =
+        "hinting=0,1,2;embolden=0,32;lcd_filter=0,1,16;render_mode/pixel_geometry=0,1;gamma=1.0,1.8";
+
+    // a freely licensed font, the same on every platform
+    static const char * const GoldenFontFileName = GDIPP_GOLDEN_DIRECTORY "/DejaVuSerif.ttf";
+
+    class GoldenTolerances
+    {
+    public:
+        double minimumSsim;
+        double minimumPsnr;
+        int maximumDelta;
+    };
+
+    // "hinting=1 render_mode/pixel_geometry=0" -> "hinting-1_render_mode-pixel_geometry-0"
+    static std::string GetGoldenName(const MetaString & label)
+    {
+        std::string name = Util::MetaStringToAnsi(label);
+
+        for (size_t i = 0; i < name.length(); ++i)
+        {
+            if (name[i] == ' ')
+            {
+                name[i] = '_';
+            }
+            else if (name[i] == '=' || name[i] == '/' || name[i] == '\\')
+            {
+                name[i] = '-';
+            }
+        }
+
+        return name;
+    }
+
+    static bool FileExists(const std::string & fileName)
+    {
+        std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+        return file.good();
+    }
+
+    class GoldenCase
+    {
+    public:
+        GoldenCase()
+            : passed(false)
+        {
+
+        }
+
+        std::string name;
+        std::string status;
+        GDIPPRenderer::ImageComparison comparison;
+        bool passed;
+    };
+
+    // the image at the top left of a bigger one, filled with the color
+    static GDIPPRenderer::RenderedImage PadImage(const GDIPPRenderer::RenderedImage & image,
+                                                 int width,
+                                                 int height,
+                                                 unsigned int color)
+    {
+        GDIPPRenderer::RenderedImage padded(width, height, color);
+        padded.Draw(image, 0, 0);
+
+        return padded;
+    }
+
+    class GoldenCompareTask : public GDIPPRenderer::ParallelTask
+    {
+    public:
+        GoldenCompareTask(const std::vector<GDIPPRenderer::RenderedImage> & images,
+                          const std::string & goldenDirectory,
+                          const std::string & outputDirectory,
+                          const GoldenTolerances & tolerances,
+                          unsigned int background,
+                          bool update,
+                          std::vector<GoldenCase> & cases)
+            : images(images),
+              goldenDirectory(goldenDirectory),
+              outputDirectory(outputDirectory),
+              tolerances(tolerances),
+              background(background),
+              update(update),
+              cases(cases)
+        {
+
+        }
+
+        virtual void Run(int index, int)
+        {
+            GoldenCase & golden = cases[index];
+            const std::string goldenFileName = goldenDirectory + "/" + golden.name + ".png";
+
+            if (update)
+            {
+                GDIPPRenderer::SaveImage(images[index], Util::CreateMetaString(goldenFileName));
+                golden.status = "updated";
+                golden.passed = true;
+                return;
+            }
+
+            if (!FileExists(goldenFileName))
+            {
+                golden.status = "missing";
+                return;
+            }
+
+            GDIPPRenderer::RenderedImage expected;
+
+            try
+            {
+                expected = GDIPPRenderer::LoadImageFile(Util::CreateMetaString(goldenFileName));
+            }
+            catch (const std::exception &)
+            {
+                golden.status = "unreadable";
+                return;
+            }
+
+            if (expected.GetWidth() != images[index].GetWidth() || expected.GetHeight() != images[index].GetHeight())
+            {
+                /*
+                *   Compared on the larger size, the area only one of them
+                *   covers padded with the inverted background so it shows
+                *   up in the heatmap as a full difference.
+                */
+                const int width = std::max(expected.GetWidth(), images[index].GetWidth());
+                const int height = std::max(expected.GetHeight(), images[index].GetHeight());
+                const GDIPPRenderer::RenderedImage paddedExpected = PadImage(expected, width, height, background ^ 0xFFFFFF);
+                const GDIPPRenderer::RenderedImage paddedActual = PadImage(images[index], width, height, background ^ 0xFFFFFF);
+
+                golden.comparison = GDIPPRenderer::CompareImages(paddedExpected, paddedActual);
+                golden.status = "size";
+
+                GDIPPRenderer::SaveImage(GDIPPRenderer::CreateDifferenceHeatmap(paddedExpected, paddedActual),
+                                         Util::CreateMetaString(outputDirectory + "/" + golden.name + ".diff.png"));
+                return;
+            }
+
+            golden.comparison = GDIPPRenderer::CompareImages(expected, images[index]);
+            golden.passed = golden.comparison.ssim >= tolerances.minimumSsim &&
+                            golden.comparison.psnr >= tolerances.minimumPsnr &&
+                            golden.comparison.maxDelta <= tolerances.maximumDelta;
+            golden.status = golden.passed ? "pass" : "fail";
+
+            if (!golden.passed)
+            {
+                GDIPPRenderer::SaveImage(GDIPPRenderer::CreateDifferenceHeatmap(expected, images[index]),
+                                         Util::CreateMetaString(outputDirectory + "/" + golden.name + ".diff.png"));
+            }
+        }
+
+    private:
+        const std::vector<GDIPPRenderer::RenderedImage> & images;
+        const std::string & goldenDirectory;
+        const std::string & outputDirectory;
+        const GoldenTolerances & tolerances;
+        unsigned int background;
+        bool update;
+        std::vector<GoldenCase> & cases;
+    };
+
+    int RunGoldenImages(const Options & options)
+    {
+        /*
+        *   [golden=<directory>] [--update] [output=<directory>] [axes=...]
+        *   [min_ssim=0.995] [min_psnr=40] [max_delta=32] [threads=0]
+        *   [font=<ttf file>] - renders a fixed matrix of Values with the
+        *   portable renderer and compares every image with its golden
+        *   <directory>/<variant>.png. The directory defaults to the
+        *   checked-in goldens, the font to the DejaVu Serif they were
+        *   rendered with. A failing variant, or one of another size than
+        *   its golden, writes a heatmap of the difference to
+        *   <output>/<variant>.diff.png, the current directory by default. --update writes the goldens instead. Returns the
+        *   number of variants that failed, have no golden or an unreadable
+        *   one.
+        */
+
+        const std::string goldenDirectory = options.Get("golden", GDIPP_GOLDEN_DIRECTORY);
+        const std::string outputDirectory = options.Get("output", ".");
+        const bool update = !options.Get("--update", "").empty();
+        const int threads = options.GetInt("threads", GDIPPRenderer::ThreadPool::GetProcessorCount());
+
+        GoldenTolerances tolerances;
+        tolerances.minimumSsim = options.GetDouble("min_ssim", 0.995);
+        tolerances.minimumPsnr = options.GetDouble("min_psnr", 40.0);
+        tolerances.maximumDelta = options.GetInt("max_delta", 32);
+
+        // a small sheet, the matrix has many variants and the goldens are
+        // checked in; kerned pairs, digits and punctuation at text sizes
+        GDIPPRenderer::PreviewRequest request;
+        request.fontFileName = Util::CreateMetaString(options.Get("font", GoldenFontFileName));
+        request.lines.clear();
+        request.lines.push_back(L"The quick brown fox jumps over the lazy dog.");
+        request.lines.push_back(L"AVATAR To Wave, 0123456789 {[(<>)]} @&%");
+        request.margin = 8;
+        request.pixelSizes.clear();
+        request.pixelSizes.push_back(9);
+        request.pixelSizes.push_back(12);
+        request.pixelSizes.push_back(16);
+
+        GDIPPRenderer::ParameterSweep sweep(CreateBenchmarkValues(),
+                                            GDIPPRenderer::ParseSweepAxes(Util::CreateMetaString(
+                                                options.Get("axes", DefaultGoldenAxes))));
+
+        const std::vector<GDIPPRenderer::SweepVariant> & variants = sweep.GetVariants();
+
+        Timer timer;
+        const std::vector<GDIPPRenderer::RenderedImage> images = sweep.RenderVariants(request, threads);
+        const double renderSeconds = timer.GetElapsedSeconds();
+
+        std::vector<GoldenCase> cases(variants.size());
+
+        for (size_t i = 0; i < variants.size(); ++i)
+        {
+            cases[i].name = GetGoldenName(variants[i].label);
+        }
+
+        timer.Restart();
+
+        {
+            GDIPPRenderer::ThreadPool pool(threads);
+            GoldenCompareTask task(images, goldenDirectory, outputDirectory, tolerances, request.background, update, cases);
+            pool.Run(task, static_cast<int>(cases.size()));
+        }
+
+        const double compareSeconds = timer.GetElapsedSeconds();
+        int failed = 0;
+
+        for (size_t i = 0; i < cases.size(); ++i)
+        {
+            Result result("golden", cases[i].name);
+            result.Add("status", cases[i].status);
+
+            if (cases[i].status == "pass" || cases[i].status == "fail" || cases[i].status == "size")
+            {
+                result.Add("ssim", cases[i].comparison.ssim)
+                      .Add("psnr", cases[i].comparison.psnr)
+                      .Add("max_delta", cases[i].comparison.maxDelta)
+                      .Add("different_pixels", static_cast<double>(cases[i].comparison.differentPixels));
+            }
+
+            result.Print();
+
+            failed += cases[i].passed ? 0 : 1;
+        }
+
+        Result("golden", "summary")
+            .Add("variants", static_cast<double>(cases.size()))
+            .Add("failed", failed)
+            .Add("threads", threads)
+            .Add("ms_render", renderSeconds * 1e3)
+            .Add("ms_compare", compareSeconds * 1e3)
+            .Print();
+
+        return failed;
+    }
+} // namespace GDIPPBenchmark
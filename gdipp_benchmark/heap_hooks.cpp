@@ -0,0 +1,145 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <new>
+#include <cstdlib>
+
+#include "../gdipp-conf-editor/allocation_tracking.h"
+
+/*
+*   gdipp-benchmark replaces the global allocation functions, every block
+*   carries its size in front, so AllocationTracking sees the heap traffic
+*   of the configuration core, including the peak.
+*/
+
+// dynamic exception specifications are deprecated in C++11 and an error
+// in C++17, later standards declare the same functions noexcept
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+    #define GDIPP_THROW_BAD_ALLOC
+    #define GDIPP_NO_THROW noexcept
+#else
+    #define GDIPP_THROW_BAD_ALLOC throw(std::bad_alloc)
+    #define GDIPP_NO_THROW throw()
+#endif
+
+namespace
+{
+    // keeps the alignment malloc gives
+    const size_t HeaderSize = 16;
+
+    void * Allocate(size_t size)
+    {
+        unsigned char * block = static_cast<unsigned char *>(malloc(size + HeaderSize));
+
+        if (block == NULL)
+        {
+            throw std::bad_alloc();
+        }
+
+        * reinterpret_cast<size_t *>(block) = size;
+        AllocationTracking::RecordAllocation(AllocationTracking::Source_Heap, size);
+
+        return block + HeaderSize;
+    }
+
+    void Deallocate(void * pointer)
+    {
+        if (pointer == NULL)
+        {
+            return;
+        }
+
+        unsigned char * block = static_cast<unsigned char *>(pointer) - HeaderSize;
+
+        AllocationTracking::RecordDeallocation(AllocationTracking::Source_Heap, * reinterpret_cast<size_t *>(block));
+        free(block);
+    }
+}
+
+void * operator new(size_t size) GDIPP_THROW_BAD_ALLOC
+{
+    return Allocate(size);
+}
+
+void * operator new[](size_t size) GDIPP_THROW_BAD_ALLOC
+{
+    return Allocate(size);
+}
+
+void * operator new(size_t size, const std::nothrow_t &) GDIPP_NO_THROW
+{
+    try
+    {
+        return Allocate(size);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return NULL;
+    }
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) GDIPP_NO_THROW
+{
+    try
+    {
+        return Allocate(size);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return NULL;
+    }
+}
+
+void operator delete(void * block) GDIPP_NO_THROW
+{
+    Deallocate(block);
+}
+
+void operator delete[](void * block) GDIPP_NO_THROW
+{
+    Deallocate(block);
+}
+
+void operator delete(void * block, const std::nothrow_t &) GDIPP_NO_THROW
+{
+    Deallocate(block);
+}
+
+void operator delete[](void * block, const std::nothrow_t &) GDIPP_NO_THROW
+{
+    Deallocate(block);
+}
+
+#if __cplusplus >= 201402L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+
+// C++14 deletes with the size, the block header already has it
+void operator delete(void * block, size_t) GDIPP_NO_THROW
+{
+    Deallocate(block);
+}
+
+void operator delete[](void * block, size_t) GDIPP_NO_THROW
+{
+    Deallocate(block);
+}
+
+#endif
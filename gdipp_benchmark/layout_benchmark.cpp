@@ -0,0 +1,108 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <vector>
+
+#include "../gdipp_preview_renderer/truetype_font.h"
+#include "../gdipp_preview_renderer/text_layout.h"
+#include "../gdipp_preview_renderer/render_mode.h"
+
+namespace GDIPPBenchmark
+{
+    void RunLayoutBenchmark(const Options & options)
+    {
+        /*
+        *   Kerning pair lookups over the glyph pairs of the paragraph sheet,
+        *   then the whole layout stage with kerning off and on.
+        */
+
+        const double minimumSeconds = options.GetDouble("seconds", 0.5);
+        const GDIPPRenderer::PreviewRequest request = CreateParagraphRequest(options);
+
+        GDIPPRenderer::TrueTypeFont font;
+        font.Load(request.fontFileName);
+
+        const GDIPPRenderer::KerningTable & kerning = font.GetKerningTable();
+
+        // pairs as they appear in the text
+        std::vector<unsigned int> glyphs;
+
+        for (size_t l = 0; l < request.lines.size(); ++l)
+        {
+            for (size_t c = 0; c < request.lines[l].length(); ++c)
+            {
+                glyphs.push_back(font.GetGlyphIndex(request.lines[l][c]));
+            }
+        }
+
+        {
+            long long lookups = 0;
+            int checksum = 0;
+            Timer timer;
+
+            do
+            {
+                checksum = 0;
+
+                for (size_t i = 1; i < glyphs.size(); ++i)
+                {
+                    checksum += kerning.GetAdjustment(glyphs[i - 1], glyphs[i]);
+                }
+
+                lookups += static_cast<long long>(glyphs.size() - 1);
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            Result("layout", "kerning_lookup")
+                .Add("pairs", static_cast<double>(kerning.GetPairCount()))
+                .Add("class_subtables", static_cast<double>(kerning.GetClassSubtableCount()))
+                .Add("ns_per_pair", timer.GetElapsedSeconds() * 1e9 / lookups)
+                .Add("checksum", checksum)
+                .Print();
+        }
+
+        for (int kerningEnabled = 0; kerningEnabled < 2; ++kerningEnabled)
+        {
+            GDIPPRenderer::TextLayout layout;
+            int iterations = 0;
+            Timer timer;
+
+            do
+            {
+                layout = GDIPPRenderer::LayoutText(font, request, GDIPPRenderer::SubpixelOversample, 1, kerningEnabled != 0, 8);
+                ++iterations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            const double seconds = timer.GetElapsedSeconds();
+
+            Result("layout", kerningEnabled ? "kerning" : "no_kerning")
+                .Add("glyphs", static_cast<double>(layout.glyphs.size()))
+                .Add("width", layout.width)
+                .Add("us_per_layout", seconds * 1e6 / iterations)
+                .Add("ns_per_glyph", seconds * 1e9 / iterations / layout.glyphs.size())
+                .Print();
+        }
+    }
+} // namespace GDIPPBenchmark
@@ -0,0 +1,136 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+#include "../gdipp_preview_renderer/lcd_filter.h"
+#include "../gdipp_preview_renderer/simd.h"
+
+namespace GDIPPBenchmark
+{
+    void RunLCDFilterBenchmark(const Options & options)
+    {
+        /*
+        *   Filters a sheet of 3x oversampled coverage scanline by scanline,
+        *   reports output megapixels per second for every filter mode.
+        */
+
+        typedef GDIPPConfiguration::Values::LCDFilter LCDFilter;
+
+        const int width = options.GetInt("width", 2048);
+        const int height = options.GetInt("height", 1024);
+        const double minimumSeconds = options.GetDouble("seconds", 0.5);
+        const int samples = width * 3;
+
+        std::vector<unsigned char> source(static_cast<size_t>(samples) * height);
+        std::vector<unsigned char> destination(samples);
+
+        // glyph-like content: runs of solid coverage with soft edges
+        srand(1);
+
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            source[i] = (rand() % 4 == 0) ? static_cast<unsigned char>(rand() & 0xFF) :
+                        ((i / 7) % 3 == 0 ? 0xFF : 0x00);
+        }
+
+        const int modes[] = { LCDFilter::None, LCDFilter::Default, LCDFilter::Light, LCDFilter::Legacy };
+        const char * names[] = { "none", "default", "light", "legacy" };
+
+        for (int m = 0; m < 4; ++m)
+        {
+            const GDIPPRenderer::LCDFilterKernel kernel(modes[m]);
+            int iterations = 0;
+            Timer timer;
+
+            do
+            {
+                for (int y = 0; y < height; ++y)
+                {
+                    kernel.Apply(&source[static_cast<size_t>(y) * samples], &destination[0], samples);
+                }
+
+                ++iterations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            const double seconds = timer.GetElapsedSeconds();
+            const double megapixels = static_cast<double>(width) * height * iterations / 1e6;
+
+            Result("lcd_filter", names[m])
+                .Add("simd", GDIPPRenderer::GetSimdLevelName())
+                .Add("width", width)
+                .Add("height", height)
+                .Add("iterations", iterations)
+                .Add("mpixels_per_second", megapixels / seconds)
+                .Print();
+        }
+
+        // the whole resolve step, per output mode
+        GDIPPRenderer::CoverageBitmap coverage(samples, height);
+        GDIPPRenderer::CoverageBitmap channels;
+
+        for (int y = 0; y < height; ++y)
+        {
+            std::copy(&source[static_cast<size_t>(y) * samples],
+                      &source[static_cast<size_t>(y) * samples] + samples,
+                      coverage.GetRow(y));
+        }
+
+        const GDIPPRenderer::OutputMode outputModes[] =
+        {
+            GDIPPRenderer::Output_Mono, GDIPPRenderer::Output_Gray, GDIPPRenderer::Output_Subpixel
+        };
+
+        for (int m = 0; m < 3; ++m)
+        {
+            int iterations = 0;
+            Timer timer;
+
+            do
+            {
+                GDIPPRenderer::ResolveChannels(coverage, channels, outputModes[m],
+                                               LCDFilter::Default,
+                                               GDIPPConfiguration::Values::PixelGeometry::BGR);
+                ++iterations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            const double seconds = timer.GetElapsedSeconds();
+            const double megapixels = static_cast<double>(width) * height * iterations / 1e6;
+
+            Result("lcd_filter", std::string("resolve_") + GDIPPRenderer::GetOutputModeName(outputModes[m]))
+                .Add("simd", GDIPPRenderer::GetSimdLevelName())
+                .Add("width", width)
+                .Add("height", height)
+                .Add("iterations", iterations)
+                .Add("mpixels_per_second", megapixels / seconds)
+                .Print();
+        }
+    }
+} // namespace GDIPPBenchmark
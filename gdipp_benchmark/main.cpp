@@ -0,0 +1,141 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "benchmark.h"
+
+#include "../gdipp-conf-editor/util.h"
+#include "../gdipp-conf-editor/trace.h"
+#include "../gdipp-conf-editor/metrics.h"
+
+int main(int argc, char ** argv)
+{
+    /*
+    *   gdipp-benchmark [suite=<name>|all] [name=value ...]
+    *   gdipp-benchmark generate=<file>|- [name=value ...]
+    *   gdipp-benchmark suite=golden|golden=<directory> [--update] [name=value ...]
+    *
+    *   Exits with 1 when a golden image fails or is missing, -1 on an
+    *   error.
+    *
+    *   trace=<file> also writes a Chrome trace of the run, --stats prints
+    *   the latency histograms and counters after the results.
+    */
+
+    try
+    {
+        GDIPPBenchmark::Options options(argc, argv);
+        Trace::Session traceSession(Util::CreateMetaString(options.Get("trace", "")));
+        Metrics::Report statsReport(!options.Get("--stats", "").empty(), std::cout);
+
+        if (!options.Get("generate", "").empty())
+        {
+            GDIPPBenchmark::RunConfigurationGenerator(options);
+            return 0;
+        }
+
+        const std::string suite = options.Get("suite", "all");
+
+        // not part of all, a failure is not a benchmark result
+        if (suite == "golden" || !options.Get("golden", "").empty())
+        {
+            return GDIPPBenchmark::RunGoldenImages(options) > 0 ? 1 : 0;
+        }
+
+        bool found = false;
+
+        if (suite == "all" || suite == "lcd_filter")
+        {
+            GDIPPBenchmark::RunLCDFilterBenchmark(options);
+            found = true;
+        }
+
+        if (suite == "all" || suite == "gamma")
+        {
+            GDIPPBenchmark::RunGammaBenchmark(options);
+            found = true;
+        }
+
+        if (suite == "all" || suite == "composite")
+        {
+            GDIPPBenchmark::RunCompositeBenchmark(options);
+            found = true;
+        }
+
+        if (suite == "all" || suite == "embolden")
+        {
+            GDIPPBenchmark::RunEmboldenBenchmark(options);
+            found = true;
+        }
+
+        if (suite == "all" || suite == "render")
+        {
+            GDIPPBenchmark::RunRenderBenchmark(options);
+            found = true;
+        }
+
+        if (suite == "all" || suite == "sweep")
+        {
+            GDIPPBenchmark::RunSweepBenchmark(options);
+            found = true;
+        }
+
+        if (suite == "all" || suite == "layout")
+        {
+            GDIPPBenchmark::RunLayoutBenchmark(options);
+            found = true;
+        }
+
+        if (suite == "all" || suite == "encode")
+        {
+            GDIPPBenchmark::RunEncodeBenchmark(options);
+            found = true;
+        }
+
+        if (suite == "all" || suite == "config")
+        {
+            GDIPPBenchmark::RunConfigBenchmark(options);
+            found = true;
+        }
+
+        if (suite == "all" || suite == "preview")
+        {
+            GDIPPBenchmark::RunPreviewBenchmark(options);
+            found = true;
+        }
+
+        if (!found)
+        {
+            throw std::runtime_error("Unknown benchmark suite: " + suite);
+        }
+    }
+    catch (const std::exception & e)
+    {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
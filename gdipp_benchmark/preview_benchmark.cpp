@@ -0,0 +1,388 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <gdiplus.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "../gdipp-conf-editor/util.h"
+#include "../gdipp-conf-editor/gdipp_configuration_reader.h"
+#include "../gdipp_preview_renderer/software_renderer.h"
+#include "../gdipp_preview_renderer/shared_frame.h"
+#include "../gdipp_preview_renderer/parameter_sweep.h"
+#include "../gdipp_preview_renderer/ab_preview.h"
+#include "../gdipp_preview_renderer/image_compare.h"
+
+#include "config_generator.h"
+
+namespace GDIPPBenchmark
+{
+    static MetaString GetSharedFrameName()
+    {
+        std::stringstream stream;
+
+#if defined(_WIN32)
+        stream << "Local\\gdipp_benchmark_" << GetCurrentProcessId();
+#else
+        stream << "/gdipp_benchmark_" << getpid();
+#endif
+
+        return Util::CreateMetaString(stream.str());
+    }
+
+    static void RunSoftwarePreview(const Options & options, int iterations)
+    {
+        /*
+        *   What an in-process preview would do on every edit: read the
+        *   settings, apply the edited value, render with the software
+        *   renderer and hand the frame over through shared memory. Both
+        *   ends of the shared memory live in this process.
+        */
+
+        const std::string directory = options.Get("directory", ".");
+        const std::string fileName = directory + "/gdipp_benchmark_preview.xml";
+
+        GeneratorSettings settings = GetGeneratorSettings(options);
+        settings.overrideBlocks = 8;
+
+        {
+            const GeneratedConfiguration configuration = GenerateConfiguration(settings);
+            std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+            file.write(configuration.data.data(), static_cast<std::streamsize>(configuration.data.size()));
+
+            if (!file)
+            {
+                throw std::runtime_error("Unable to write " + fileName);
+            }
+        }
+
+        // the edit made before every preview, by default one which re-runs
+        // every stage
+        const std::vector<GDIPPRenderer::SweepAxis> changes =
+            GDIPPRenderer::ParseSweepAxes(Util::CreateMetaString(options.Get("change", "hinting=1,2")));
+
+        if (changes.size() != 1)
+        {
+            throw std::runtime_error("The preview benchmark takes one change, e.g. change=gamma=1.0,1.4");
+        }
+
+        GDIPPRenderer::PreviewRequest request;
+        request.fontFileName = Util::CreateMetaString(options.Get("font", GetDefaultFontFileName()));
+        request.pixelSizes.push_back(13);
+        request.pixelSizes.push_back(16);
+
+        const size_t capacity = static_cast<size_t>(options.GetInt("shared_mb", 16)) * 1024 * 1024;
+
+        GDIPPRenderer::SoftwareRenderer renderer;
+        GDIPPRenderer::SharedFrame producer(GetSharedFrameName(), capacity, true);
+        GDIPPRenderer::SharedFrame consumer(GetSharedFrameName(), capacity, false);
+        GDIPPRenderer::RenderedImage received;
+
+        LatencySamples readSamples, renderSamples, publishSamples, receiveSamples, totalSamples;
+
+        try
+        {
+            for (int i = 0; i < iterations; ++i)
+            {
+                Timer total;
+                Timer stage;
+
+                GDIPPConfiguration::Values values = GDIPPConfiguration::Reader(Util::CreateMetaString(fileName)).GetValues();
+                readSamples.Add(stage.GetElapsedSeconds());
+
+                stage.Restart();
+                changes[0].Apply(values, i % changes[0].GetSettings().size());
+
+                const GDIPPRenderer::RenderedImage & image = renderer.Render(request, values);
+                renderSamples.Add(stage.GetElapsedSeconds());
+
+                stage.Restart();
+                producer.Write(image);
+                publishSamples.Add(stage.GetElapsedSeconds());
+
+                stage.Restart();
+
+                if (!consumer.Read(received) || received.GetWidth() != image.GetWidth())
+                {
+                    throw std::runtime_error("The frame did not arrive through the shared memory.");
+                }
+
+                receiveSamples.Add(stage.GetElapsedSeconds());
+                totalSamples.Add(total.GetElapsedSeconds());
+            }
+        }
+        catch (...)
+        {
+            remove(fileName.c_str());
+            throw;
+        }
+
+        remove(fileName.c_str());
+
+        readSamples.Print("preview", "software", "read_settings");
+        renderSamples.Print("preview", "software", "render");
+        publishSamples.Print("preview", "software", "publish");
+        receiveSamples.Print("preview", "software", "receive");
+        totalSamples.Print("preview", "software", "total");
+    }
+
+    static void RunABPreview(const Options & options, int iterations)
+    {
+        /*
+        *   The editor's A/B comparison: the current values stay, the edit
+        *   goes to the candidate. render_tiles is the whole Render, the
+        *   candidate's renderer stages included, full_heatmap a heatmap of
+        *   the whole panel alone. redrawn_share is the part of the sheet
+        *   an edit redraws: the candidate and heatmap panels, within the
+        *   changed glyphs of each tile.
+        */
+
+        const std::vector<GDIPPRenderer::SweepAxis> changes =
+            GDIPPRenderer::ParseSweepAxes(Util::CreateMetaString(options.Get("change", "gamma=1.0,1.4")));
+
+        if (changes.size() != 1)
+        {
+            throw std::runtime_error("The preview benchmark takes one change, e.g. change=gamma=1.0,1.4");
+        }
+
+        GDIPPRenderer::PreviewRequest request;
+        request.fontFileName = Util::CreateMetaString(options.Get("font", GetDefaultFontFileName()));
+        request.pixelSizes.push_back(13);
+        request.pixelSizes.push_back(16);
+
+        const GDIPPConfiguration::Values current = CreateBenchmarkValues();
+        GDIPPConfiguration::Values candidate = current;
+
+        GDIPPRenderer::ABPreview preview;
+        preview.Render(request, current, candidate);
+
+        LatencySamples renderSamples, heatmapSamples;
+        double tiles = 0;
+        double pixels = 0;
+
+        for (int i = 0; i < iterations; ++i)
+        {
+            changes[0].Apply(candidate, i % changes[0].GetSettings().size());
+
+            Timer stage;
+            preview.Render(request, current, candidate);
+            renderSamples.Add(stage.GetElapsedSeconds());
+
+            const std::vector<GDIPPRenderer::ImageTile> & changed = preview.GetChangedTiles();
+
+            for (size_t t = 0; t < changed.size(); ++t)
+            {
+                pixels += static_cast<double>(changed[t].width) * changed[t].height;
+            }
+
+            tiles += static_cast<double>(changed.size());
+        }
+
+        const GDIPPRenderer::RenderedImage & sheet = preview.GetSheet();
+        const int panelWidth = (sheet.GetWidth() - 2 * GDIPPRenderer::ABPreview::PanelGap) / 3;
+
+        GDIPPRenderer::RenderedImage left(panelWidth, sheet.GetHeight(), 0);
+        GDIPPRenderer::RenderedImage right(panelWidth, sheet.GetHeight(), 0);
+        left.Draw(sheet, 0, 0);
+        right.Draw(sheet, -(panelWidth + GDIPPRenderer::ABPreview::PanelGap), 0);
+
+        for (int i = 0; i < iterations; ++i)
+        {
+            Timer stage;
+            GDIPPRenderer::CreateDifferenceHeatmap(left, right);
+            heatmapSamples.Add(stage.GetElapsedSeconds());
+        }
+
+        renderSamples.Print("preview", "ab", "render_tiles");
+        heatmapSamples.Print("preview", "ab", "full_heatmap");
+
+        Result("preview", "ab")
+            .Add("sheet_width", sheet.GetWidth())
+            .Add("sheet_height", sheet.GetHeight())
+            .Add("tiles_per_edit", tiles / iterations)
+            .Add("redrawn_share", pixels / iterations / (static_cast<double>(sheet.GetWidth()) * sheet.GetHeight()))
+            .Print();
+    }
+
+#if defined(_WIN32)
+    static void RunDemoProcessPreview(const Options & options, int iterations)
+    {
+        /*
+        *   The path GDIPPPreview::UpdateView takes: a temporary file, the
+        *   gdipp-demo-render process (dialog creation, WM_PRINT and
+        *   encoding happen inside it), GDI+ decoding and drawing.
+        */
+
+        using namespace Gdiplus;
+
+        const MetaString demo = Util::CreateMetaString(options.Get("demo", "gdipp-demo-render.exe"));
+
+        GdiplusStartupInput startupInput;
+        ULONG_PTR token = 0;
+
+        if (GdiplusStartup(&token, &startupInput, NULL) != Ok)
+        {
+            throw std::runtime_error("GdiplusStartup has failed.");
+        }
+
+        HDC screen = GetDC(NULL);
+        HDC dc = CreateCompatibleDC(screen);
+        HBITMAP bitmap = CreateCompatibleBitmap(screen, 2048, 1024);
+        ReleaseDC(NULL, screen);
+
+        HGDIOBJ oldBitmap = SelectObject(dc, bitmap);
+
+        LatencySamples temporarySamples, processSamples, loadSamples, drawSamples, cleanupSamples, totalSamples;
+
+        try
+        {
+            for (int i = 0; i < iterations; ++i)
+            {
+                Timer total;
+                Timer stage;
+
+                TCHAR directory[MAX_PATH];
+                TCHAR fileName[MAX_PATH];
+
+                if (GetTempPath(MAX_PATH, directory) == 0 || GetTempFileName(directory, TEXT("demo_render"), 0, fileName) == 0)
+                {
+                    throw std::runtime_error("Unable to obtain a temporary file name.");
+                }
+
+                temporarySamples.Add(stage.GetElapsedSeconds());
+                stage.Restart();
+
+                MetaString commandLine = TEXT("\"") + demo + TEXT("\" output=\"") + fileName + TEXT("\"");
+                std::vector<TCHAR> commandLineBuffer(commandLine.begin(), commandLine.end());
+                commandLineBuffer.push_back(0);
+
+                STARTUPINFO startupInfo;
+                PROCESS_INFORMATION processInfo;
+
+                memset(&startupInfo, 0, sizeof(startupInfo));
+                memset(&processInfo, 0, sizeof(processInfo));
+                startupInfo.cb = sizeof(startupInfo);
+
+                if (!CreateProcess(NULL, &commandLineBuffer[0], NULL, NULL, FALSE, 0, NULL, NULL, &startupInfo, &processInfo))
+                {
+                    DeleteFile(fileName);
+                    throw std::runtime_error("Unable to start " + Util::MetaStringToAnsi(demo));
+                }
+
+                WaitForSingleObject(processInfo.hProcess, INFINITE);
+                CloseHandle(processInfo.hThread);
+                CloseHandle(processInfo.hProcess);
+
+                processSamples.Add(stage.GetElapsedSeconds());
+                stage.Restart();
+
+                Image * image = Image::FromFile(Util::MetaStringToUnicode(fileName).c_str());
+
+                if (image == NULL || image->GetLastStatus() != Ok)
+                {
+                    delete image;
+                    DeleteFile(fileName);
+                    throw std::runtime_error("Unable to load the preview image.");
+                }
+
+                loadSamples.Add(stage.GetElapsedSeconds());
+                stage.Restart();
+
+                {
+                    Graphics graphics(dc);
+                    graphics.DrawImage(image, PointF(0, 0));
+                }
+
+                drawSamples.Add(stage.GetElapsedSeconds());
+                stage.Restart();
+
+                delete image;
+                DeleteFile(fileName);
+
+                cleanupSamples.Add(stage.GetElapsedSeconds());
+                totalSamples.Add(total.GetElapsedSeconds());
+            }
+        }
+        catch (...)
+        {
+            SelectObject(dc, oldBitmap);
+            DeleteObject(bitmap);
+            DeleteDC(dc);
+            GdiplusShutdown(token);
+            throw;
+        }
+
+        SelectObject(dc, oldBitmap);
+        DeleteObject(bitmap);
+        DeleteDC(dc);
+        GdiplusShutdown(token);
+
+        temporarySamples.Print("preview", "demo_process", "temporary_file");
+        processSamples.Print("preview", "demo_process", "demo_process");
+        loadSamples.Print("preview", "demo_process", "load_image");
+        drawSamples.Print("preview", "demo_process", "draw_image");
+        cleanupSamples.Print("preview", "demo_process", "cleanup");
+        totalSamples.Print("preview", "demo_process", "total");
+    }
+#endif
+
+    void RunPreviewBenchmark(const Options & options)
+    {
+        /*
+        *   End-to-end preview latency, p50/p95/p99 of every stage over
+        *   iterations= previews. variant=software (any platform), ab
+        *   (the A/B comparison, any platform), demo_process (Windows, the
+        *   editor's current path) or all.
+        */
+
+        const int iterations = options.GetInt("iterations", 100);
+        const std::string variant = options.Get("variant", "all");
+
+        if (variant == "all" || variant == "software")
+        {
+            RunSoftwarePreview(options, iterations);
+        }
+
+        if (variant == "all" || variant == "ab")
+        {
+            RunABPreview(options, iterations);
+        }
+
+#if defined(_WIN32)
+        if (variant == "all" || variant == "demo_process")
+        {
+            RunDemoProcessPreview(options, iterations);
+        }
+#endif
+    }
+} // namespace GDIPPBenchmark
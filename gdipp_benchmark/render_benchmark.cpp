@@ -0,0 +1,359 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+#include "../gdipp-conf-editor/util.h"
+#include "../gdipp-conf-editor/metrics.h"
+#include "../gdipp_preview_renderer/software_renderer.h"
+#include "../gdipp_preview_renderer/glyph_cache.h"
+#include "../gdipp_preview_renderer/thread_pool.h"
+#include "../gdipp_preview_renderer/simd.h"
+
+namespace GDIPPBenchmark
+{
+    std::string GetDefaultFontFileName()
+    {
+#if defined(_WIN32)
+        return "C:\\Windows\\Fonts\\arial.ttf";
+#else
+        return "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+#endif
+    }
+
+    GDIPPRenderer::PreviewRequest CreateParagraphRequest(const Options & options)
+    {
+        GDIPPRenderer::PreviewRequest request;
+        request.fontFileName = Util::CreateMetaString(options.Get("font", GetDefaultFontFileName()));
+
+        request.lines.push_back(L"The quick brown fox jumps over the lazy dog. 0123456789");
+        request.lines.push_back(L"Pack my box with five dozen liquor jugs! {[(<>)]} @#$%^&*");
+        request.lines.push_back(L"Sphinx of black quartz, judge my vow; WALTZ, NYMPH, FOR QUICK JIGS VEX BUD.");
+
+        const int minimumSize = options.GetInt("min_size", 8);
+        const int maximumSize = options.GetInt("max_size", 48);
+
+        request.pixelSizes.clear();
+
+        for (int size = minimumSize; size <= maximumSize; size += 2)
+        {
+            request.pixelSizes.push_back(size);
+        }
+
+        return request;
+    }
+
+    GDIPPConfiguration::Values CreateBenchmarkValues()
+    {
+        GDIPPConfiguration::Values values;
+        values.hinting = 1;
+        values.embolden = 32;
+        values.lcdFilter = GDIPPConfiguration::Values::LCDFilter(TEXT("1"));
+        values.renderMode = GDIPPConfiguration::Values::RenderMode(TEXT("1"), TEXT("1"), TEXT("1"));
+        values.pixelGeometry = GDIPPConfiguration::Values::PixelGeometry(TEXT("0"));
+        values.gamma = GDIPPConfiguration::Values::Gamma(TEXT("1.4"), TEXT("1.4"), TEXT("1.4"));
+        values.shadow = GDIPPConfiguration::Values::Shadow(1, 1, 64);
+
+        return values;
+    }
+
+    unsigned long long HashImage(const GDIPPRenderer::RenderedImage & image)
+    {
+        // FNV-1a over all the pixels
+        unsigned long long hash = 14695981039346656037ULL;
+
+        for (int y = 0; y < image.GetHeight(); ++y)
+        {
+            const unsigned char * row = image.GetRow(y);
+
+            for (int x = 0; x < image.GetStride(); ++x)
+            {
+                hash = (hash ^ row[x]) * 1099511628211ULL;
+            }
+        }
+
+        return hash;
+    }
+
+    static void RenderIncrementally(const Options & options)
+    {
+        /*
+        *   Re-renders the sheet changing one field at a time, only the
+        *   stages depending on it should run.
+        */
+
+        const double minimumSeconds = options.GetDouble("seconds", 0.5);
+        const char * fields[] = { "none", "shadow_alpha", "gamma_red", "lcd_filter", "embolden", "hinting" };
+
+        GDIPPRenderer::PreviewRequest request = CreateParagraphRequest(options);
+        request.margin = 8;
+
+        for (size_t field = 0; field < sizeof(fields) / sizeof(fields[0]); ++field)
+        {
+            GDIPPRenderer::SoftwareRenderer renderer(options.GetInt("threads", 0));
+            GDIPPConfiguration::Values values = CreateBenchmarkValues();
+
+            renderer.Render(request, values);
+
+            std::vector<size_t> runCounts;
+
+            for (int stage = 0; stage < GDIPPRenderer::SoftwareRenderer::Stage_Count; ++stage)
+            {
+                runCounts.push_back(renderer.GetStageRunCount(static_cast<GDIPPRenderer::SoftwareRenderer::Stage>(stage)));
+            }
+
+            int iterations = 0;
+            Timer timer;
+
+            do
+            {
+                const bool odd = (iterations & 1) != 0;
+
+                switch (field)
+                {
+                case 1:
+                    values.shadow = GDIPPConfiguration::Values::Shadow(1, 1, odd ? 96 : 64);
+                    break;
+                case 2:
+                    values.gamma = GDIPPConfiguration::Values::Gamma(odd ? TEXT("1.8") : TEXT("1.4"), TEXT("1.4"), TEXT("1.4"));
+                    break;
+                case 3:
+                    values.lcdFilter = GDIPPConfiguration::Values::LCDFilter(odd ? TEXT("2") : TEXT("1"));
+                    break;
+                case 4:
+                    values.embolden = odd ? 48 : 32;
+                    break;
+                case 5:
+                    values.hinting = odd ? 2 : 1;
+                    break;
+                }
+
+                renderer.Render(request, values);
+                ++iterations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            Result result("render", "incremental");
+            result.Add("changed", fields[field])
+                  .Add("iterations", iterations)
+                  .Add("ms_per_sheet", timer.GetElapsedSeconds() * 1e3 / iterations);
+
+            // stages which ran on every change
+            std::string stages;
+
+            for (int stage = 0; stage < GDIPPRenderer::SoftwareRenderer::Stage_Count; ++stage)
+            {
+                const GDIPPRenderer::SoftwareRenderer::Stage id = static_cast<GDIPPRenderer::SoftwareRenderer::Stage>(stage);
+
+                if (renderer.GetStageRunCount(id) > runCounts[stage])
+                {
+                    stages += stages.empty() ? "" : ",";
+                    stages += GDIPPRenderer::SoftwareRenderer::GetStageName(id);
+                }
+            }
+
+            result.Add("stages", stages.empty() ? "none" : stages).Print();
+        }
+    }
+
+    // sheets rendered with a new renderer each, in the shared glyph cache
+    // or, when it is NULL, a new one of the given budget every time
+    static int RenderSheets(const GDIPPRenderer::PreviewRequest & request,
+                            const GDIPPConfiguration::Values & values,
+                            int threads,
+                            size_t budget,
+                            GDIPPRenderer::GlyphCache * sharedCache,
+                            double minimumSeconds,
+                            double & secondsPerSheet,
+                            double & rasterizeSecondsPerSheet)
+    {
+        const double rasterizeStart = Metrics::Snapshot().histograms[Metrics::Histogram_PreviewRasterize].GetTotalSeconds();
+        int iterations = 0;
+        Timer timer;
+
+        do
+        {
+            GDIPPRenderer::GlyphCache ownCache(sharedCache ? 0 : budget);
+            GDIPPRenderer::SoftwareRenderer renderer(threads, sharedCache ? sharedCache : &ownCache);
+            renderer.Render(request, values);
+            ++iterations;
+        }
+        while (timer.GetElapsedSeconds() < minimumSeconds);
+
+        const double rasterizeEnd = Metrics::Snapshot().histograms[Metrics::Histogram_PreviewRasterize].GetTotalSeconds();
+
+        secondsPerSheet = timer.GetElapsedSeconds() / iterations;
+        rasterizeSecondsPerSheet = (rasterizeEnd - rasterizeStart) / iterations;
+
+        return iterations;
+    }
+
+    static void RenderWithGlyphCache(const Options & options)
+    {
+        /*
+        *   Renders the sheet with a new renderer every time, all sharing one
+        *   glyph cache, the way the sweep and the editor preview do, and
+        *   for comparison with an empty cache every time. Only a cold sheet
+        *   rasterizes glyphs, a warm one places cached ones. The rasterize
+        *   stage is timed apart from the whole sheet, which embolden and
+        *   compositing dominate. A warm sheet missing the cache, or a warm
+        *   rasterize stage no faster than a cold one, fails the suite.
+        */
+
+        const double minimumSeconds = options.GetDouble("seconds", 0.5);
+        const size_t budget = static_cast<size_t>(options.GetInt("glyph_cache_kb", 32 * 1024)) * 1024;
+        const int threads = options.GetInt("threads", 0);
+
+        GDIPPRenderer::PreviewRequest request = CreateParagraphRequest(options);
+        const GDIPPConfiguration::Values values = CreateBenchmarkValues();
+
+        double coldSeconds = 0.0;
+        double coldRasterizeSeconds = 0.0;
+        RenderSheets(request, values, threads, budget, NULL, minimumSeconds, coldSeconds, coldRasterizeSeconds);
+
+        // fills the cache
+        GDIPPRenderer::GlyphCache glyphCache(budget);
+        double seconds = 0.0;
+        double rasterizeSeconds = 0.0;
+        RenderSheets(request, values, threads, budget, &glyphCache, 0.0, seconds, rasterizeSeconds);
+
+        const size_t fillMisses = glyphCache.GetStatistics().misses;
+        RenderSheets(request, values, threads, budget, &glyphCache, minimumSeconds, seconds, rasterizeSeconds);
+
+        const GDIPPRenderer::GlyphCacheStatistics statistics = glyphCache.GetStatistics();
+
+        Result("render", "glyph_cache")
+            .Add("budget_kb", static_cast<double>(budget / 1024))
+            .Add("ms_cold_sheet", coldSeconds * 1e3)
+            .Add("ms_per_sheet", seconds * 1e3)
+            .Add("ms_cold_rasterize", coldRasterizeSeconds * 1e3)
+            .Add("ms_rasterize", rasterizeSeconds * 1e3)
+            .Add("rasterize_speedup", coldRasterizeSeconds / rasterizeSeconds)
+            .Add("hits", static_cast<double>(statistics.hits))
+            .Add("misses", static_cast<double>(statistics.misses))
+            .Add("evictions", static_cast<double>(statistics.evictions))
+            .Add("entries", static_cast<double>(statistics.entries))
+            .Add("kb", static_cast<double>(statistics.bytes / 1024))
+            .Add("reserved_kb", static_cast<double>(statistics.reservedBytes / 1024))
+            .Print();
+
+        // a budget too small for the sheet evicts, and then misses again
+        if (statistics.evictions == 0 && statistics.misses != fillMisses)
+        {
+            throw std::runtime_error("Warm sheets rasterized glyphs missing from the glyph cache.");
+        }
+
+        if (statistics.evictions == 0 && rasterizeSeconds >= coldRasterizeSeconds)
+        {
+            throw std::runtime_error("The rasterize stage is no faster with every glyph in the cache.");
+        }
+    }
+
+    void RunRenderBenchmark(const Options & options)
+    {
+        /*
+        *   Renders a paragraph sheet at many sizes from the layout stage on,
+        *   once per thread count. The checksum must not depend on the
+        *   thread count, a sheet that differs from the single thread one
+        *   fails the suite.
+        */
+
+        const double minimumSeconds = options.GetDouble("seconds", 0.5);
+        const int maximumThreads = options.GetInt("max_threads", GDIPPRenderer::ThreadPool::GetProcessorCount());
+
+        GDIPPRenderer::PreviewRequest request = CreateParagraphRequest(options);
+        const GDIPPConfiguration::Values values = CreateBenchmarkValues();
+
+        std::vector<int> threadCounts;
+
+        for (int threads = 1; threads < maximumThreads; threads *= 2)
+        {
+            threadCounts.push_back(threads);
+        }
+
+        threadCounts.push_back(maximumThreads);
+
+        double singleThreadSeconds = 0.0;
+        unsigned long long singleThreadHash = 0;
+
+        for (size_t i = 0; i < threadCounts.size(); ++i)
+        {
+            // no glyph cache, every sheet is rasterized from scratch
+            GDIPPRenderer::GlyphCache noGlyphCache(0);
+            GDIPPRenderer::SoftwareRenderer renderer(threadCounts[i], &noGlyphCache);
+            GDIPPRenderer::RenderedImage image;
+            int iterations = 0;
+            Timer timer;
+
+            do
+            {
+                // a different margin every time, nothing is reused from the cache
+                request.margin = 8 + (iterations & 1);
+                image = renderer.Render(request, values);
+                ++iterations;
+            }
+            while (timer.GetElapsedSeconds() < minimumSeconds);
+
+            const double secondsPerSheet = timer.GetElapsedSeconds() / iterations;
+
+            request.margin = 8;
+            image = renderer.Render(request, values);
+
+            const unsigned long long hash = HashImage(image);
+
+            if (i == 0)
+            {
+                singleThreadSeconds = secondsPerSheet;
+                singleThreadHash = hash;
+            }
+
+            std::ostringstream checksum;
+            checksum << std::hex << hash;
+
+            Result("render", "paragraphs")
+                .Add("simd", GDIPPRenderer::GetSimdLevelName())
+                .Add("threads", threadCounts[i])
+                .Add("width", image.GetWidth())
+                .Add("height", image.GetHeight())
+                .Add("iterations", iterations)
+                .Add("ms_per_sheet", secondsPerSheet * 1e3)
+                .Add("speedup", singleThreadSeconds / secondsPerSheet)
+                .Add("checksum", checksum.str())
+                .Add("match", hash == singleThreadHash ? "yes" : "no")
+                .Print();
+
+            if (hash != singleThreadHash)
+            {
+                std::ostringstream message;
+                message << "The sheet rendered with " << threadCounts[i] << " threads differs from the single thread one.";
+                throw std::runtime_error(message.str());
+            }
+        }
+
+        RenderIncrementally(options);
+        RenderWithGlyphCache(options);
+    }
+} // namespace GDIPPBenchmark
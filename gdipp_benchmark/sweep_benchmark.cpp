@@ -0,0 +1,134 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "benchmark.h"
+
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <stdexcept>
+
+#include "../gdipp-conf-editor/util.h"
+#include "../gdipp_preview_renderer/parameter_sweep.h"
+#include "../gdipp_preview_renderer/software_renderer.h"
+#include "../gdipp_preview_renderer/thread_pool.h"
+#include "../gdipp_preview_renderer/perceptual_metrics.h"
+
+namespace GDIPPBenchmark
+{
+    void RunSweepBenchmark(const Options & options)
+    {
+        /*
+        *   Renders every variant of a sweep once with a fresh renderer per
+        *   variant, then as one ParameterSweep sharing the rasterized
+        *   coverage. Both must produce the same previews; both report how
+        *   often their renderers ran the rasterize stage. metrics=<file.csv>
+        *   writes the perceptual metrics of every variant.
+        */
+
+        const int threads = options.GetInt("threads", GDIPPRenderer::ThreadPool::GetProcessorCount());
+        const std::string axesText = options.Get("axes", "hinting=0,1;lcd_filter=0,1,2,16;gamma=1.0,1.4,1.8");
+
+        GDIPPRenderer::PreviewRequest request = CreateParagraphRequest(options);
+        request.margin = 8;
+
+        GDIPPRenderer::ParameterSweep sweep(CreateBenchmarkValues(),
+                                            GDIPPRenderer::ParseSweepAxes(Util::CreateMetaString(axesText)));
+
+        const std::vector<GDIPPRenderer::SweepVariant> & variants = sweep.GetVariants();
+
+        Timer timer;
+        unsigned long long independentHash = 0;
+        size_t independentRasterizations = 0;
+
+        for (size_t i = 0; i < variants.size(); ++i)
+        {
+            GDIPPRenderer::SoftwareRenderer renderer(threads);
+            independentHash ^= HashImage(renderer.Render(request, variants[i].values)) * (i + 1);
+            independentRasterizations += renderer.GetStageRunCount(GDIPPRenderer::SoftwareRenderer::Stage_Rasterize);
+        }
+
+        const double independentSeconds = timer.GetElapsedSeconds();
+
+        timer.Restart();
+        const std::vector<GDIPPRenderer::RenderedImage> images = sweep.RenderVariants(request, threads);
+        const double sweepSeconds = timer.GetElapsedSeconds();
+        const size_t sweepRasterizations = sweep.GetRasterizationCount();
+
+        unsigned long long sweepHash = 0;
+
+        for (size_t i = 0; i < images.size(); ++i)
+        {
+            sweepHash ^= HashImage(images[i]) * (i + 1);
+        }
+
+        const std::string metricsFileName = options.Get("metrics", "");
+
+        if (!metricsFileName.empty())
+        {
+            std::ofstream metricsFile(metricsFileName.c_str());
+            GDIPPRenderer::WriteMetricsCsvHeader(metricsFile);
+
+            for (size_t i = 0; i < images.size(); ++i)
+            {
+                GDIPPRenderer::WriteMetricsCsvRow(metricsFile,
+                                                  Util::MetaStringToAnsi(variants[i].label),
+                                                  GDIPPRenderer::MeasureImage(images[i], request.foreground, request.background));
+            }
+
+            if (!metricsFile)
+            {
+                throw std::runtime_error("Unable to write " + metricsFileName);
+            }
+        }
+
+        timer.Restart();
+        const GDIPPRenderer::RenderedImage sheet = sweep.RenderContactSheet(request, threads);
+        const double sheetSeconds = timer.GetElapsedSeconds();
+
+        std::ostringstream checksum;
+        checksum << std::hex << sweepHash;
+
+        Result("sweep", "variants")
+            .Add("threads", threads)
+            .Add("variants", static_cast<double>(variants.size()))
+            .Add("rasterizations_independent", static_cast<double>(independentRasterizations))
+            .Add("rasterizations", static_cast<double>(sweepRasterizations))
+            .Add("ms_independent", independentSeconds * 1e3)
+            .Add("ms_sweep", sweepSeconds * 1e3)
+            .Add("speedup", independentSeconds / sweepSeconds)
+            .Add("checksum", checksum.str())
+            .Add("match", independentHash == sweepHash ? "yes" : "no")
+            .Print();
+
+        // the sheet renders the variants again, glyphs come from the cache
+        const GDIPPRenderer::GlyphCacheStatistics statistics = sweep.GetGlyphCache().GetStatistics();
+
+        Result("sweep", "contact_sheet")
+            .Add("width", sheet.GetWidth())
+            .Add("height", sheet.GetHeight())
+            .Add("ms", sheetSeconds * 1e3)
+            .Add("glyph_hits", static_cast<double>(statistics.hits))
+            .Add("glyph_misses", static_cast<double>(statistics.misses))
+            .Print();
+    }
+} // namespace GDIPPBenchmark
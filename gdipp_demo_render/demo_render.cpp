@@ -24,186 +24,110 @@
 
 #include <iostream>
 
-#include <gdiplus.h>
-#include <gdiplusimaging.h>
-#include <gdiplusimagecodec.h>
-
 #include <windows.h>
 
-#include <sstream>
-
 #include "resource.h"
 
 #include "../gdipp-conf-editor/util.h"
+#include "../gdipp-conf-editor/trace.h"
+#include "../gdipp_preview_renderer/image_writer.h"
 
 static const UINT Trigger_WMPRINT = 0x9103;
 
 DemoRender::DemoRender(const MetaString & outputFileName)
     : outputFileName(outputFileName),
-      gdiplusToken(NULL),
       capturedBitmap(NULL),
+      capturedPixels(NULL),
+      capturedWidth(0),
+      capturedHeight(0),
       stopMessageLoop(false)
 {
-    using namespace Gdiplus;
-
-    GdiplusStartupInput gdiplusStartupInput;
-    
 
-    Status gdiplusStatus =
-        GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
-
-    if (gdiplusStatus != Ok)
-    {
-        MetaString message = TEXT("GdiplusStartup has failed. Status code: ");
-        message += Util::IntToStr(static_cast<int>(gdiplusStatus));
-
-        throw std::runtime_error(Util::MetaStringToAnsi(message));
-    }
 }
 
 DemoRender::~DemoRender()
 {
-    using namespace Gdiplus;
-
     if (capturedBitmap)
     {
         DeleteObject(capturedBitmap);
         capturedBitmap = NULL;
     }
-
-    if (gdiplusToken)
-    {
-        GdiplusShutdown(gdiplusToken);
-        gdiplusToken = NULL;
-    }
 }
 
 void DemoRender::RenderToFile(const MetaString & text)
 {
-    using namespace Gdiplus;
+    GDIPP_TRACE_SCOPE("DemoRender::RenderToFile");
 
     textToRender = text;
 
     MSG msg;
-    
-    // Create hidden window and use WM_PRINT message
-    HWND hwnd = CreateDialogParam(NULL,
-        MAKEINTRESOURCE(IDD_MAIN_DLG),
-        NULL, MainDlgProc,
-        reinterpret_cast<LPARAM>(this));            
-
-    SetDlgItemText(hwnd, IDC_STATIC1, text.c_str());
-
-	SendDlgItemMessage(hwnd,
-		IDC_TEST_LISTBOX,
-		LB_ADDSTRING,
-		NULL,
-		reinterpret_cast<WPARAM>(TEXT("ABCDEFGHIJKLMNOPQRSTUWXYZ")));
-
-	SendDlgItemMessage(hwnd,
-		IDC_TEST_LISTBOX,
-		LB_ADDSTRING,
-		NULL,
-		reinterpret_cast<WPARAM>(TEXT("0123456789")));
-
-    ShowWindow(hwnd, SW_HIDE);
-
-    // trigger window printing
-    SendMessage(hwnd, WM_COMMAND, MAKEWPARAM(Trigger_WMPRINT, 0), 0);
-    
-    while (true)
-    {
-        if (stopMessageLoop)
-        {
-            break;
-        }
+    HWND hwnd = NULL;
 
-        if (GetMessage(&msg, NULL, 0, 0))
-        {
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
-        }
-    }
-
-    if (capturedBitmap)
     {
-        Bitmap * bitmap = new Bitmap(capturedBitmap, NULL);
-
-        if (!bitmap)
-        {
-            throw std::runtime_error("Unable to allocate memory to GDI+ Bitmap.");
-        }
-       
-        CLSID bmpClsid;
-    
-        try
-        {
-            if (GetEncoderClsid(TEXT("image/bmp"), &bmpClsid) == false)
-            {
-                throw std::runtime_error("Unable to obtain image/bmp GDI+ encoder.");
-            }
-        }
-        catch (const std::exception & e)
-        {
-            delete bitmap;
+        GDIPP_TRACE_SCOPE("DemoRender::CreateDialog");
 
-            std::cerr << e.what() << std::endl;
-            throw;
-        }
+        // Create hidden window and use WM_PRINT message
+        hwnd = CreateDialogParam(NULL,
+            MAKEINTRESOURCE(IDD_MAIN_DLG),
+            NULL, MainDlgProc,
+            reinterpret_cast<LPARAM>(this));
 
-        Status status = bitmap->Save(Util::MetaStringToUnicode(outputFileName).c_str(), &bmpClsid);
+        SetDlgItemText(hwnd, IDC_STATIC1, text.c_str());
 
-        delete bitmap;
+        SendDlgItemMessage(hwnd,
+            IDC_TEST_LISTBOX,
+            LB_ADDSTRING,
+            NULL,
+            reinterpret_cast<WPARAM>(TEXT("ABCDEFGHIJKLMNOPQRSTUWXYZ")));
 
-        if (status != Gdiplus::Ok)
-        {
-            std::stringstream stream;
-            stream << "Gdiplus::Bitmap::Save failed with code " << static_cast<int>(status);
+        SendDlgItemMessage(hwnd,
+            IDC_TEST_LISTBOX,
+            LB_ADDSTRING,
+            NULL,
+            reinterpret_cast<WPARAM>(TEXT("0123456789")));
 
-            throw std::runtime_error(stream.str().c_str());
-        }
+        ShowWindow(hwnd, SW_HIDE);
     }
-}
 
-bool DemoRender::GetEncoderClsid(const MetaString & format, CLSID * clsid) const
-{
-    using namespace Gdiplus;
-
-    UINT num = 0;
-    UINT size = 0;
-
-    ImageCodecInfo * imageCodecInfo = NULL;
-
-    GetImageEncodersSize(&num, &size);
-
-    if(size == 0)
     {
-        throw std::runtime_error("GetImageEncodersSize has failed.");
-    }
+        GDIPP_TRACE_SCOPE("DemoRender::MessageLoop");
 
-    imageCodecInfo = new ImageCodecInfo[size];
+        // trigger window printing
+        SendMessage(hwnd, WM_COMMAND, MAKEWPARAM(Trigger_WMPRINT, 0), 0);
 
-    if(imageCodecInfo == NULL)
-    {
-        throw std::runtime_error("GetEncoderClsid: Out of memory.");
-    }
+        while (true)
+        {
+            if (stopMessageLoop)
+            {
+                break;
+            }
 
-    GetImageEncoders(num, size, imageCodecInfo);
+            if (GetMessage(&msg, NULL, 0, 0))
+            {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+            }
+        }
+    }
 
-    for(UINT j = 0; j < num; ++j)
+    if (capturedPixels)
     {
-        if(Util::CreateMetaString(imageCodecInfo[j].MimeType) == format)
-        {
-            *clsid = imageCodecInfo[j].Clsid;
-            delete [] imageCodecInfo;
-
-            return true;
-        }    
+        GDIPP_TRACE_SCOPE("DemoRender::SaveImage");
+
+        // the encoder is picked by the output file extension
+        GDIPPRenderer::SaveImage(capturedPixels,
+                                 capturedWidth,
+                                 capturedHeight,
+                                 capturedWidth * 4,
+                                 outputFileName);
     }
+}
 
-    delete [] imageCodecInfo;
+void DemoRender::SaveToFile(const GDIPPRenderer::RenderedImage & image)
+{
+    GDIPP_TRACE_SCOPE("DemoRender::SaveImage");
 
-    return false;
+    GDIPPRenderer::SaveImage(image, outputFileName);
 }
 
 INT_PTR CALLBACK DemoRender::MainDlgProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
@@ -273,6 +197,8 @@ INT_PTR CALLBACK DemoRender::MainDlgProc(HWND hwnd, UINT msg, WPARAM wparam, LPA
 
 bool DemoRender::CaptureWindowContents(HWND hwnd)
 {
+    GDIPP_TRACE_SCOPE("DemoRender::CaptureWindowContents");
+
     // begin printing window
     HDC hDCMem = CreateCompatibleDC(NULL);
 
@@ -284,17 +210,49 @@ bool DemoRender::CaptureWindowContents(HWND hwnd)
     {
         DeleteObject(capturedBitmap);
         capturedBitmap = NULL;
+        capturedPixels = NULL;
+    }
+
+    capturedWidth = rect.right - rect.left;
+    capturedHeight = rect.bottom - rect.top;
+
+    // top-down 32-bit rows, the layout the image writers expect
+    BITMAPINFO bitmapInfo;
+    ZeroMemory(&bitmapInfo, sizeof(bitmapInfo));
+
+    bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bitmapInfo.bmiHeader.biWidth = capturedWidth;
+    bitmapInfo.bmiHeader.biHeight = -capturedHeight;
+    bitmapInfo.bmiHeader.biPlanes = 1;
+    bitmapInfo.bmiHeader.biBitCount = 32;
+    bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+    void * bits = NULL;
+    capturedBitmap = CreateDIBSection(hDCMem, &bitmapInfo, DIB_RGB_COLORS, &bits, NULL, 0);
+
+    if (capturedBitmap == NULL)
+    {
+        DeleteDC(hDCMem);
+        return false;
     }
 
-    HDC hDC = GetDC(hwnd);
-    capturedBitmap = CreateCompatibleBitmap(hDC, rect.right - rect.left, rect.bottom - rect.top);
-    ReleaseDC(hwnd, hDC);
-   
     HGDIOBJ oldObject = SelectObject(hDCMem, capturedBitmap);
     SendMessage(hwnd, WM_PRINT, (WPARAM) hDCMem, PRF_CHILDREN | PRF_CLIENT | PRF_ERASEBKGND | PRF_OWNED);
 
     SelectObject(hDCMem, oldObject);
-    DeleteObject(hDCMem);
+    DeleteDC(hDCMem);
+
+    GdiFlush();
+
+    capturedPixels = static_cast<unsigned char *>(bits);
+
+    // GDI leaves the fourth byte undefined, raw output gets opaque pixels
+    const int pixelCount = capturedWidth * capturedHeight;
+
+    for (int i = 0; i < pixelCount; ++i)
+    {
+        capturedPixels[i * 4 + 3] = 0xFF;
+    }
 
     return true;
 }
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../gdipp-conf-editor/local_types.h"
+#include "../gdipp_preview_renderer/rendered_image.h"
 
 #include <windows.h>
 
@@ -33,15 +34,22 @@ public:
     ~DemoRender();
     void RenderToFile(const MetaString & text);
 
+    // saves an image rendered by the preview renderer, e.g. a sweep sheet
+    void SaveToFile(const GDIPPRenderer::RenderedImage & image);
+
 private:
     MetaString outputFileName;
     MetaString textToRender;
-    ULONG_PTR gdiplusToken;
+
+    // 32-bit top-down DIB section, the bits are written out row by row
     HBITMAP capturedBitmap;
+    unsigned char * capturedPixels;
+    int capturedWidth;
+    int capturedHeight;
+
     bool stopMessageLoop;
 
     static INT_PTR CALLBACK MainDlgProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
 
-    bool GetEncoderClsid(const MetaString & format, CLSID * clsid) const;
     bool CaptureWindowContents(HWND hwnd);
 };
@@ -21,14 +21,216 @@
 */
 
 #include <windows.h>
+#include <io.h>
+#include <fcntl.h>
 
 #include <stdexcept>
 #include <iostream>
+#include <fstream>
 
 #include "demo_render.h"
 #include "commandline.h"
 
 #include "../gdipp-conf-editor/local_types.h"
+#include "../gdipp-conf-editor/util.h"
+#include "../gdipp-conf-editor/trace.h"
+#include "../gdipp-conf-editor/metrics.h"
+#include "../gdipp-conf-editor/gdipp_configuration_reader.h"
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+#include "../gdipp_preview_renderer/parameter_sweep.h"
+#include "../gdipp_preview_renderer/batch_renderer.h"
+#include "../gdipp_preview_renderer/glyph_atlas.h"
+#include "../gdipp_preview_renderer/image_writer.h"
+#include "../gdipp_preview_renderer/perceptual_metrics.h"
+
+static GDIPPConfiguration::Values ReadSettings(const CommandLine & commandLine)
+{
+    // settings=<gdipp_setting.xml>, the defaults when not given
+    GDIPPConfiguration::Values values;
+    const MetaString settingsFileName = commandLine.Get(TEXT("settings"));
+
+    if (!settingsFileName.empty())
+    {
+        values = GDIPPConfiguration::Reader(settingsFileName).GetValues();
+    }
+
+    return values;
+}
+
+static GDIPPRenderer::RenderedImage RenderSweep(const CommandLine & commandLine,
+                                                const MetaString & textToRender)
+{
+    /*
+    *   sweep="hinting=0,1,2;lcd_filter=0,1,2,16" font=<ttf file>
+    *   [settings=<gdipp_setting.xml>] [metrics=<file.csv>] - renders every
+    *   combination with the portable renderer on top of the settings, one
+    *   contact sheet. metrics= also writes the perceptual metrics of every
+    *   combination, one CSV row each, for ranking them.
+    */
+
+    GDIPP_TRACE_SCOPE("RenderSweep");
+
+    GDIPPRenderer::PreviewRequest request;
+    request.fontFileName = commandLine.Get(TEXT("font"));
+
+    if (request.fontFileName.empty())
+    {
+        throw std::runtime_error("Unable to start. Missing `font` parameter.");
+    }
+
+    request.lines.push_back(Util::MetaStringToUnicode(textToRender));
+    request.lines.push_back(L"ABCDEFGHIJKLMNOPQRSTUWXYZ 0123456789");
+    request.pixelSizes.push_back(11);
+    request.pixelSizes.push_back(13);
+    request.pixelSizes.push_back(16);
+
+    GDIPPRenderer::ParameterSweep sweep(ReadSettings(commandLine), GDIPPRenderer::ParseSweepAxes(commandLine.Get(TEXT("sweep"))));
+
+    const MetaString metricsFileName = commandLine.Get(TEXT("metrics"));
+
+    if (!metricsFileName.empty())
+    {
+        GDIPP_TRACE_SCOPE("MeasureSweep");
+
+        std::ofstream metricsFile(metricsFileName.c_str());
+
+        if (!metricsFile)
+        {
+            throw std::runtime_error("Unable to create metrics file: " + Util::MetaStringToAnsi(metricsFileName));
+        }
+
+        // the contact sheet renders them again from the glyph cache
+        const std::vector<GDIPPRenderer::RenderedImage> images = sweep.RenderVariants(request);
+        const std::vector<GDIPPRenderer::SweepVariant> & variants = sweep.GetVariants();
+
+        GDIPPRenderer::WriteMetricsCsvHeader(metricsFile);
+
+        for (size_t i = 0; i < images.size(); ++i)
+        {
+            GDIPPRenderer::WriteMetricsCsvRow(metricsFile,
+                                              Util::MetaStringToAnsi(variants[i].label),
+                                              GDIPPRenderer::MeasureImage(images[i], request.foreground, request.background));
+        }
+
+        if (!metricsFile)
+        {
+            throw std::runtime_error("Unable to write metrics file: " + Util::MetaStringToAnsi(metricsFileName));
+        }
+    }
+
+    return sweep.RenderContactSheet(request);
+}
+
+static int RunBatch(const CommandLine & commandLine)
+{
+    /*
+    *   batch=<manifest>|- [results=<file>] [font=<ttf file>]
+    *   [settings=<gdipp_setting.xml>] - renders every job of the manifest
+    *   (see ParseBatchJob) in this one process, one result record per job
+    *   on stdout, or in the results file. Returns the failed job count.
+    */
+
+    GDIPP_TRACE_SCOPE("RunBatch");
+
+    const MetaString manifestFileName = commandLine.Get(TEXT("batch"));
+    const MetaString resultsFileName = commandLine.Get(TEXT("results"));
+
+    std::ifstream manifestFile;
+    std::ofstream resultsFile;
+
+    if (manifestFileName != TEXT("-"))
+    {
+        manifestFile.open(manifestFileName.c_str());
+
+        if (!manifestFile)
+        {
+            throw std::runtime_error("Unable to open job manifest: " + Util::MetaStringToAnsi(manifestFileName));
+        }
+    }
+
+    if (!resultsFileName.empty())
+    {
+        resultsFile.open(resultsFileName.c_str());
+
+        if (!resultsFile)
+        {
+            throw std::runtime_error("Unable to create results file: " + Util::MetaStringToAnsi(resultsFileName));
+        }
+    }
+
+    // frames of output=- jobs
+    std::cout.flush();
+    _setmode(_fileno(stdout), _O_BINARY);
+
+    GDIPPRenderer::PreviewRequest defaults;
+    defaults.fontFileName = commandLine.Get(TEXT("font"));
+
+    GDIPPRenderer::BatchRenderer batch(ReadSettings(commandLine));
+
+    const size_t failed = batch.Run(manifestFile.is_open() ? static_cast<std::istream &>(manifestFile) : std::cin,
+                                    resultsFile.is_open() ? static_cast<std::ostream &>(resultsFile) : std::cout,
+                                    defaults);
+
+    return static_cast<int>(failed);
+}
+
+static void RenderAtlas(const CommandLine & commandLine)
+{
+    /*
+    *   atlas=<atlas file> font=<ttf file> [size=<pixels>] [chars=<text>]
+    *   [settings=<gdipp_setting.xml>] [output=<image>] - renders every
+    *   character on its own (printable ASCII by default) into a glyph
+    *   atlas, see GlyphAtlas for the file layout. output also saves the
+    *   atlas as an image.
+    */
+
+    GDIPP_TRACE_SCOPE("RenderAtlas");
+
+    GDIPPRenderer::PreviewRequest request;
+    request.fontFileName = commandLine.Get(TEXT("font"));
+
+    if (request.fontFileName.empty())
+    {
+        throw std::runtime_error("Unable to start. Missing `font` parameter.");
+    }
+
+    const MetaString size = commandLine.Get(TEXT("size"));
+    request.pixelSizes.assign(1, size.empty() ? 16 : Util::TryIntFromStr(size, INT_MIN));
+
+    if (!Util::ValueInRange(request.pixelSizes[0], 1, 512))
+    {
+        throw std::runtime_error("Invalid `size` parameter.");
+    }
+
+    std::wstring characters = Util::MetaStringToUnicode(commandLine.Get(TEXT("chars")));
+
+    if (characters.empty())
+    {
+        for (wchar_t character = 0x20; character < 0x7F; ++character)
+        {
+            characters += character;
+        }
+    }
+
+    GDIPPRenderer::SoftwareRenderer renderer;
+    GDIPPRenderer::GlyphAtlas atlas;
+
+    atlas.Build(renderer, request, ReadSettings(commandLine), GDIPPRenderer::GetCodePoints(characters));
+    atlas.Save(commandLine.Get(TEXT("atlas")));
+
+    const MetaString outputFileName = commandLine.Get(TEXT("output"));
+
+    if (!outputFileName.empty())
+    {
+        if (outputFileName == TEXT("-"))
+        {
+            std::cout.flush();
+            _setmode(_fileno(stdout), _O_BINARY);
+        }
+
+        GDIPPRenderer::SaveImage(atlas.GetImage(), outputFileName);
+    }
+}
 
 #if defined(UNICODE) || defined(_UNICODE)
 INT APIENTRY wWinMain(HINSTANCE thisInstance,
@@ -48,6 +250,25 @@ INT APIENTRY WinMain(HINSTANCE thisInstance,
     try
     {
         CommandLine commandLine;
+
+        // trace=<file>, Chrome trace of this run
+        Trace::Session traceSession(commandLine.Get(TEXT("trace")));
+
+        // --stats, latency histograms and counters on stderr, stdout may
+        // carry image frames
+        Metrics::Report statsReport(!commandLine.Get(TEXT("--stats")).empty(), std::cerr);
+
+        if (!commandLine.Get(TEXT("batch")).empty())
+        {
+            return RunBatch(commandLine);
+        }
+
+        if (!commandLine.Get(TEXT("atlas")).empty())
+        {
+            RenderAtlas(commandLine);
+            return 0;
+        }
+
         MetaString outputFileName = commandLine.Get(TEXT("output"));
 
         if (outputFileName.empty())
@@ -55,8 +276,24 @@ INT APIENTRY WinMain(HINSTANCE thisInstance,
             throw std::runtime_error("Unable to start. Missing `output` parameter.");
         }
 
+        if (outputFileName == TEXT("-"))
+        {
+            // output=- streams a raw frame to stdout, no newline translation
+            std::cout.flush();
+            _setmode(_fileno(stdout), _O_BINARY);
+        }
+
         demoRender = new DemoRender(outputFileName);
-        demoRender->RenderToFile(textToRender);
+
+        if (commandLine.Get(TEXT("sweep")).empty())
+        {
+            demoRender->RenderToFile(textToRender);
+        }
+        else
+        {
+            demoRender->SaveToFile(RenderSweep(commandLine, textToRender));
+        }
+
         delete demoRender;
     }
     catch (const std::exception & e)
@@ -0,0 +1,256 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "ab_preview.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "../gdipp-conf-editor/trace.h"
+
+#include "image_compare.h"
+
+namespace GDIPPRenderer
+{
+    // the image on a background of the given size, at the top left
+    static void PadImage(const RenderedImage & image,
+                         int width,
+                         int height,
+                         unsigned int background,
+                         RenderedImage & padded)
+    {
+        padded.Resize(width, height, background);
+        padded.Draw(image, 0, 0);
+    }
+
+    // grows bounds, empty when its width is 0, by the pixels of the tile
+    // that differ between the images, i.e. the ink of the glyphs an edit
+    // changed; false when the tile is the same in both
+    static bool FindChangedPixels(const RenderedImage & first,
+                                  const RenderedImage & second,
+                                  int x,
+                                  int y,
+                                  int width,
+                                  int height,
+                                  ImageTile & bounds)
+    {
+        bool changed = false;
+
+        for (int row = y; row < y + height; ++row)
+        {
+            const unsigned int * firstRow = reinterpret_cast<const unsigned int*>(first.GetRow(row)) + x;
+            const unsigned int * secondRow = reinterpret_cast<const unsigned int*>(second.GetRow(row)) + x;
+
+            if (memcmp(firstRow, secondRow, static_cast<size_t>(width) * 4) == 0)
+            {
+                continue;
+            }
+
+            int left = 0;
+            int right = width;
+
+            while (firstRow[left] == secondRow[left])
+            {
+                ++left;
+            }
+
+            while (firstRow[right - 1] == secondRow[right - 1])
+            {
+                --right;
+            }
+
+            if (bounds.width == 0)
+            {
+                bounds = ImageTile(x + left, row, right - left, 1);
+            }
+            else
+            {
+                const int boundsRight = std::max(bounds.x + bounds.width, x + right);
+                const int boundsBottom = std::max(bounds.y + bounds.height, row + 1);
+
+                bounds.x = std::min(bounds.x, x + left);
+                bounds.y = std::min(bounds.y, row);
+                bounds.width = boundsRight - bounds.x;
+                bounds.height = boundsBottom - bounds.y;
+            }
+
+            changed = true;
+        }
+
+        return changed;
+    }
+
+    static void CopyTile(const RenderedImage & source,
+                         int x,
+                         int y,
+                         int width,
+                         int height,
+                         RenderedImage & destination,
+                         int destinationX)
+    {
+        for (int row = y; row < y + height; ++row)
+        {
+            memcpy(destination.GetRow(row) + (destinationX + x) * 4,
+                   source.GetRow(row) + x * 4,
+                   static_cast<size_t>(width) * 4);
+        }
+    }
+
+    ABPreview::ABPreview(int threadCount)
+        : currentRenderer(threadCount, &glyphCache),
+          candidateRenderer(threadCount, &glyphCache),
+          sheetBackground(0)
+    {
+        imageGenerations[0] = 0;
+        imageGenerations[1] = 0;
+    }
+
+    void ABPreview::RedrawTile(const ImageTile & tile, const bool sideChanged[2])
+    {
+        DrawDifferenceHeatmapInTile(panels[0], panels[1], panels[2], tile.x, tile.y, tile.width, tile.height);
+
+        // the heatmap and the sides that changed, usually the candidate only
+        for (int panel = 0; panel < 3; ++panel)
+        {
+            if (panel < 2 && !sideChanged[panel])
+            {
+                continue;
+            }
+
+            const int panelX = panel * (panels[0].GetWidth() + PanelGap);
+
+            CopyTile(panels[panel], tile.x, tile.y, tile.width, tile.height, sheet, panelX);
+            changedTiles.push_back(ImageTile(panelX + tile.x, tile.y, tile.width, tile.height));
+        }
+    }
+
+    const RenderedImage & ABPreview::Render(const PreviewRequest & request,
+                                            const GDIPPConfiguration::Values & current,
+                                            const GDIPPConfiguration::Values & candidate)
+    {
+        GDIPP_TRACE_SCOPE("ABPreview::Render");
+
+        // unchanged values run no stage and return the image of the last run
+        const RenderedImage & currentImage = currentRenderer.Render(request, current);
+        const RenderedImage & candidateImage = candidateRenderer.Render(request, candidate);
+
+        const RenderedImage * images[2] = { &currentImage, &candidateImage };
+        const unsigned int generations[2] =
+        {
+            currentRenderer.GetImageGeneration(),
+            candidateRenderer.GetImageGeneration()
+        };
+
+        const int width = std::max(currentImage.GetWidth(), candidateImage.GetWidth());
+        const int height = std::max(currentImage.GetHeight(), candidateImage.GetHeight());
+
+        changedTiles.clear();
+
+        // the gaps between the panels are never redrawn by tiles
+        if (width != panels[0].GetWidth() || height != panels[0].GetHeight() || request.background != sheetBackground)
+        {
+            GDIPP_TRACE_SCOPE("ABPreview::RedrawSheet");
+
+            PadImage(currentImage, width, height, request.background, panels[0]);
+            PadImage(candidateImage, width, height, request.background, panels[1]);
+            panels[2].Resize(width, height, 0);
+            DrawDifferenceHeatmapInTile(panels[0], panels[1], panels[2], 0, 0, width, height);
+
+            sheet.Resize(width * 3 + PanelGap * 2, height, request.background);
+            sheetBackground = request.background;
+
+            for (int panel = 0; panel < 3; ++panel)
+            {
+                sheet.Draw(panels[panel], panel * (width + PanelGap), 0);
+            }
+
+            changedTiles.push_back(ImageTile(0, 0, sheet.GetWidth(), sheet.GetHeight()));
+
+            imageGenerations[0] = generations[0];
+            imageGenerations[1] = generations[1];
+
+            return sheet;
+        }
+
+        // only a side whose renderer produced a new image is compared,
+        // neither when the edit changed nothing
+        bool sideRendered[2];
+        const RenderedImage * sides[2];
+
+        for (int side = 0; side < 2; ++side)
+        {
+            sideRendered[side] = generations[side] != imageGenerations[side];
+            imageGenerations[side] = generations[side];
+
+            // the smaller side is padded, the other is compared as it is
+            sides[side] = images[side];
+
+            if (sideRendered[side] && (images[side]->GetWidth() != width || images[side]->GetHeight() != height))
+            {
+                PadImage(* images[side], width, height, request.background, paddedSides[side]);
+                sides[side] = &paddedSides[side];
+            }
+        }
+
+        if (!sideRendered[0] && !sideRendered[1])
+        {
+            return sheet;
+        }
+
+        GDIPP_TRACE_SCOPE("ABPreview::RedrawTiles");
+
+        for (int y = 0; y < height; y += TileSize)
+        {
+            const int tileHeight = std::min(static_cast<int>(TileSize), height - y);
+
+            for (int x = 0; x < width; x += TileSize)
+            {
+                const int tileWidth = std::min(static_cast<int>(TileSize), width - x);
+                ImageTile changed(0, 0, 0, 0);
+                bool sideChanged[2];
+
+                for (int side = 0; side < 2; ++side)
+                {
+                    sideChanged[side] = sideRendered[side] &&
+                                        FindChangedPixels(panels[side], * sides[side], x, y, tileWidth, tileHeight, changed);
+                }
+
+                if (changed.width == 0)
+                {
+                    continue;
+                }
+
+                for (int side = 0; side < 2; ++side)
+                {
+                    if (sideChanged[side])
+                    {
+                        CopyTile(* sides[side], changed.x, changed.y, changed.width, changed.height, panels[side], 0);
+                    }
+                }
+
+                RedrawTile(changed, sideChanged);
+            }
+        }
+
+        return sheet;
+    }
+} // namespace GDIPPRenderer
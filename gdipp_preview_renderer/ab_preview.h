@@ -0,0 +1,113 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+
+#include "preview_renderer.h"
+#include "rendered_image.h"
+#include "software_renderer.h"
+#include "glyph_cache.h"
+
+namespace GDIPPRenderer
+{
+    class ImageTile
+    {
+    public:
+        ImageTile(int x, int y, int width, int height)
+            : x(x), y(y), width(width), height(height)
+        {
+
+        }
+
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    class ABPreview
+    {
+        /*
+        *   The current and the candidate values side by side, followed by
+        *   the heatmap of their difference: current | candidate | difference.
+        *
+        *   Each side has a renderer of its own, sharing one glyph cache, so
+        *   editing one side re-runs only the stages of that side which
+        *   depend on the edited field. The sides are then compared in
+        *   tiles; in each tile only the bounding box of the changed pixels,
+        *   the glyphs the edit changed, is redrawn, and only in the heatmap
+        *   and the side that changed.
+        */
+
+    public:
+        static const int TileSize = 64;
+
+        // background pixels between the panels
+        static const int PanelGap = 8;
+
+        explicit ABPreview(int threadCount = 0);
+
+        // sides of different sizes are padded with the background color to
+        // the larger one
+        const RenderedImage & Render(const PreviewRequest & request,
+                                     const GDIPPConfiguration::Values & current,
+                                     const GDIPPConfiguration::Values & candidate);
+
+        const RenderedImage & GetSheet() const
+        {
+            return sheet;
+        }
+
+        // sheet rectangles the last Render redrew, at most one per panel and
+        // tile; the whole sheet when its size changed
+        const std::vector<ImageTile> & GetChangedTiles() const
+        {
+            return changedTiles;
+        }
+
+    private:
+        GlyphCache glyphCache;
+        SoftwareRenderer currentRenderer;
+        SoftwareRenderer candidateRenderer;
+
+        // current, candidate, heatmap; all of one size
+        RenderedImage panels[3];
+        RenderedImage sheet;
+        unsigned int sheetBackground;
+
+        // SoftwareRenderer::GetImageGeneration of the images in the panels,
+        // and the buffers a side smaller than the other is padded in
+        unsigned int imageGenerations[2];
+        RenderedImage paddedSides[2];
+        std::vector<ImageTile> changedTiles;
+
+        // tile in panel coordinates
+        void RedrawTile(const ImageTile & tile, const bool sideChanged[2]);
+
+        ABPreview(const ABPreview &);
+        ABPreview & operator=(const ABPreview &);
+    };
+}
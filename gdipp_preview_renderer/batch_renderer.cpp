@@ -0,0 +1,264 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "batch_renderer.h"
+
+#include <iostream>
+#include <stdexcept>
+
+#include "../gdipp-conf-editor/util.h"
+
+#include "image_writer.h"
+
+namespace GDIPPRenderer
+{
+    static std::vector<std::string> SplitFields(const std::string & line)
+    {
+        std::vector<std::string> fields;
+        size_t begin = 0;
+
+        while (true)
+        {
+            const size_t end = line.find('\t', begin);
+
+            if (end == std::string::npos)
+            {
+                fields.push_back(line.substr(begin));
+                break;
+            }
+
+            fields.push_back(line.substr(begin, end - begin));
+            begin = end + 1;
+        }
+
+        return fields;
+    }
+
+    // the message in quotes, with quotes, backslashes and line breaks
+    // escaped so the record stays on one line
+    static std::string QuoteMessage(const char * message)
+    {
+        std::string quoted = "\"";
+
+        for (const char * c = message; *c != '\0'; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                quoted += '\\';
+                quoted += *c;
+            }
+            else if (*c == '\n')
+            {
+                quoted += "\\n";
+            }
+            else if (*c == '\r')
+            {
+                quoted += "\\r";
+            }
+            else
+            {
+                quoted += *c;
+            }
+        }
+
+        quoted += "\"";
+
+        return quoted;
+    }
+
+    static std::vector<std::wstring> ParseText(const std::string & text)
+    {
+        std::vector<std::wstring> lines;
+        std::string current;
+
+        for (size_t i = 0; i < text.length(); ++i)
+        {
+            if (text[i] != '\\' || i + 1 == text.length())
+            {
+                current += text[i];
+                continue;
+            }
+
+            const char escaped = text[++i];
+
+            if (escaped == 'n')
+            {
+                lines.push_back(Util::AnsiToUnicode(current));
+                current.clear();
+            }
+            else if (escaped == 't')
+            {
+                current += '\t';
+            }
+            else
+            {
+                current += escaped;
+            }
+        }
+
+        lines.push_back(Util::AnsiToUnicode(current));
+
+        return lines;
+    }
+
+    static std::vector<int> ParsePixelSizes(const std::string & text)
+    {
+        std::vector<int> pixelSizes;
+        size_t begin = 0;
+
+        while (begin <= text.length())
+        {
+            size_t end = text.find(',', begin);
+
+            if (end == std::string::npos)
+            {
+                end = text.length();
+            }
+
+            const int pixelSize = Util::TryIntFromStr(Util::CreateMetaString(text.substr(begin, end - begin)), INT_MIN);
+
+            if (!Util::ValueInRange(pixelSize, 1, 512))
+            {
+                throw std::runtime_error("Invalid pixel size in the job: " + text);
+            }
+
+            pixelSizes.push_back(pixelSize);
+            begin = end + 1;
+        }
+
+        return pixelSizes;
+    }
+
+    bool ParseBatchJob(const std::string & line, const PreviewRequest & defaults, BatchJob & job)
+    {
+        std::string trimmed = line;
+
+        // manifests written on Windows
+        if (!trimmed.empty() && trimmed[trimmed.length() - 1] == '\r')
+        {
+            trimmed.erase(trimmed.length() - 1);
+        }
+
+        if (trimmed.find_first_not_of(" \t") == std::string::npos || trimmed[0] == '#')
+        {
+            return false;
+        }
+
+        const std::vector<std::string> fields = SplitFields(trimmed);
+
+        if (fields.size() != 4)
+        {
+            throw std::runtime_error("A job needs 4 tab separated fields: output, font, pixel sizes, text.");
+        }
+
+        if (fields[0].empty())
+        {
+            throw std::runtime_error("The job has no output.");
+        }
+
+        job.outputFileName = Util::CreateMetaString(fields[0]);
+        job.request = defaults;
+
+        if (!fields[1].empty())
+        {
+            job.request.fontFileName = Util::CreateMetaString(fields[1]);
+        }
+
+        if (!fields[2].empty())
+        {
+            job.request.pixelSizes = ParsePixelSizes(fields[2]);
+        }
+
+        if (!fields[3].empty())
+        {
+            job.request.lines = ParseText(fields[3]);
+        }
+
+        return true;
+    }
+
+    BatchRenderer::BatchRenderer(const GDIPPConfiguration::Values & values, int threadCount)
+        : values(values),
+          renderer(threadCount)
+    {
+
+    }
+
+    size_t BatchRenderer::Run(std::istream & manifest,
+                              std::ostream & results,
+                              const PreviewRequest & defaults)
+    {
+        std::string line;
+        size_t lineNumber = 0;
+        size_t jobNumber = 0;
+        size_t failed = 0;
+
+        while (std::getline(manifest, line))
+        {
+            ++lineNumber;
+
+            BatchJob job;
+
+            try
+            {
+                if (!ParseBatchJob(line, defaults, job))
+                {
+                    continue;
+                }
+            }
+            catch (const std::exception & e)
+            {
+                results << "job=" << ++jobNumber << " line=" << lineNumber
+                        << " status=error message=" << QuoteMessage(e.what()) << std::endl;
+                ++failed;
+                continue;
+            }
+
+            ++jobNumber;
+
+            try
+            {
+                // frames and records would be interleaved on one stream
+                if (job.outputFileName == TEXT("-") && &results == &std::cout)
+                {
+                    throw std::runtime_error("Frames on the standard output need the results written elsewhere.");
+                }
+
+                const RenderedImage & image = renderer.Render(job.request, values);
+                SaveImage(image, job.outputFileName);
+
+                results << "job=" << jobNumber << " line=" << lineNumber
+                        << " status=ok output=" << Util::MetaStringToAnsi(job.outputFileName)
+                        << " width=" << image.GetWidth()
+                        << " height=" << image.GetHeight() << std::endl;
+            }
+            catch (const std::exception & e)
+            {
+                results << "job=" << jobNumber << " line=" << lineNumber
+                        << " status=error message=" << QuoteMessage(e.what()) << std::endl;
+                ++failed;
+            }
+        }
+
+        return failed;
+    }
+} // namespace GDIPPRenderer
@@ -0,0 +1,90 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <istream>
+#include <ostream>
+
+#include "../gdipp-conf-editor/local_types.h"
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+
+#include "preview_renderer.h"
+#include "software_renderer.h"
+
+namespace GDIPPRenderer
+{
+    class BatchJob
+    {
+    public:
+        // written by SaveImage, "-" is a frame on the standard output
+        MetaString outputFileName;
+        PreviewRequest request;
+    };
+
+    // One job per manifest line, fields separated by tabs:
+    //
+    //   output <TAB> font <TAB> pixel sizes <TAB> text
+    //
+    // e.g. "a.png\tarial.ttf\t11,13,16\tHello\nWorld". Pixel sizes are
+    // comma separated, the text may contain \n (line break), \t and \\.
+    // Empty font, sizes or text keep the ones of the defaults request.
+    // Returns false for blank lines and # comments, throws
+    // std::runtime_error for malformed ones.
+    extern bool ParseBatchJob(const std::string & line, const PreviewRequest & defaults, BatchJob & job);
+
+    class BatchRenderer
+    {
+        /*
+        *   Renders a stream of jobs with one renderer, so the font, the
+        *   glyph cache and every stage which does not change between jobs
+        *   stay warm. A job failing does not stop the batch.
+        */
+
+    public:
+        BatchRenderer(const GDIPPConfiguration::Values & values, int threadCount = 0);
+
+        // reads the manifest until its end and writes one result record
+        // line per job as soon as the job is done:
+        //
+        //   job=3 line=5 status=ok output=a.png width=420 height=96
+        //   job=4 line=6 status=error message="..."
+        //
+        // quotes, backslashes and line breaks in the message are escaped
+        // with a backslash (\", \\, \n, \r)
+        //
+        // returns the number of failed jobs
+        size_t Run(std::istream & manifest,
+                   std::ostream & results,
+                   const PreviewRequest & defaults = PreviewRequest());
+
+        SoftwareRenderer & GetRenderer()
+        {
+            return renderer;
+        }
+
+    private:
+        GDIPPConfiguration::Values values;
+        SoftwareRenderer renderer;
+    };
+}
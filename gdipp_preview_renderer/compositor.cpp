@@ -0,0 +1,283 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "compositor.h"
+
+#include <algorithm>
+
+#include "simd.h"
+
+namespace GDIPPRenderer
+{
+    // a tile of 256 x 32 BGRA pixels (32 KiB) stays in the cache
+    // while all the layers are blended into it
+    static const int TileWidth = 256;
+    static const int TileHeight = 32;
+
+    static inline unsigned char BlendChannel(int destination, int source, int coverage)
+    {
+        // (destination * (255 - coverage) + source * coverage) / 255, rounded
+        int value = destination * (255 - coverage) + source * coverage + 128;
+        return static_cast<unsigned char>((value + (value >> 8)) >> 8);
+    }
+
+    static void BuildAlphaTable(unsigned char * table, int alpha)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            table[i] = static_cast<unsigned char>((i * alpha + 127) / 255);
+        }
+    }
+
+    static bool ExpandCoverage(const unsigned char * source,
+                               unsigned char * destination,
+                               int count,
+                               const unsigned char * alphaTable)
+    {
+        /*
+        *   R, G, B coverage triplets -> alpha scaled B, G, R, 0 quads matching
+        *   the pixel layout. Returns false when the whole span is empty.
+        */
+
+        unsigned int any = 0;
+
+        for (int x = 0; x < count; ++x)
+        {
+            const unsigned char * coverage = &source[x * 3];
+            unsigned char * quad = &destination[x * 4];
+
+            quad[0] = alphaTable[coverage[2]];
+            quad[1] = alphaTable[coverage[1]];
+            quad[2] = alphaTable[coverage[0]];
+            quad[3] = 0;
+
+            any |= quad[0] | quad[1] | quad[2];
+        }
+
+        return any != 0;
+    }
+
+    static void BlendSpan(unsigned char * pixels,
+                          const unsigned char * coverage,
+                          int count,
+                          unsigned int color)
+    {
+        /*
+        *   Blends count pixels, coverage holds B, G, R, 0 quads. Zero coverage
+        *   of the alpha byte keeps the destination alpha unchanged.
+        */
+
+        const int red = (color >> 16) & 0xFF;
+        const int green = (color >> 8) & 0xFF;
+        const int blue = color & 0xFF;
+
+        int x = 0;
+
+#if defined(GDIPP_SIMD_AVX2)
+        const __m256i zero256 = _mm256_setzero_si256();
+        const __m256i full256 = _mm256_set1_epi16(255);
+        const __m256i half256 = _mm256_set1_epi16(128);
+        const __m256i color256 = _mm256_setr_epi16(
+            static_cast<short>(blue), static_cast<short>(green), static_cast<short>(red), 0,
+            static_cast<short>(blue), static_cast<short>(green), static_cast<short>(red), 0,
+            static_cast<short>(blue), static_cast<short>(green), static_cast<short>(red), 0,
+            static_cast<short>(blue), static_cast<short>(green), static_cast<short>(red), 0);
+
+        for (; x + 8 <= count; x += 8)
+        {
+            __m256i destination = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + x * 4));
+            __m256i weights = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(coverage + x * 4));
+
+            __m256i result[2];
+
+            for (int half = 0; half < 2; ++half)
+            {
+                __m256i d = half == 0 ? _mm256_unpacklo_epi8(destination, zero256) :
+                                        _mm256_unpackhi_epi8(destination, zero256);
+                __m256i w = half == 0 ? _mm256_unpacklo_epi8(weights, zero256) :
+                                        _mm256_unpackhi_epi8(weights, zero256);
+
+                // 16-bit arithmetic wraps, the largest value (65407) still fits unsigned
+                __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(d, _mm256_sub_epi16(full256, w)),
+                                             _mm256_mullo_epi16(color256, w));
+                v = _mm256_add_epi16(v, half256);
+                result[half] = _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)), 8);
+            }
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + x * 4),
+                                _mm256_packus_epi16(result[0], result[1]));
+        }
+#endif
+
+#if defined(GDIPP_SIMD_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(255);
+        const __m128i half128 = _mm_set1_epi16(128);
+        const __m128i color128 = _mm_setr_epi16(
+            static_cast<short>(blue), static_cast<short>(green), static_cast<short>(red), 0,
+            static_cast<short>(blue), static_cast<short>(green), static_cast<short>(red), 0);
+
+        for (; x + 4 <= count; x += 4)
+        {
+            __m128i destination = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x * 4));
+            __m128i weights = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coverage + x * 4));
+
+            __m128i result[2];
+
+            for (int half = 0; half < 2; ++half)
+            {
+                __m128i d = half == 0 ? _mm_unpacklo_epi8(destination, zero) :
+                                        _mm_unpackhi_epi8(destination, zero);
+                __m128i w = half == 0 ? _mm_unpacklo_epi8(weights, zero) :
+                                        _mm_unpackhi_epi8(weights, zero);
+
+                __m128i v = _mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(full, w)),
+                                          _mm_mullo_epi16(color128, w));
+                v = _mm_add_epi16(v, half128);
+                result[half] = _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + x * 4),
+                             _mm_packus_epi16(result[0], result[1]));
+        }
+#endif
+
+        for (; x < count; ++x)
+        {
+            unsigned char * pixel = &pixels[x * 4];
+            const unsigned char * weight = &coverage[x * 4];
+
+            pixel[0] = BlendChannel(pixel[0], blue, weight[0]);
+            pixel[1] = BlendChannel(pixel[1], green, weight[1]);
+            pixel[2] = BlendChannel(pixel[2], red, weight[2]);
+        }
+    }
+
+    void CompositeLayersInTile(RenderedImage & image,
+                               const std::vector<CoverageLayer> & layers,
+                               unsigned int color,
+                               int tileX,
+                               int tileY,
+                               int tileWidth,
+                               int tileHeight)
+    {
+        unsigned char alphaTable[256];
+        unsigned char span[TileWidth * 4];
+
+        const int tileRight = std::min(image.GetWidth(), tileX + tileWidth);
+        const int tileBottom = std::min(image.GetHeight(), tileY + tileHeight);
+
+        for (size_t i = 0; i < layers.size(); ++i)
+        {
+            const CoverageLayer & layer = layers[i];
+            const CoverageBitmap & channels = *layer.channels;
+
+            if (layer.alpha <= 0)
+            {
+                continue;
+            }
+
+            // intersection of the tile and the layer
+            const int beginX = std::max(tileX, layer.offsetX);
+            const int endX = std::min(tileRight, channels.GetWidth() / 3 + layer.offsetX);
+            const int beginY = std::max(tileY, layer.offsetY);
+            const int endY = std::min(tileBottom, channels.GetHeight() + layer.offsetY);
+
+            if (beginX >= endX || beginY >= endY)
+            {
+                continue;
+            }
+
+            BuildAlphaTable(alphaTable, std::min(layer.alpha, 255));
+
+            for (int y = beginY; y < endY; ++y)
+            {
+                const unsigned char * source = channels.GetRow(y - layer.offsetY);
+                unsigned char * destination = image.GetRow(y);
+
+                for (int x = beginX; x < endX; x += TileWidth)
+                {
+                    const int count = std::min(TileWidth, endX - x);
+
+                    if (ExpandCoverage(&source[(x - layer.offsetX) * 3], span, count, alphaTable))
+                    {
+                        BlendSpan(&destination[x * 4], span, count, color);
+                    }
+                }
+            }
+        }
+    }
+
+    class CompositeTask : public ParallelTask
+    {
+    public:
+        CompositeTask(RenderedImage & image,
+                      const std::vector<CoverageLayer> & layers,
+                      unsigned int color)
+            : image(image), layers(layers), color(color)
+        {
+            columns = (image.GetWidth() + TileWidth - 1) / TileWidth;
+            rows = (image.GetHeight() + TileHeight - 1) / TileHeight;
+        }
+
+        int GetCount() const
+        {
+            return columns * rows;
+        }
+
+        virtual void Run(int index, int)
+        {
+            CompositeLayersInTile(image, layers, color,
+                                  (index % columns) * TileWidth,
+                                  (index / columns) * TileHeight,
+                                  TileWidth,
+                                  TileHeight);
+        }
+
+    private:
+        RenderedImage & image;
+        const std::vector<CoverageLayer> & layers;
+        unsigned int color;
+        int columns;
+        int rows;
+    };
+
+    void CompositeLayers(RenderedImage & image,
+                         const std::vector<CoverageLayer> & layers,
+                         unsigned int color,
+                         ThreadPool * pool)
+    {
+        CompositeTask task(image, layers, color);
+        RunParallel(pool, task, task.GetCount());
+    }
+
+    void CompositeCoverage(RenderedImage & image,
+                           const CoverageBitmap & channels,
+                           int offsetX,
+                           int offsetY,
+                           unsigned int color,
+                           int alpha)
+    {
+        std::vector<CoverageLayer> layers(1, CoverageLayer(channels, offsetX, offsetY, alpha));
+        CompositeLayers(image, layers, color);
+    }
+} // namespace GDIPPRenderer
@@ -0,0 +1,77 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "coverage_bitmap.h"
+#include "rendered_image.h"
+#include "thread_pool.h"
+
+namespace GDIPPRenderer
+{
+    class CoverageLayer
+    {
+        /*
+        *   Interleaved R, G, B coverage placed on the image at
+        *   (offsetX, offsetY) and scaled by alpha (0 - 255).
+        */
+
+    public:
+        CoverageLayer(const CoverageBitmap & channels, int offsetX, int offsetY, int alpha)
+            : channels(&channels), offsetX(offsetX), offsetY(offsetY), alpha(alpha)
+        {
+
+        }
+
+        const CoverageBitmap * channels;
+        int offsetX;
+        int offsetY;
+        int alpha;
+    };
+
+    // blends color (0x00RRGGBB) into the image through interleaved R, G, B
+    // coverage placed at (offsetX, offsetY), scaled by alpha (0 - 255)
+    extern void CompositeCoverage(RenderedImage & image,
+                                  const CoverageBitmap & channels,
+                                  int offsetX,
+                                  int offsetY,
+                                  unsigned int color,
+                                  int alpha);
+
+    // blends the layers in order, tile by tile
+    extern void CompositeLayers(RenderedImage & image,
+                                const std::vector<CoverageLayer> & layers,
+                                unsigned int color,
+                                ThreadPool * pool = NULL);
+
+    // blends the layers in order into a single rectangle of the image,
+    // tiles do not overlap so they can be processed independently
+    extern void CompositeLayersInTile(RenderedImage & image,
+                                      const std::vector<CoverageLayer> & layers,
+                                      unsigned int color,
+                                      int tileX,
+                                      int tileY,
+                                      int tileWidth,
+                                      int tileHeight);
+}
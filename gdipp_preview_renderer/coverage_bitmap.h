@@ -0,0 +1,99 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace GDIPPRenderer
+{
+    class CoverageBitmap
+    {
+        /*
+        *   8-bit coverage (alpha) plane. Rows are padded to 16 bytes so the
+        *   filter kernels can process whole vectors without a tail check.
+        */
+
+    public:
+        CoverageBitmap()
+            : width(0), height(0), stride(0)
+        {
+
+        }
+
+        CoverageBitmap(int width, int height)
+        {
+            Resize(width, height);
+        }
+
+        void Resize(int width, int height)
+        {
+            this->width = width;
+            this->height = height;
+            this->stride = (width + 15) & ~15;
+
+            pixels.assign(static_cast<size_t>(stride) * height, 0);
+        }
+
+        void Clear()
+        {
+            pixels.assign(pixels.size(), 0);
+        }
+
+        int GetWidth() const
+        {
+            return width;
+        }
+
+        int GetHeight() const
+        {
+            return height;
+        }
+
+        int GetStride() const
+        {
+            return stride;
+        }
+
+        bool IsEmpty() const
+        {
+            return width == 0 || height == 0;
+        }
+
+        unsigned char * GetRow(int y)
+        {
+            return &pixels[static_cast<size_t>(y) * stride];
+        }
+
+        const unsigned char * GetRow(int y) const
+        {
+            return &pixels[static_cast<size_t>(y) * stride];
+        }
+
+    private:
+        int width;
+        int height;
+        int stride;
+        std::vector<unsigned char> pixels;
+    };
+} // namespace GDIPPRenderer
@@ -0,0 +1,435 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "deflate_stream.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace GDIPPRenderer
+{
+    static const int LengthBase[29] =
+    {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+
+    static const int LengthExtraBits[29] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+
+    static const int DistanceBase[30] =
+    {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+
+    static const int DistanceExtraBits[30] =
+    {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+
+    static const unsigned int EndOfBlock = 256;
+
+    class FixedHuffmanCodes
+    {
+        /*
+        *   The fixed literal / length and distance codes of RFC 1951, bit
+        *   reversed so they can be written least significant bit first.
+        */
+
+    public:
+        FixedHuffmanCodes()
+        {
+            for (unsigned int symbol = 0; symbol < 288; ++symbol)
+            {
+                unsigned int code, length;
+
+                if (symbol < 144)
+                {
+                    code = 0x30 + symbol;
+                    length = 8;
+                }
+                else if (symbol < 256)
+                {
+                    code = 0x190 + symbol - 144;
+                    length = 9;
+                }
+                else if (symbol < 280)
+                {
+                    code = symbol - 256;
+                    length = 7;
+                }
+                else
+                {
+                    code = 0xC0 + symbol - 280;
+                    length = 8;
+                }
+
+                literalCodes[symbol] = static_cast<unsigned short>(Reverse(code, length));
+                literalLengths[symbol] = static_cast<unsigned char>(length);
+            }
+
+            for (unsigned int symbol = 0; symbol < 30; ++symbol)
+            {
+                distanceCodes[symbol] = static_cast<unsigned short>(Reverse(symbol, 5));
+            }
+
+            for (int symbol = 0; symbol < 29; ++symbol)
+            {
+                const int last = symbol == 28 ? 258 : LengthBase[symbol] + (1 << LengthExtraBits[symbol]) - 1;
+
+                for (int length = LengthBase[symbol]; length <= last; ++length)
+                {
+                    lengthSymbols[length] = static_cast<unsigned char>(symbol);
+                }
+            }
+
+            // distances up to 256 directly, longer ones by their upper bits
+            for (int symbol = 0; symbol < 30; ++symbol)
+            {
+                const int last = DistanceBase[symbol] + (1 << DistanceExtraBits[symbol]) - 1;
+
+                for (int distance = DistanceBase[symbol]; distance <= last; ++distance)
+                {
+                    const int index = distance <= 256 ? distance - 1 : 256 + ((distance - 1) >> 7);
+                    distanceSymbols[index] = static_cast<unsigned char>(symbol);
+                }
+            }
+        }
+
+        int GetDistanceSymbol(int distance) const
+        {
+            return distanceSymbols[distance <= 256 ? distance - 1 : 256 + ((distance - 1) >> 7)];
+        }
+
+        unsigned short literalCodes[288];
+        unsigned char literalLengths[288];
+        unsigned short distanceCodes[30];
+        unsigned char lengthSymbols[259];
+
+    private:
+        unsigned char distanceSymbols[512];
+
+        static unsigned int Reverse(unsigned int code, unsigned int length)
+        {
+            unsigned int reversed = 0;
+
+            for (unsigned int i = 0; i < length; ++i)
+            {
+                reversed = (reversed << 1) | ((code >> i) & 1);
+            }
+
+            return reversed;
+        }
+    };
+
+    static const FixedHuffmanCodes fixedCodes;
+
+    DeflateStream::DeflateStream(std::vector<unsigned char> & output, bool compress)
+        : output(output),
+          compress(compress),
+          finished(false),
+          adlerA(1),
+          adlerB(0),
+          bitBuffer(0),
+          bitCount(0),
+          blockStart(0),
+          blockBitBuffer(0),
+          blockBitCount(0),
+          coded(0)
+    {
+        // zlib header: deflate, 32 KB window, fastest
+        output.push_back(0x78);
+        output.push_back(0x01);
+
+        if (compress)
+        {
+            head.assign(1 << HashBits, -1);
+            BeginBlock();
+        }
+    }
+
+    void DeflateStream::UpdateAdler(const unsigned char * data, size_t size)
+    {
+        while (size > 0)
+        {
+            // the sums cannot overflow within 5552 bytes
+            size_t chunk = size < 5552 ? size : 5552;
+            size -= chunk;
+
+            while (chunk-- > 0)
+            {
+                adlerA += * data++;
+                adlerB += adlerA;
+            }
+
+            adlerA %= 65521;
+            adlerB %= 65521;
+        }
+    }
+
+    void DeflateStream::PutBits(unsigned int bits, int count)
+    {
+        bitBuffer |= bits << bitCount;
+        bitCount += count;
+
+        while (bitCount >= 8)
+        {
+            pending.push_back(static_cast<unsigned char>(bitBuffer & 0xFF));
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    }
+
+    void DeflateStream::PutByte(unsigned char value)
+    {
+        pending.push_back(value);
+    }
+
+    void DeflateStream::FlushBits()
+    {
+        if (bitCount > 0)
+        {
+            PutBits(0, 8 - bitCount);
+        }
+    }
+
+    void DeflateStream::PutLiteral(unsigned int literal)
+    {
+        PutBits(fixedCodes.literalCodes[literal], fixedCodes.literalLengths[literal]);
+    }
+
+    void DeflateStream::PutMatch(int length, int distance)
+    {
+        const int lengthSymbol = fixedCodes.lengthSymbols[length];
+        PutLiteral(257 + lengthSymbol);
+
+        if (LengthExtraBits[lengthSymbol] > 0)
+        {
+            PutBits(length - LengthBase[lengthSymbol], LengthExtraBits[lengthSymbol]);
+        }
+
+        const int distanceSymbol = fixedCodes.GetDistanceSymbol(distance);
+        PutBits(fixedCodes.distanceCodes[distanceSymbol], 5);
+
+        if (DistanceExtraBits[distanceSymbol] > 0)
+        {
+            PutBits(distance - DistanceBase[distanceSymbol], DistanceExtraBits[distanceSymbol]);
+        }
+    }
+
+    void DeflateStream::Write(const unsigned char * data, size_t size)
+    {
+        if (finished)
+        {
+            throw std::runtime_error("DeflateStream: write after the stream was finished.");
+        }
+
+        UpdateAdler(data, size);
+        window.insert(window.end(), data, data + size);
+
+        if (!compress)
+        {
+            while (window.size() >= StoredBlockSize)
+            {
+                WriteStoredBlock(&window[0], StoredBlockSize, false);
+                window.erase(window.begin(), window.begin() + StoredBlockSize);
+            }
+
+            CommitPending();
+            return;
+        }
+
+        CodePending();
+
+        if (window.size() > 3 * static_cast<size_t>(WindowSize))
+        {
+            SlideWindow();
+        }
+    }
+
+    void DeflateStream::CodePending()
+    {
+        /*
+        *   Greedy matching, one hash probe per position. The last two bytes
+        *   wait for more data, a match needs three.
+        */
+
+        const size_t end = window.size();
+        const unsigned char * data = window.empty() ? NULL : &window[0];
+        size_t position = coded;
+
+        while (position + MinimumMatch <= end)
+        {
+            if (position - blockStart >= BlockSize)
+            {
+                coded = position;
+                EndBlock();
+                BeginBlock();
+            }
+
+            const unsigned int key = data[position] |
+                                     (data[position + 1] << 8) |
+                                     (data[position + 2] << 16);
+            const unsigned int hash = (key * 2654435761U) >> (32 - HashBits);
+
+            const int candidate = head[hash];
+            head[hash] = static_cast<int>(position);
+
+            if (candidate >= 0 && position - candidate <= static_cast<size_t>(WindowSize))
+            {
+                const size_t available = end - position;
+                const size_t limit = available < static_cast<size_t>(MaximumMatch) ? available : MaximumMatch;
+                size_t length = 0;
+
+                while (length < limit && data[candidate + length] == data[position + length])
+                {
+                    ++length;
+                }
+
+                if (length >= static_cast<size_t>(MinimumMatch))
+                {
+                    PutMatch(static_cast<int>(length), static_cast<int>(position - candidate));
+                    position += length;
+                    continue;
+                }
+            }
+
+            PutLiteral(data[position]);
+            ++position;
+        }
+
+        coded = position;
+    }
+
+    void DeflateStream::SlideWindow()
+    {
+        // keep one window of history before the data not coded yet and
+        // the input of the open block
+        const size_t shift = std::min(coded - WindowSize, blockStart);
+
+        window.erase(window.begin(), window.begin() + shift);
+        coded -= shift;
+        blockStart -= shift;
+
+        for (size_t i = 0; i < head.size(); ++i)
+        {
+            head[i] = head[i] >= static_cast<int>(shift) ? head[i] - static_cast<int>(shift) : -1;
+        }
+    }
+
+    void DeflateStream::WriteStoredBlock(const unsigned char * data, size_t size, bool last)
+    {
+        PutBits(last ? 1 : 0, 1);
+        PutBits(0, 2);
+        FlushBits();
+
+        PutByte(static_cast<unsigned char>(size & 0xFF));
+        PutByte(static_cast<unsigned char>(size >> 8));
+        PutByte(static_cast<unsigned char>(~size & 0xFF));
+        PutByte(static_cast<unsigned char>((~size >> 8) & 0xFF));
+
+        pending.insert(pending.end(), data, data + size);
+    }
+
+    void DeflateStream::BeginBlock()
+    {
+        blockStart = coded;
+        blockBitBuffer = bitBuffer;
+        blockBitCount = bitCount;
+
+        // fixed Huffman codes, not the last block
+        PutBits(0, 1);
+        PutBits(1, 2);
+    }
+
+    void DeflateStream::EndBlock()
+    {
+        PutLiteral(EndOfBlock);
+
+        const size_t size = coded - blockStart;
+
+        // the stored block costs its data plus five header bytes
+        if (size > 0 && pending.size() > size + 5)
+        {
+            pending.clear();
+            bitBuffer = blockBitBuffer;
+            bitCount = blockBitCount;
+
+            WriteStoredBlock(&window[blockStart], size, false);
+        }
+
+        CommitPending();
+    }
+
+    void DeflateStream::CommitPending()
+    {
+        output.insert(output.end(), pending.begin(), pending.end());
+        pending.clear();
+    }
+
+    void DeflateStream::Finish()
+    {
+        if (finished)
+        {
+            return;
+        }
+
+        finished = true;
+
+        if (compress)
+        {
+            for (size_t position = coded; position < window.size(); ++position)
+            {
+                PutLiteral(window[position]);
+            }
+
+            coded = window.size();
+            EndBlock();
+
+            // an empty last block, the others were not marked as last
+            PutBits(1, 1);
+            PutBits(1, 2);
+            PutLiteral(EndOfBlock);
+            FlushBits();
+        }
+        else
+        {
+            WriteStoredBlock(window.empty() ? NULL : &window[0], window.size(), true);
+        }
+
+        window.clear();
+
+        const unsigned int adler = (adlerB << 16) | adlerA;
+
+        PutByte(static_cast<unsigned char>(adler >> 24));
+        PutByte(static_cast<unsigned char>(adler >> 16));
+        PutByte(static_cast<unsigned char>(adler >> 8));
+        PutByte(static_cast<unsigned char>(adler));
+
+        CommitPending();
+    }
+} // namespace GDIPPRenderer
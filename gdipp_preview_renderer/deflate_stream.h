@@ -0,0 +1,108 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace GDIPPRenderer
+{
+    class DeflateStream
+    {
+        /*
+        *   zlib (RFC 1950) stream writer for image encoders. Data can be
+        *   stored uncompressed or compressed the way zlib level 1 does it:
+        *   greedy LZ77 matches found through a single hash probe, coded
+        *   with the fixed Huffman tables. Input arrives in pieces, the
+        *   compressed bytes are appended to the output block by block.
+        *   A block that comes out larger than its input, e.g. of noisy
+        *   or dithered pixels, is stored instead.
+        */
+
+    public:
+        DeflateStream(std::vector<unsigned char> & output, bool compress);
+
+        void Write(const unsigned char * data, size_t size);
+
+        // ends the stream, nothing can be written afterwards
+        void Finish();
+
+    private:
+        static const int WindowSize = 32768;
+        static const int HashBits = 15;
+        static const int MinimumMatch = 3;
+        static const int MaximumMatch = 258;
+
+        // largest stored block
+        static const size_t StoredBlockSize = 65535;
+
+        // input of a compressed block; a match starting right below the
+        // limit and the last bytes Finish codes as literals, fewer than a
+        // match, still fit one stored block
+        static const size_t BlockSize = StoredBlockSize - MaximumMatch - (MinimumMatch - 1);
+
+        std::vector<unsigned char> & output;
+        bool compress;
+        bool finished;
+
+        unsigned int adlerA;
+        unsigned int adlerB;
+
+        // bits not written to the output yet, least significant first
+        unsigned int bitBuffer;
+        int bitCount;
+
+        // coded bytes of the open block, they go to the output when the
+        // block ends
+        std::vector<unsigned char> pending;
+
+        // window position of the open block's input and the bit state
+        // before its header, to store the block instead
+        size_t blockStart;
+        unsigned int blockBitBuffer;
+        int blockBitCount;
+
+        // history kept for matches followed by the data not coded yet,
+        // positions in head are relative to the window start
+        std::vector<unsigned char> window;
+        size_t coded;
+        std::vector<int> head;
+
+        void UpdateAdler(const unsigned char * data, size_t size);
+
+        void PutBits(unsigned int bits, int count);
+        void PutByte(unsigned char value);
+        void FlushBits();
+
+        void PutLiteral(unsigned int literal);
+        void PutMatch(int length, int distance);
+
+        void BeginBlock();
+        void EndBlock();
+        void CommitPending();
+
+        void CodePending();
+        void WriteStoredBlock(const unsigned char * data, size_t size, bool last);
+        void SlideWindow();
+    };
+}
@@ -0,0 +1,390 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "embolden.h"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+
+#include "simd.h"
+
+namespace GDIPPRenderer
+{
+    static void CombineRows(const unsigned char * first,
+                            const unsigned char * second,
+                            unsigned char * destination,
+                            int count,
+                            bool dilate)
+    {
+        // count is a multiple of 16 (the coverage row stride)
+        int x = 0;
+
+#if defined(GDIPP_SIMD_AVX2)
+        for (; x + 32 <= count; x += 32)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + x));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + x));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + x),
+                                dilate ? _mm256_max_epu8(a, b) : _mm256_min_epu8(a, b));
+        }
+#endif
+
+#if defined(GDIPP_SIMD_SSE2)
+        for (; x + 16 <= count; x += 16)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + x));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + x));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x),
+                             dilate ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b));
+        }
+#endif
+
+        for (; x < count; ++x)
+        {
+            destination[x] = dilate ? std::max(first[x], second[x]) : std::min(first[x], second[x]);
+        }
+    }
+
+    static void BlendRows(const unsigned char * inner,
+                          const unsigned char * outer,
+                          unsigned char * destination,
+                          int count,
+                          int fraction,
+                          bool dilate)
+    {
+        /*
+        *   inner + (outer - inner) * fraction / 256, rounded towards minus
+        *   infinity. |outer - inner| * fraction + 255 fits in 16 bits.
+        */
+
+        int x = 0;
+
+#if defined(GDIPP_SIMD_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weight = _mm_set1_epi16(static_cast<short>(fraction));
+        const __m128i roundUp = _mm_set1_epi16(dilate ? 0 : 255);
+
+        for (; x + 16 <= count; x += 16)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inner + x));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(outer + x));
+
+            // distance between the two windows, always non-negative
+            __m128i difference = dilate ? _mm_subs_epu8(b, a) : _mm_subs_epu8(a, b);
+
+            __m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(difference, zero), weight), roundUp);
+            __m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(difference, zero), weight), roundUp);
+            __m128i step = _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x),
+                             dilate ? _mm_adds_epu8(a, step) : _mm_subs_epu8(a, step));
+        }
+#else
+        // the signed blend below rounds the same way in both directions
+        static_cast<void>(dilate);
+#endif
+
+        for (; x < count; ++x)
+        {
+            destination[x] = static_cast<unsigned char>(inner[x] + (((outer[x] - inner[x]) * fraction) >> 8));
+        }
+    }
+
+#if defined(GDIPP_SIMD_SSE2)
+    static void TransposeBlock(const CoverageBitmap & source, CoverageBitmap & destination, int bx, int by)
+    {
+        /*
+        *   16 x 16 bytes. Interleaving row i with row i + 8 four times moves
+        *   every byte from (row, column) to (column, row).
+        */
+
+        __m128i rows[16], next[16];
+
+        for (int i = 0; i < 16; ++i)
+        {
+            rows[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source.GetRow(by + i) + bx));
+        }
+
+        for (int round = 0; round < 4; ++round)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                next[2 * i] = _mm_unpacklo_epi8(rows[i], rows[i + 8]);
+                next[2 * i + 1] = _mm_unpackhi_epi8(rows[i], rows[i + 8]);
+            }
+
+            for (int i = 0; i < 16; ++i)
+            {
+                rows[i] = next[i];
+            }
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination.GetRow(bx + i) + by), rows[i]);
+        }
+    }
+#endif
+
+    static void TransposeBand(const CoverageBitmap & source, CoverageBitmap & destination, int by)
+    {
+        // source rows by - by + 15 become destination columns
+        const int width = source.GetWidth();
+        const int block = 16;
+        const int endY = std::min(by + block, source.GetHeight());
+
+        for (int bx = 0; bx < width; bx += block)
+        {
+            const int endX = std::min(bx + block, width);
+
+#if defined(GDIPP_SIMD_SSE2)
+            if (endY - by == block && endX - bx == block)
+            {
+                TransposeBlock(source, destination, bx, by);
+                continue;
+            }
+#endif
+
+            for (int y = by; y < endY; ++y)
+            {
+                const unsigned char * row = source.GetRow(y);
+
+                for (int x = bx; x < endX; ++x)
+                {
+                    destination.GetRow(x)[y] = row[x];
+                }
+            }
+        }
+    }
+
+    static void FilterColumns(CoverageBitmap & plane, float radius, bool dilate, int begin, int count)
+    {
+        /*
+        *   Running maximum (dilate) or minimum (erode) down every column,
+        *   whole rows at a time. The van Herk / Gil-Werman scheme splits the
+        *   padded column into blocks of the window size and keeps prefix and
+        *   suffix extremes per block, every output is then the combination
+        *   of one suffix and one prefix value: three operations per pixel
+        *   whatever the radius.
+        *
+        *   A fractional radius blends between the whole pixel windows below
+        *   and above it. The larger window at row i is the union of the
+        *   smaller windows at rows i - 1 and i + 1.
+        *
+        *   Only the columns begin - begin + count - 1 are filtered, count is
+        *   a multiple of 16.
+        */
+
+        const int whole = static_cast<int>(std::floor(radius));
+        const int fraction = static_cast<int>((radius - whole) * 256.0f + 0.5f);
+        const int height = plane.GetHeight();
+
+        // rows outside of the plane do not change the result
+        const std::vector<unsigned char> identity(count, dilate ? 0x00 : 0xFF);
+
+        std::vector<unsigned char> inner(static_cast<size_t>(height) * count);
+
+        if (whole == 0)
+        {
+            for (int y = 0; y < height; ++y)
+            {
+                const unsigned char * row = plane.GetRow(y) + begin;
+                std::copy(row, row + count, &inner[static_cast<size_t>(y) * count]);
+            }
+        }
+        else
+        {
+            const int window = 2 * whole + 1;
+            const int padded = height + 2 * whole;
+
+            std::vector<unsigned char> prefix(static_cast<size_t>(padded) * count);
+            std::vector<unsigned char> suffix(static_cast<size_t>(padded) * count);
+
+            std::vector<const unsigned char*> rows(padded);
+
+            for (int p = 0; p < padded; ++p)
+            {
+                const int y = p - whole;
+                rows[p] = (y >= 0 && y < height) ? plane.GetRow(y) + begin : &identity[0];
+            }
+
+            for (int p = 0; p < padded; ++p)
+            {
+                unsigned char * row = &prefix[static_cast<size_t>(p) * count];
+
+                if (p % window == 0)
+                {
+                    std::copy(rows[p], rows[p] + count, row);
+                }
+                else
+                {
+                    CombineRows(row - count, rows[p], row, count, dilate);
+                }
+            }
+
+            for (int p = padded - 1; p >= 0; --p)
+            {
+                unsigned char * row = &suffix[static_cast<size_t>(p) * count];
+
+                if (p % window == window - 1 || p == padded - 1)
+                {
+                    std::copy(rows[p], rows[p] + count, row);
+                }
+                else
+                {
+                    CombineRows(row + count, rows[p], row, count, dilate);
+                }
+            }
+
+            for (int y = 0; y < height; ++y)
+            {
+                CombineRows(&suffix[static_cast<size_t>(y) * count],
+                            &prefix[static_cast<size_t>(y + 2 * whole) * count],
+                            &inner[static_cast<size_t>(y) * count],
+                            count,
+                            dilate);
+            }
+        }
+
+        if (fraction == 0)
+        {
+            for (int y = 0; y < height; ++y)
+            {
+                const unsigned char * row = &inner[static_cast<size_t>(y) * count];
+                std::copy(row, row + count, plane.GetRow(y) + begin);
+            }
+
+            return;
+        }
+
+        std::vector<unsigned char> outer(count);
+
+        for (int y = 0; y < height; ++y)
+        {
+            const unsigned char * row = &inner[static_cast<size_t>(y) * count];
+            const unsigned char * above = y > 0 ? row - count : &identity[0];
+            const unsigned char * below = y + 1 < height ? row + count : &identity[0];
+
+            CombineRows(above, below, &outer[0], count, dilate);
+            CombineRows(&outer[0], row, &outer[0], count, dilate);
+
+            BlendRows(row, &outer[0], plane.GetRow(y) + begin, count, fraction, dilate);
+        }
+    }
+
+    class TransposeTask : public ParallelTask
+    {
+    public:
+        TransposeTask(const CoverageBitmap & source, CoverageBitmap & destination)
+            : source(source), destination(destination)
+        {
+
+        }
+
+        virtual void Run(int index, int)
+        {
+            TransposeBand(source, destination, index * 16);
+        }
+
+    private:
+        const CoverageBitmap & source;
+        CoverageBitmap & destination;
+    };
+
+    class FilterTask : public ParallelTask
+    {
+    public:
+        // strips of 256 columns, the workspace of one strip stays in the cache
+        static const int StripWidth = 256;
+
+        FilterTask(CoverageBitmap & plane, float radius, bool dilate)
+            : plane(plane), radius(radius), dilate(dilate)
+        {
+
+        }
+
+        int GetCount() const
+        {
+            return (plane.GetStride() + StripWidth - 1) / StripWidth;
+        }
+
+        virtual void Run(int index, int)
+        {
+            const int begin = index * StripWidth;
+            FilterColumns(plane, radius, dilate, begin, std::min(static_cast<int>(StripWidth), plane.GetStride() - begin));
+        }
+
+    private:
+        CoverageBitmap & plane;
+        float radius;
+        bool dilate;
+    };
+
+    static void Transpose(const CoverageBitmap & source, CoverageBitmap & destination, ThreadPool * pool)
+    {
+        destination.Resize(source.GetHeight(), source.GetWidth());
+
+        TransposeTask task(source, destination);
+        RunParallel(pool, task, (source.GetHeight() + 15) / 16);
+    }
+
+    static void Filter(CoverageBitmap & plane, float radius, bool dilate, ThreadPool * pool)
+    {
+        FilterTask task(plane, radius, dilate);
+        RunParallel(pool, task, task.GetCount());
+    }
+
+    void Embolden(CoverageBitmap & coverage, int strength, int oversample, ThreadPool * pool)
+    {
+        if (strength == 0 || coverage.IsEmpty())
+        {
+            return;
+        }
+
+        // the stem grows by the strength, half of it on each side
+        const bool dilate = strength > 0;
+        const float radius = std::abs(strength) / 128.0f;
+
+        // horizontal pass on the transposed plane, so that both passes
+        // run the same row-parallel kernel
+        CoverageBitmap transposed;
+        Transpose(coverage, transposed, pool);
+        Filter(transposed, radius * oversample, dilate, pool);
+        Transpose(transposed, coverage, pool);
+
+        Filter(coverage, radius, dilate, pool);
+    }
+
+    int GetEmboldenMargin(int strength)
+    {
+        if (strength <= 0)
+        {
+            return 0;
+        }
+
+        return (strength + 127) / 128 + 1;
+    }
+} // namespace GDIPPRenderer
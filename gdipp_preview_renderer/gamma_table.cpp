@@ -0,0 +1,170 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "gamma_table.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "../gdipp-conf-editor/metrics.h"
+
+namespace GDIPPRenderer
+{
+    static void BuildChannel(unsigned char * table, double gamma)
+    {
+        if (!(gamma > 0.0))
+        {
+            // invalid value, keep coverage unchanged
+            gamma = 1.0;
+        }
+
+        for (int i = 0; i < 256; ++i)
+        {
+            double value = std::pow(i / 255.0, 1.0 / gamma) * 255.0;
+            table[i] = static_cast<unsigned char>(value + 0.5);
+        }
+    }
+
+    GammaTable::GammaTable()
+    {
+        Build(1.0, 1.0, 1.0);
+    }
+
+    void GammaTable::Build(double red, double green, double blue)
+    {
+        BuildChannel(tables[0], red);
+        BuildChannel(tables[1], green);
+        BuildChannel(tables[2], blue);
+    }
+
+    void GammaTable::ApplyScanline(const unsigned char * source,
+                                   unsigned char * destination,
+                                   int count) const
+    {
+        /*
+        *   count is a multiple of 3, sample x belongs to channel x % 3.
+        *   Plain table loads beat both vector lookups measured: the AVX2
+        *   gather, and pshufb over 16-entry slices of the tables, which
+        *   takes 48 shuffles per vector with a table for every channel.
+        */
+
+        int x = 0;
+
+        const unsigned char * red = tables[0];
+        const unsigned char * green = tables[1];
+        const unsigned char * blue = tables[2];
+
+        for (; x < count && x % 3 != 0; ++x)
+        {
+            destination[x] = tables[x % 3][source[x]];
+        }
+
+        for (; x + 3 <= count; x += 3)
+        {
+            destination[x] = red[source[x]];
+            destination[x + 1] = green[source[x + 1]];
+            destination[x + 2] = blue[source[x + 2]];
+        }
+
+        for (; x < count; ++x)
+        {
+            destination[x] = tables[x % 3][source[x]];
+        }
+    }
+
+    void GammaTable::Apply(CoverageBitmap & channels) const
+    {
+        for (int y = 0; y < channels.GetHeight(); ++y)
+        {
+            ApplyScanline(channels.GetRow(y), channels.GetRow(y), channels.GetWidth());
+        }
+    }
+
+    class GammaTask : public ParallelTask
+    {
+    public:
+        static const int BandHeight = 32;
+
+        GammaTask(const GammaTable & table, const CoverageBitmap & source, CoverageBitmap & destination)
+            : table(table), source(source), destination(destination)
+        {
+
+        }
+
+        virtual void Run(int index, int)
+        {
+            const int endY = std::min(source.GetHeight(), (index + 1) * BandHeight);
+
+            for (int y = index * BandHeight; y < endY; ++y)
+            {
+                table.ApplyScanline(source.GetRow(y), destination.GetRow(y), source.GetWidth());
+            }
+        }
+
+    private:
+        const GammaTable & table;
+        const CoverageBitmap & source;
+        CoverageBitmap & destination;
+    };
+
+    void GammaTable::Apply(const CoverageBitmap & source,
+                           CoverageBitmap & destination,
+                           ThreadPool * pool) const
+    {
+        destination.Resize(source.GetWidth(), source.GetHeight());
+
+        GammaTask task(*this, source, destination);
+        RunParallel(pool, task, (source.GetHeight() + GammaTask::BandHeight - 1) / GammaTask::BandHeight);
+    }
+
+    GammaTableCache::GammaTableCache(size_t capacity)
+        : capacity(capacity),
+          buildCount(0)
+    {
+
+    }
+
+    const GammaTable & GammaTableCache::Get(double red, double green, double blue)
+    {
+        const Key key(red, green, blue);
+        std::map<Key, GammaTable>::iterator it = tables.find(key);
+
+        if (it != tables.end())
+        {
+            Metrics::Add(Metrics::Counter_GammaTableHits);
+            return it->second;
+        }
+
+        Metrics::Add(Metrics::Counter_GammaTableMisses);
+
+        if (tables.size() >= capacity)
+        {
+            tables.clear();
+        }
+
+        GammaTable & table = tables[key];
+        table.Build(red, green, blue);
+        ++buildCount;
+
+        return table;
+    }
+} // namespace GDIPPRenderer
@@ -0,0 +1,113 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <map>
+
+#include "coverage_bitmap.h"
+#include "thread_pool.h"
+
+namespace GDIPPRenderer
+{
+    class GammaTable
+    {
+        /*
+        *   Per-channel coverage correction, coverage' = coverage ^ (1 / gamma).
+        *   Values above 1.0 make the text darker.
+        */
+
+    public:
+        GammaTable();
+
+        void Build(double red, double green, double blue);
+
+        // applies the tables to interleaved R, G, B coverage
+        void Apply(CoverageBitmap & channels) const;
+        void Apply(const CoverageBitmap & source,
+                   CoverageBitmap & destination,
+                   ThreadPool * pool = NULL) const;
+
+        void ApplyScanline(const unsigned char * source,
+                           unsigned char * destination,
+                           int count) const;
+
+        const unsigned char * GetTable(int channel) const
+        {
+            return tables[channel];
+        }
+
+    private:
+        unsigned char tables[3][256];
+    };
+
+    class GammaTableCache
+    {
+        /*
+        *   Tables already built for recently used gamma triples. Changing
+        *   gamma back and forth in the editor costs a lookup, not a rebuild.
+        */
+
+    public:
+        GammaTableCache(size_t capacity = 16);
+
+        const GammaTable & Get(double red, double green, double blue);
+
+        size_t GetBuildCount() const
+        {
+            return buildCount;
+        }
+
+    private:
+        class Key
+        {
+        public:
+            Key(double red, double green, double blue)
+                : red(red), green(green), blue(blue)
+            {
+
+            }
+
+            bool operator<(const Key & other) const
+            {
+                if (red != other.red)
+                {
+                    return red < other.red;
+                }
+
+                if (green != other.green)
+                {
+                    return green < other.green;
+                }
+
+                return blue < other.blue;
+            }
+
+        private:
+            double red, green, blue;
+        };
+
+        size_t capacity;
+        size_t buildCount;
+        std::map<Key, GammaTable> tables;
+    };
+}
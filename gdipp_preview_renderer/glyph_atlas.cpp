@@ -0,0 +1,451 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "glyph_atlas.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../gdipp-conf-editor/util.h"
+
+#include "truetype_font.h"
+#include "render_mode.h"
+
+namespace GDIPPRenderer
+{
+    static std::wstring EncodeCodePoint(unsigned long codePoint)
+    {
+        std::wstring text;
+
+        // wchar_t is UTF-16 on Windows
+        if (sizeof(wchar_t) == 2 && codePoint >= 0x10000)
+        {
+            text += static_cast<wchar_t>(0xD800 + ((codePoint - 0x10000) >> 10));
+            text += static_cast<wchar_t>(0xDC00 + ((codePoint - 0x10000) & 0x3FF));
+        }
+        else
+        {
+            text += static_cast<wchar_t>(codePoint);
+        }
+
+        return text;
+    }
+
+    std::vector<unsigned long> GetCodePoints(const std::wstring & text)
+    {
+        std::vector<unsigned long> codePoints;
+
+        for (size_t i = 0; i < text.length(); ++i)
+        {
+            unsigned long codePoint = static_cast<unsigned long>(text[i]);
+
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 1 < text.length())
+            {
+                const unsigned long low = static_cast<unsigned long>(text[i + 1]);
+
+                if (low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    ++i;
+                }
+            }
+
+            codePoints.push_back(codePoint);
+        }
+
+        return codePoints;
+    }
+
+    static bool IsBackground(const unsigned char * pixel, unsigned int background)
+    {
+        return pixel[0] == (background & 0xFF)
+            && pixel[1] == ((background >> 8) & 0xFF)
+            && pixel[2] == ((background >> 16) & 0xFF);
+    }
+
+    class GlyphHeightOrder
+    {
+    public:
+        GlyphHeightOrder(const std::vector<AtlasGlyph> & glyphs)
+            : glyphs(glyphs)
+        {
+
+        }
+
+        bool operator()(size_t left, size_t right) const
+        {
+            if (glyphs[left].height != glyphs[right].height)
+            {
+                return glyphs[left].height > glyphs[right].height;
+            }
+
+            return glyphs[left].width > glyphs[right].width;
+        }
+
+    private:
+        const std::vector<AtlasGlyph> & glyphs;
+    };
+
+    GlyphAtlas::GlyphAtlas()
+        : pixelSize(0)
+    {
+
+    }
+
+    void GlyphAtlas::Build(SoftwareRenderer & renderer,
+                           const PreviewRequest & request,
+                           const GDIPPConfiguration::Values & values,
+                           const std::vector<unsigned long> & codePoints)
+    {
+        if (request.pixelSizes.empty())
+        {
+            throw std::runtime_error("GlyphAtlas: no pixel size given.");
+        }
+
+        TrueTypeFont font;
+        font.Load(request.fontFileName);
+
+        pixelSize = request.pixelSizes[0];
+        glyphs.clear();
+
+        const double scale = pixelSize * 64.0 / font.GetUnitsPerEm();
+
+        PreviewRequest glyphRequest = request;
+        glyphRequest.pixelSizes.assign(1, pixelSize);
+        glyphRequest.allOutputModes = false;
+
+        std::vector<unsigned long> sorted = codePoints;
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+        std::vector<RenderedImage> bitmaps;
+
+        for (size_t i = 0; i < sorted.size(); ++i)
+        {
+            AtlasGlyph glyph;
+            memset(&glyph, 0, sizeof(glyph));
+
+            glyph.codePoint = static_cast<unsigned int>(sorted[i]);
+            glyph.glyphIndex = font.GetGlyphIndex(sorted[i]);
+
+            if (glyph.glyphIndex == 0)
+            {
+                continue;
+            }
+
+            glyph.advance = static_cast<int>(std::floor(font.GetAdvanceWidth(glyph.glyphIndex) * scale + 0.5));
+
+            glyphRequest.lines.assign(1, EncodeCodePoint(sorted[i]));
+
+            const RenderedImage & rendered = renderer.Render(glyphRequest, values);
+            const PositionedGlyph & positioned = renderer.GetLayout().glyphs[0];
+
+            // ink bounds, everything that differs from the background
+            int left = rendered.GetWidth();
+            int top = rendered.GetHeight();
+            int right = -1;
+            int bottom = -1;
+
+            for (int y = 0; y < rendered.GetHeight(); ++y)
+            {
+                const unsigned char * row = rendered.GetRow(y);
+
+                for (int x = 0; x < rendered.GetWidth(); ++x)
+                {
+                    if (!IsBackground(row + x * 4, request.background))
+                    {
+                        left = std::min(left, x);
+                        right = std::max(right, x);
+                        top = std::min(top, y);
+                        bottom = std::max(bottom, y);
+                    }
+                }
+            }
+
+            RenderedImage bitmap;
+
+            if (right >= 0)
+            {
+                glyph.width = static_cast<unsigned short>(right - left + 1);
+                glyph.height = static_cast<unsigned short>(bottom - top + 1);
+                glyph.bearingX = static_cast<short>(left - positioned.x / SubpixelOversample);
+                glyph.bearingY = static_cast<short>(positioned.baseline - top);
+
+                bitmap.Resize(glyph.width, glyph.height, request.background);
+                bitmap.Draw(rendered, -left, -top);
+            }
+
+            glyphs.push_back(glyph);
+            bitmaps.push_back(bitmap);
+        }
+
+        // shelf packing, tallest glyphs first, one pixel apart
+        std::vector<size_t> order(glyphs.size());
+        size_t area = 0;
+        int widest = 0;
+
+        for (size_t i = 0; i < glyphs.size(); ++i)
+        {
+            order[i] = i;
+            area += static_cast<size_t>(glyphs[i].width + 1) * (glyphs[i].height + 1);
+            widest = std::max(widest, glyphs[i].width + 1);
+        }
+
+        std::sort(order.begin(), order.end(), GlyphHeightOrder(glyphs));
+
+        int atlasWidth = 16;
+
+        while (atlasWidth < widest || static_cast<size_t>(atlasWidth) * atlasWidth < area)
+        {
+            atlasWidth *= 2;
+        }
+
+        int shelfX = 0;
+        int shelfY = 0;
+        int shelfHeight = 0;
+
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            AtlasGlyph & glyph = glyphs[order[i]];
+
+            if (glyph.width == 0)
+            {
+                continue;
+            }
+
+            if (shelfX + glyph.width + 1 > atlasWidth)
+            {
+                shelfX = 0;
+                shelfY += shelfHeight;
+                shelfHeight = 0;
+            }
+
+            glyph.atlasX = static_cast<unsigned short>(shelfX);
+            glyph.atlasY = static_cast<unsigned short>(shelfY);
+
+            shelfX += glyph.width + 1;
+            shelfHeight = std::max(shelfHeight, glyph.height + 1);
+        }
+
+        if (shelfY + shelfHeight > 65535)
+        {
+            throw std::runtime_error("GlyphAtlas: too many glyphs for one atlas.");
+        }
+
+        image.Resize(atlasWidth, std::max(shelfY + shelfHeight, 1), request.background);
+
+        for (size_t i = 0; i < glyphs.size(); ++i)
+        {
+            if (glyphs[i].width > 0)
+            {
+                image.Draw(bitmaps[i], glyphs[i].atlasX, glyphs[i].atlasY);
+            }
+        }
+    }
+
+    static void PutU16(unsigned char * target, unsigned int value)
+    {
+        target[0] = static_cast<unsigned char>(value & 0xFF);
+        target[1] = static_cast<unsigned char>((value >> 8) & 0xFF);
+    }
+
+    static void PutU32(unsigned char * target, unsigned int value)
+    {
+        PutU16(target, value & 0xFFFF);
+        PutU16(target + 2, value >> 16);
+    }
+
+    static unsigned int GetU16(const unsigned char * source)
+    {
+        return source[0] | (source[1] << 8);
+    }
+
+    static unsigned int GetU32(const unsigned char * source)
+    {
+        return GetU16(source) | (GetU16(source + 2) << 16);
+    }
+
+    void GlyphAtlas::Save(std::ostream & stream) const
+    {
+        const unsigned int recordsOffset = HeaderSize;
+        const unsigned int pixelsOffset = (recordsOffset + static_cast<unsigned int>(glyphs.size()) * GlyphRecordSize + 15) & ~15U;
+
+        std::vector<unsigned char> index(pixelsOffset, 0);
+        unsigned char * header = &index[0];
+
+        memcpy(header, "GDPA", 4);
+        PutU16(header + 4, Version);
+        PutU16(header + 6, HeaderSize);
+        PutU32(header + 8, static_cast<unsigned int>(glyphs.size()));
+        PutU32(header + 12, static_cast<unsigned int>(pixelSize));
+        PutU32(header + 16, static_cast<unsigned int>(image.GetWidth()));
+        PutU32(header + 20, static_cast<unsigned int>(image.GetHeight()));
+        PutU32(header + 24, recordsOffset);
+        PutU32(header + 28, pixelsOffset);
+
+        for (size_t i = 0; i < glyphs.size(); ++i)
+        {
+            const AtlasGlyph & glyph = glyphs[i];
+            unsigned char * record = &index[recordsOffset + i * GlyphRecordSize];
+
+            PutU32(record, glyph.codePoint);
+            PutU32(record + 4, glyph.glyphIndex);
+            PutU32(record + 8, static_cast<unsigned int>(glyph.advance));
+            PutU16(record + 12, static_cast<unsigned short>(glyph.bearingX));
+            PutU16(record + 14, static_cast<unsigned short>(glyph.bearingY));
+            PutU16(record + 16, glyph.width);
+            PutU16(record + 18, glyph.height);
+            PutU16(record + 20, glyph.atlasX);
+            PutU16(record + 22, glyph.atlasY);
+        }
+
+        stream.write(reinterpret_cast<const char*>(&index[0]), static_cast<std::streamsize>(index.size()));
+
+        for (int y = 0; y < image.GetHeight(); ++y)
+        {
+            stream.write(reinterpret_cast<const char*>(image.GetRow(y)), static_cast<std::streamsize>(image.GetWidth()) * 4);
+        }
+
+        if (!stream)
+        {
+            throw std::runtime_error("GlyphAtlas: unable to write the atlas.");
+        }
+    }
+
+    void GlyphAtlas::Save(const MetaString & fileName) const
+    {
+        std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+
+        if (!file)
+        {
+            throw std::runtime_error("Unable to create atlas file: " + Util::MetaStringToAnsi(fileName));
+        }
+
+        Save(file);
+    }
+
+    GlyphAtlasView::GlyphAtlasView(const unsigned char * data, size_t size)
+        : records(NULL),
+          pixels(NULL),
+          glyphCount(0),
+          pixelSize(0),
+          width(0),
+          height(0)
+    {
+        if (size < GlyphAtlas::HeaderSize || memcmp(data, "GDPA", 4) != 0)
+        {
+            throw std::runtime_error("GlyphAtlasView: not an atlas file.");
+        }
+
+        if (GetU16(data + 4) != GlyphAtlas::Version || GetU16(data + 6) != GlyphAtlas::HeaderSize)
+        {
+            throw std::runtime_error("GlyphAtlasView: unsupported atlas version.");
+        }
+
+        glyphCount = GetU32(data + 8);
+        pixelSize = static_cast<int>(GetU32(data + 12));
+
+        const unsigned int atlasWidth = GetU32(data + 16);
+        const unsigned int atlasHeight = GetU32(data + 20);
+        const unsigned int recordsOffset = GetU32(data + 24);
+        const unsigned int pixelsOffset = GetU32(data + 28);
+
+        // 64-bit arithmetic, a corrupted header must not wrap around
+        const unsigned long long recordsEnd = recordsOffset + static_cast<unsigned long long>(glyphCount) * GlyphAtlas::GlyphRecordSize;
+        const unsigned long long pixelsEnd = pixelsOffset + static_cast<unsigned long long>(atlasWidth) * atlasHeight * 4;
+
+        if (atlasWidth > 65536 || atlasHeight > 65536 || recordsEnd > size || pixelsEnd > size)
+        {
+            throw std::runtime_error("GlyphAtlasView: truncated atlas file.");
+        }
+
+        records = data + recordsOffset;
+        pixels = data + pixelsOffset;
+        width = static_cast<int>(atlasWidth);
+        height = static_cast<int>(atlasHeight);
+
+        for (unsigned int i = 0; i < glyphCount; ++i)
+        {
+            const AtlasGlyph glyph = GetGlyph(i);
+
+            if (glyph.atlasX + glyph.width > width || glyph.atlasY + glyph.height > height)
+            {
+                throw std::runtime_error("GlyphAtlasView: glyph outside of the atlas.");
+            }
+
+            if (i > 0 && GetU32(records + (i - 1) * GlyphAtlas::GlyphRecordSize) >= glyph.codePoint)
+            {
+                throw std::runtime_error("GlyphAtlasView: glyphs are not sorted.");
+            }
+        }
+    }
+
+    AtlasGlyph GlyphAtlasView::GetGlyph(unsigned int index) const
+    {
+        const unsigned char * record = records + static_cast<size_t>(index) * GlyphAtlas::GlyphRecordSize;
+
+        AtlasGlyph glyph;
+        glyph.codePoint = GetU32(record);
+        glyph.glyphIndex = GetU32(record + 4);
+        glyph.advance = static_cast<int>(GetU32(record + 8));
+        glyph.bearingX = static_cast<short>(GetU16(record + 12));
+        glyph.bearingY = static_cast<short>(GetU16(record + 14));
+        glyph.width = static_cast<unsigned short>(GetU16(record + 16));
+        glyph.height = static_cast<unsigned short>(GetU16(record + 18));
+        glyph.atlasX = static_cast<unsigned short>(GetU16(record + 20));
+        glyph.atlasY = static_cast<unsigned short>(GetU16(record + 22));
+
+        return glyph;
+    }
+
+    bool GlyphAtlasView::Find(unsigned long codePoint, AtlasGlyph & glyph) const
+    {
+        unsigned int low = 0;
+        unsigned int high = glyphCount;
+
+        while (low < high)
+        {
+            const unsigned int middle = low + (high - low) / 2;
+
+            if (GetU32(records + static_cast<size_t>(middle) * GlyphAtlas::GlyphRecordSize) < codePoint)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        if (low == glyphCount || GetU32(records + static_cast<size_t>(low) * GlyphAtlas::GlyphRecordSize) != codePoint)
+        {
+            return false;
+        }
+
+        glyph = GetGlyph(low);
+
+        return true;
+    }
+} // namespace GDIPPRenderer
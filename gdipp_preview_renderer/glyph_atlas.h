@@ -0,0 +1,169 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <ostream>
+
+#include "../gdipp-conf-editor/local_types.h"
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+
+#include "rendered_image.h"
+#include "software_renderer.h"
+
+namespace GDIPPRenderer
+{
+    class AtlasGlyph
+    {
+        /*
+        *   One record of the atlas file index, 24 bytes, little endian.
+        */
+
+    public:
+        unsigned int codePoint;
+        unsigned int glyphIndex;
+
+        // 26.6 fixed point pixels
+        int advance;
+
+        // from the pen position on the baseline to the top left corner of
+        // the bitmap, y pointing up
+        short bearingX;
+        short bearingY;
+
+        unsigned short width;
+        unsigned short height;
+        unsigned short atlasX;
+        unsigned short atlasY;
+    };
+
+    class GlyphAtlas
+    {
+        /*
+        *   Every glyph rendered on its own with the full preview pipeline,
+        *   cropped to its ink and packed into one BGRA image with the shelf
+        *   algorithm (tallest first). The atlas file is laid out to be
+        *   mapped into memory and used in place:
+        *
+        *   header      "GDPA", version (u16), header size (u16),
+        *               glyph count, pixel size, atlas width, atlas height,
+        *               glyph records offset, pixels offset (u32 each)
+        *   records     AtlasGlyph, sorted by code point
+        *   pixels      BGRA rows, 16-byte aligned
+        */
+
+    public:
+        static const unsigned int Version = 1;
+        static const unsigned int HeaderSize = 32;
+        static const unsigned int GlyphRecordSize = 24;
+
+        GlyphAtlas();
+
+        // renders the code points at request.pixelSizes[0]; duplicates and
+        // code points the font has no glyph for are skipped
+        void Build(SoftwareRenderer & renderer,
+                   const PreviewRequest & request,
+                   const GDIPPConfiguration::Values & values,
+                   const std::vector<unsigned long> & codePoints);
+
+        const std::vector<AtlasGlyph> & GetGlyphs() const
+        {
+            return glyphs;
+        }
+
+        const RenderedImage & GetImage() const
+        {
+            return image;
+        }
+
+        int GetPixelSize() const
+        {
+            return pixelSize;
+        }
+
+        void Save(std::ostream & stream) const;
+
+        // throws std::runtime_error when the file cannot be written
+        void Save(const MetaString & fileName) const;
+
+    private:
+        std::vector<AtlasGlyph> glyphs;
+        RenderedImage image;
+        int pixelSize;
+    };
+
+    class GlyphAtlasView
+    {
+        /*
+        *   Reads an atlas file in place, e.g. from a memory mapping, nothing
+        *   is copied. The constructor validates the header and the offsets
+        *   and throws std::runtime_error on a malformed file.
+        */
+
+    public:
+        GlyphAtlasView(const unsigned char * data, size_t size);
+
+        unsigned int GetGlyphCount() const
+        {
+            return glyphCount;
+        }
+
+        int GetPixelSize() const
+        {
+            return pixelSize;
+        }
+
+        int GetWidth() const
+        {
+            return width;
+        }
+
+        int GetHeight() const
+        {
+            return height;
+        }
+
+        AtlasGlyph GetGlyph(unsigned int index) const;
+
+        // binary search over the sorted records, false when missing
+        bool Find(unsigned long codePoint, AtlasGlyph & glyph) const;
+
+        // BGRA pixels, width * 4 bytes per row
+        const unsigned char * GetRow(int y) const
+        {
+            return pixels + static_cast<size_t>(y) * width * 4;
+        }
+
+    private:
+        const unsigned char * records;
+        const unsigned char * pixels;
+
+        unsigned int glyphCount;
+        int pixelSize;
+        int width;
+        int height;
+    };
+
+    // every code point of the text, in order
+    extern std::vector<unsigned long> GetCodePoints(const std::wstring & text);
+}
@@ -0,0 +1,302 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "glyph_cache.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "../gdipp-conf-editor/metrics.h"
+
+namespace GDIPPRenderer
+{
+    GlyphCacheKey::GlyphCacheKey()
+        : fontId(0), glyphIndex(0), pixelSize(0), oversample(0), hinting(0)
+    {
+
+    }
+
+    GlyphCacheKey::GlyphCacheKey(unsigned int fontId,
+                                 unsigned int glyphIndex,
+                                 int pixelSize,
+                                 int oversample,
+                                 int hinting)
+        : fontId(fontId),
+          glyphIndex(glyphIndex),
+          pixelSize(pixelSize),
+          oversample(oversample),
+          hinting(hinting)
+    {
+
+    }
+
+    bool GlyphCacheKey::operator<(const GlyphCacheKey & other) const
+    {
+        if (glyphIndex != other.glyphIndex)
+        {
+            return glyphIndex < other.glyphIndex;
+        }
+
+        if (pixelSize != other.pixelSize)
+        {
+            return pixelSize < other.pixelSize;
+        }
+
+        if (fontId != other.fontId)
+        {
+            return fontId < other.fontId;
+        }
+
+        if (hinting != other.hinting)
+        {
+            return hinting < other.hinting;
+        }
+
+        return oversample < other.oversample;
+    }
+
+    unsigned int GlyphCacheKey::GetHash() const
+    {
+        // FNV-1a over the fields
+        const unsigned int fields[5] =
+        {
+            fontId,
+            glyphIndex,
+            static_cast<unsigned int>(pixelSize),
+            static_cast<unsigned int>(oversample),
+            static_cast<unsigned int>(hinting)
+        };
+
+        unsigned int hash = 2166136261U;
+
+        for (int i = 0; i < 5; ++i)
+        {
+            hash = (hash ^ fields[i]) * 16777619U;
+        }
+
+        return hash ^ (hash >> 16);
+    }
+
+    GlyphCacheStatistics::GlyphCacheStatistics()
+        : hits(0), misses(0), evictions(0), entries(0), bytes(0), reservedBytes(0)
+    {
+
+    }
+
+    GlyphCache::Shard::Shard(size_t slabSize)
+        : allocator(slabSize),
+          bytes(0), hits(0), misses(0), evictions(0)
+    {
+
+    }
+
+    GlyphCache::GlyphCache(size_t byteBudget, int shardCount)
+        : byteBudget(byteBudget)
+    {
+        if (shardCount < 1)
+        {
+            shardCount = 1;
+        }
+
+        shardBudget = byteBudget / shardCount;
+
+        // slabs small enough that the free space in them stays a fraction
+        // of the budget
+        const size_t slabSize = std::max(shardBudget / 8, static_cast<size_t>(4096));
+
+        for (int i = 0; i < shardCount; ++i)
+        {
+            shards.push_back(new Shard(slabSize));
+        }
+    }
+
+    GlyphCache::~GlyphCache()
+    {
+        Clear();
+
+        for (size_t i = 0; i < shards.size(); ++i)
+        {
+            delete shards[i];
+        }
+    }
+
+    unsigned int GlyphCache::GetFontId(const MetaString & fontFileName)
+    {
+        ScopedLock lock(fontLock);
+
+        std::map<MetaString, unsigned int>::const_iterator it = fontIds.find(fontFileName);
+
+        if (it != fontIds.end())
+        {
+            return it->second;
+        }
+
+        const unsigned int id = static_cast<unsigned int>(fontIds.size());
+        fontIds[fontFileName] = id;
+
+        return id;
+    }
+
+    GlyphCache::Shard & GlyphCache::GetShard(const GlyphCacheKey & key)
+    {
+        return * shards[key.GetHash() % shards.size()];
+    }
+
+    bool GlyphCache::Find(const GlyphCacheKey & key, GlyphBitmap & glyph)
+    {
+        Shard & shard = GetShard(key);
+        ScopedLock lock(shard.lock);
+
+        EntryMap::iterator it = shard.index.find(key);
+
+        if (it == shard.index.end())
+        {
+            ++shard.misses;
+            Metrics::Add(Metrics::Counter_GlyphCacheMisses);
+            return false;
+        }
+
+        ++shard.hits;
+        Metrics::Add(Metrics::Counter_GlyphCacheHits);
+
+        // move to the front of the LRU list
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+
+        const Entry & entry = * it->second;
+
+        glyph.left = entry.left;
+        glyph.top = entry.top;
+        glyph.coverage.Resize(entry.width, entry.height);
+
+        for (int y = 0; y < entry.height; ++y)
+        {
+            memcpy(glyph.coverage.GetRow(y), entry.pixels + static_cast<size_t>(y) * entry.width, entry.width);
+        }
+
+        return true;
+    }
+
+    void GlyphCache::Insert(const GlyphCacheKey & key, const GlyphBitmap & glyph)
+    {
+        if (byteBudget == 0)
+        {
+            return;
+        }
+
+        const int width = glyph.coverage.GetWidth();
+        const int height = glyph.coverage.GetHeight();
+        const size_t size = static_cast<size_t>(width) * height;
+
+        Shard & shard = GetShard(key);
+        ScopedLock lock(shard.lock);
+
+        if (shard.index.find(key) != shard.index.end())
+        {
+            // another thread got there first
+            return;
+        }
+
+        Entry entry;
+        entry.key = key;
+        entry.left = glyph.left;
+        entry.top = glyph.top;
+        entry.width = width;
+        entry.height = height;
+        entry.pixels = NULL;
+        entry.blockSize = 0;
+
+        if (size > 0)
+        {
+            const size_t blockSize = shard.allocator.GetBlockSize(size);
+
+            if (blockSize > shardBudget)
+            {
+                return;
+            }
+
+            // make room first, the shard never holds more than its budget
+            Evict(shard, shardBudget - blockSize);
+
+            entry.pixels = shard.allocator.Allocate(size, entry.blockSize);
+
+            for (int y = 0; y < height; ++y)
+            {
+                memcpy(entry.pixels + static_cast<size_t>(y) * width, glyph.coverage.GetRow(y), width);
+            }
+        }
+
+        shard.entries.push_front(entry);
+        shard.index[key] = shard.entries.begin();
+        shard.bytes += entry.blockSize;
+    }
+
+    void GlyphCache::Evict(Shard & shard, size_t budget)
+    {
+        while (shard.bytes > budget && !shard.entries.empty())
+        {
+            Entry & entry = shard.entries.back();
+
+            shard.allocator.Free(entry.pixels, entry.blockSize);
+            shard.bytes -= entry.blockSize;
+            ++shard.evictions;
+
+            shard.index.erase(entry.key);
+            shard.entries.pop_back();
+        }
+    }
+
+    void GlyphCache::Clear()
+    {
+        for (size_t i = 0; i < shards.size(); ++i)
+        {
+            ScopedLock lock(shards[i]->lock);
+
+            for (EntryList::iterator it = shards[i]->entries.begin(); it != shards[i]->entries.end(); ++it)
+            {
+                shards[i]->allocator.Free(it->pixels, it->blockSize);
+            }
+
+            shards[i]->entries.clear();
+            shards[i]->index.clear();
+            shards[i]->bytes = 0;
+        }
+    }
+
+    GlyphCacheStatistics GlyphCache::GetStatistics() const
+    {
+        GlyphCacheStatistics statistics;
+
+        for (size_t i = 0; i < shards.size(); ++i)
+        {
+            ScopedLock lock(shards[i]->lock);
+
+            statistics.hits += shards[i]->hits;
+            statistics.misses += shards[i]->misses;
+            statistics.evictions += shards[i]->evictions;
+            statistics.entries += shards[i]->entries.size();
+            statistics.bytes += shards[i]->bytes;
+            statistics.reservedBytes += shards[i]->allocator.GetReservedBytes();
+        }
+
+        return statistics;
+    }
+} // namespace GDIPPRenderer
@@ -0,0 +1,164 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <map>
+#include <list>
+#include <vector>
+#include <cstddef>
+
+#include "../gdipp-conf-editor/local_types.h"
+
+#include "rasterizer.h"
+#include "slab_allocator.h"
+#include "mutex.h"
+
+namespace GDIPPRenderer
+{
+    class GlyphCacheKey
+    {
+        /*
+        *   Everything a rasterized glyph depends on. Embolden and the output
+        *   mode are applied to the whole sheet later, the same glyph bitmap
+        *   serves all of them.
+        */
+
+    public:
+        GlyphCacheKey();
+        GlyphCacheKey(unsigned int fontId,
+                      unsigned int glyphIndex,
+                      int pixelSize,
+                      int oversample,
+                      int hinting);
+
+        bool operator<(const GlyphCacheKey & other) const;
+
+        unsigned int GetHash() const;
+
+        unsigned int fontId;
+        unsigned int glyphIndex;
+        int pixelSize;
+        int oversample;
+        int hinting;
+    };
+
+    class GlyphCacheStatistics
+    {
+    public:
+        GlyphCacheStatistics();
+
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t entries;
+
+        // bitmap bytes held, counted against the budget
+        size_t bytes;
+
+        // taken from the heap, including free slab space
+        size_t reservedBytes;
+    };
+
+    class GlyphCache
+    {
+        /*
+        *   Rasterized glyph bitmaps shared by renderers and their threads.
+        *   Entries are spread over shards by key hash, each shard has its
+        *   own lock, least recently used list, slab allocator and an equal
+        *   part of the byte budget. A budget of 0 disables caching.
+        */
+
+    public:
+        static const size_t DefaultByteBudget = 32 * 1024 * 1024;
+
+        explicit GlyphCache(size_t byteBudget = DefaultByteBudget, int shardCount = 16);
+        ~GlyphCache();
+
+        // the same id for the same font file, for the lifetime of the cache
+        unsigned int GetFontId(const MetaString & fontFileName);
+
+        // copies the cached bitmap into glyph, false on a miss
+        bool Find(const GlyphCacheKey & key, GlyphBitmap & glyph);
+        void Insert(const GlyphCacheKey & key, const GlyphBitmap & glyph);
+
+        void Clear();
+
+        size_t GetByteBudget() const
+        {
+            return byteBudget;
+        }
+
+        GlyphCacheStatistics GetStatistics() const;
+
+    private:
+        class Entry
+        {
+        public:
+            GlyphCacheKey key;
+
+            int left;
+            int top;
+            int width;
+            int height;
+
+            // width * height bytes, rows not padded
+            unsigned char * pixels;
+            size_t blockSize;
+        };
+
+        typedef std::list<Entry> EntryList;
+        typedef std::map<GlyphCacheKey, EntryList::iterator> EntryMap;
+
+        class Shard
+        {
+        public:
+            explicit Shard(size_t slabSize);
+
+            Mutex lock;
+
+            // most recently used first
+            EntryList entries;
+            EntryMap index;
+
+            SlabAllocator allocator;
+
+            size_t bytes;
+            size_t hits;
+            size_t misses;
+            size_t evictions;
+        };
+
+        size_t byteBudget;
+        size_t shardBudget;
+        std::vector<Shard*> shards;
+
+        Mutex fontLock;
+        std::map<MetaString, unsigned int> fontIds;
+
+        Shard & GetShard(const GlyphCacheKey & key);
+        void Evict(Shard & shard, size_t budget);
+
+        GlyphCache(const GlyphCache &);
+        GlyphCache & operator=(const GlyphCache &);
+    };
+}
@@ -0,0 +1,427 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "image_compare.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+#include "simd.h"
+
+namespace GDIPPRenderer
+{
+    // SSIM window and the distance between windows
+    static const int WindowSize = 8;
+    static const int WindowStep = 4;
+
+    ImageComparison::ImageComparison()
+        : ssim(1.0),
+          psnr(std::numeric_limits<double>::infinity()),
+          maxDelta(0),
+          differentPixels(0)
+    {
+
+    }
+
+    class WindowSums
+    {
+    public:
+        int a;
+        int b;
+        int aa;
+        int bb;
+        int ab;
+    };
+
+#if defined(GDIPP_SIMD_SSE2)
+    static int HorizontalSum(__m128i v)
+    {
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        return _mm_cvtsi128_si32(v);
+    }
+#endif
+
+    static WindowSums SumWindow(const unsigned char * a,
+                                const unsigned char * b,
+                                int stride,
+                                int width,
+                                int height)
+    {
+        WindowSums sums;
+
+#if defined(GDIPP_SIMD_SSE2)
+        if (width == WindowSize)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i sum = zero;
+            __m128i aa = zero;
+            __m128i bb = zero;
+            __m128i ab = zero;
+
+            for (int y = 0; y < height; ++y)
+            {
+                const __m128i a8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + y * stride));
+                const __m128i b8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + y * stride));
+
+                // a in the low, b in the high 64 bits
+                sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_unpacklo_epi64(a8, b8), zero));
+
+                const __m128i a16 = _mm_unpacklo_epi8(a8, zero);
+                const __m128i b16 = _mm_unpacklo_epi8(b8, zero);
+
+                aa = _mm_add_epi32(aa, _mm_madd_epi16(a16, a16));
+                bb = _mm_add_epi32(bb, _mm_madd_epi16(b16, b16));
+                ab = _mm_add_epi32(ab, _mm_madd_epi16(a16, b16));
+            }
+
+            sums.a = _mm_cvtsi128_si32(sum);
+            sums.b = _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+            sums.aa = HorizontalSum(aa);
+            sums.bb = HorizontalSum(bb);
+            sums.ab = HorizontalSum(ab);
+
+            return sums;
+        }
+#endif
+
+        sums.a = sums.b = sums.aa = sums.bb = sums.ab = 0;
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const int va = a[y * stride + x];
+                const int vb = b[y * stride + x];
+
+                sums.a += va;
+                sums.b += vb;
+                sums.aa += va * va;
+                sums.bb += vb * vb;
+                sums.ab += va * vb;
+            }
+        }
+
+        return sums;
+    }
+
+    static double ComputeWindowSsim(const WindowSums & sums, int count)
+    {
+        const double c1 = (0.01 * 255) * (0.01 * 255);
+        const double c2 = (0.03 * 255) * (0.03 * 255);
+
+        const double meanA = static_cast<double>(sums.a) / count;
+        const double meanB = static_cast<double>(sums.b) / count;
+        const double varianceA = static_cast<double>(sums.aa) / count - meanA * meanA;
+        const double varianceB = static_cast<double>(sums.bb) / count - meanB * meanB;
+        const double covariance = static_cast<double>(sums.ab) / count - meanA * meanB;
+
+        return ((2 * meanA * meanB + c1) * (2 * covariance + c2)) /
+               ((meanA * meanA + meanB * meanB + c1) * (varianceA + varianceB + c2));
+    }
+
+    static void ExtractChannel(const RenderedImage & image, int channel, std::vector<unsigned char> & plane)
+    {
+        const int width = image.GetWidth();
+        plane.resize(static_cast<size_t>(width) * image.GetHeight());
+
+        for (int y = 0; y < image.GetHeight(); ++y)
+        {
+            const unsigned char * row = image.GetRow(y) + channel;
+            unsigned char * destination = &plane[static_cast<size_t>(y) * width];
+
+            for (int x = 0; x < width; ++x)
+            {
+                destination[x] = row[x * 4];
+            }
+        }
+    }
+
+    static double ComputeSsim(const RenderedImage & expected, const RenderedImage & actual)
+    {
+        const int width = expected.GetWidth();
+        const int height = expected.GetHeight();
+
+        // images smaller than a window are one window
+        const int windowWidth = std::min(width, WindowSize);
+        const int windowHeight = std::min(height, WindowSize);
+
+        std::vector<unsigned char> planeA;
+        std::vector<unsigned char> planeB;
+
+        double total = 0.0;
+        size_t windows = 0;
+
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            ExtractChannel(expected, channel, planeA);
+            ExtractChannel(actual, channel, planeB);
+
+            for (int y = 0; y + windowHeight <= height; y += WindowStep)
+            {
+                for (int x = 0; x + windowWidth <= width; x += WindowStep)
+                {
+                    const size_t offset = static_cast<size_t>(y) * width + x;
+                    const WindowSums sums = SumWindow(&planeA[offset], &planeB[offset], width, windowWidth, windowHeight);
+
+                    total += ComputeWindowSsim(sums, windowWidth * windowHeight);
+                    ++windows;
+                }
+            }
+        }
+
+        return windows > 0 ? total / windows : 1.0;
+    }
+
+    class DifferenceSums
+    {
+    public:
+        DifferenceSums()
+            : squares(0),
+              maxDelta(0),
+              differentPixels(0)
+        {
+
+        }
+
+        unsigned long long squares;
+        int maxDelta;
+        size_t differentPixels;
+    };
+
+    static void SumDifferences(const unsigned char * a,
+                               const unsigned char * b,
+                               int count,
+                               DifferenceSums & sums)
+    {
+        int x = 0;
+
+#if defined(GDIPP_SIMD_SSE2)
+        // popcount of the four lane bits _mm_movemask_ps returns
+        static const int bitCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+        __m128i maximum = zero;
+
+        while (x + 4 <= count)
+        {
+            // flushed often enough that the 32-bit lanes never overflow
+            const int end = std::min(count, x + 1024 * 4) & ~3;
+            __m128i squares = zero;
+
+            for (; x < end; x += 4)
+            {
+                const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x * 4));
+                const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x * 4));
+                const __m128i delta = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va)), colorMask);
+
+                maximum = _mm_max_epu8(maximum, delta);
+
+                const __m128i low = _mm_unpacklo_epi8(delta, zero);
+                const __m128i high = _mm_unpackhi_epi8(delta, zero);
+                squares = _mm_add_epi32(squares, _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high)));
+
+                const int equal = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(delta, zero)));
+                sums.differentPixels += 4 - bitCounts[equal];
+            }
+
+            sums.squares += static_cast<unsigned int>(HorizontalSum(squares));
+        }
+
+        unsigned char lanes[16];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), maximum);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            sums.maxDelta = std::max(sums.maxDelta, static_cast<int>(lanes[i]));
+        }
+#endif
+
+        for (; x < count; ++x)
+        {
+            bool different = false;
+
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                const int delta = std::abs(a[x * 4 + channel] - b[x * 4 + channel]);
+
+                sums.squares += static_cast<unsigned long long>(delta * delta);
+                sums.maxDelta = std::max(sums.maxDelta, delta);
+                different |= delta != 0;
+            }
+
+            sums.differentPixels += different ? 1 : 0;
+        }
+    }
+
+    static void CheckSizes(const RenderedImage & expected, const RenderedImage & actual)
+    {
+        if (expected.GetWidth() != actual.GetWidth() || expected.GetHeight() != actual.GetHeight())
+        {
+            throw std::runtime_error("Image comparison: the images differ in size.");
+        }
+    }
+
+    ImageComparison CompareImages(const RenderedImage & expected, const RenderedImage & actual)
+    {
+        CheckSizes(expected, actual);
+
+        ImageComparison comparison;
+
+        if (expected.IsEmpty())
+        {
+            return comparison;
+        }
+
+        DifferenceSums sums;
+
+        for (int y = 0; y < expected.GetHeight(); ++y)
+        {
+            SumDifferences(expected.GetRow(y), actual.GetRow(y), expected.GetWidth(), sums);
+        }
+
+        comparison.maxDelta = sums.maxDelta;
+        comparison.differentPixels = sums.differentPixels;
+
+        if (sums.squares > 0)
+        {
+            const double samples = 3.0 * expected.GetWidth() * expected.GetHeight();
+            const double meanSquare = static_cast<double>(sums.squares) / samples;
+
+            comparison.psnr = 10.0 * std::log10(255.0 * 255.0 / meanSquare);
+            comparison.ssim = ComputeSsim(expected, actual);
+        }
+
+        return comparison;
+    }
+
+    static void DrawHeatmapSpan(const unsigned char * a,
+                                const unsigned char * b,
+                                unsigned char * destination,
+                                int count)
+    {
+        int x = 0;
+
+#if defined(GDIPP_SIMD_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+        const __m128i byteMask = _mm_set1_epi32(0xFF);
+        const __m128i dimMask = _mm_set1_epi32(0x00FCFCFC);
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        const __m128i darkest = _mm_set1_epi32(64);
+        const __m128i half = _mm_set1_epi32(128);
+
+        for (; x + 4 <= count; x += 4)
+        {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x * 4));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x * 4));
+            const __m128i delta = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va)), colorMask);
+
+            // largest channel difference in the low byte of every pixel
+            __m128i level = _mm_max_epu8(delta, _mm_max_epu8(_mm_srli_epi32(delta, 8), _mm_srli_epi32(delta, 16)));
+            level = _mm_and_si128(level, byteMask);
+
+            const __m128i equal = _mm_cmpeq_epi32(level, zero);
+
+            // 4x, at least dark red; red above 128 turns the green on
+            level = _mm_adds_epu8(level, level);
+            level = _mm_and_si128(_mm_max_epu8(_mm_adds_epu8(level, level), darkest), byteMask);
+
+            const __m128i excess = _mm_subs_epu8(level, half);
+            const __m128i green = _mm_and_si128(_mm_adds_epu8(excess, excess), byteMask);
+            const __m128i heat = _mm_or_si128(_mm_slli_epi32(level, 16), _mm_slli_epi32(green, 8));
+
+            const __m128i dimmed = _mm_srli_epi32(_mm_and_si128(va, dimMask), 2);
+            const __m128i result = _mm_or_si128(_mm_or_si128(_mm_and_si128(equal, dimmed), _mm_andnot_si128(equal, heat)), alpha);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x * 4), result);
+        }
+#endif
+
+        for (; x < count; ++x)
+        {
+            const unsigned char * pixelA = &a[x * 4];
+            const unsigned char * pixelB = &b[x * 4];
+            unsigned char * pixel = &destination[x * 4];
+
+            int level = 0;
+
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                level = std::max(level, std::abs(pixelA[channel] - pixelB[channel]));
+            }
+
+            if (level == 0)
+            {
+                pixel[0] = static_cast<unsigned char>(pixelA[0] >> 2);
+                pixel[1] = static_cast<unsigned char>(pixelA[1] >> 2);
+                pixel[2] = static_cast<unsigned char>(pixelA[2] >> 2);
+            }
+            else
+            {
+                level = std::max(std::min(level * 4, 255), 64);
+
+                pixel[0] = 0;
+                pixel[1] = static_cast<unsigned char>(std::min(std::max(level - 128, 0) * 2, 255));
+                pixel[2] = static_cast<unsigned char>(level);
+            }
+
+            pixel[3] = 0xFF;
+        }
+    }
+
+    RenderedImage CreateDifferenceHeatmap(const RenderedImage & expected, const RenderedImage & actual)
+    {
+        CheckSizes(expected, actual);
+
+        RenderedImage heatmap(expected.GetWidth(), expected.GetHeight(), 0);
+        DrawDifferenceHeatmapInTile(expected, actual, heatmap, 0, 0, expected.GetWidth(), expected.GetHeight());
+
+        return heatmap;
+    }
+
+    void DrawDifferenceHeatmapInTile(const RenderedImage & expected,
+                                     const RenderedImage & actual,
+                                     RenderedImage & heatmap,
+                                     int tileX,
+                                     int tileY,
+                                     int tileWidth,
+                                     int tileHeight)
+    {
+        CheckSizes(expected, actual);
+        CheckSizes(expected, heatmap);
+
+        for (int y = tileY; y < tileY + tileHeight; ++y)
+        {
+            DrawHeatmapSpan(expected.GetRow(y) + tileX * 4,
+                            actual.GetRow(y) + tileX * 4,
+                            heatmap.GetRow(y) + tileX * 4,
+                            tileWidth);
+        }
+    }
+} // namespace GDIPPRenderer
@@ -0,0 +1,70 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+#include "rendered_image.h"
+
+namespace GDIPPRenderer
+{
+    class ImageComparison
+    {
+        /*
+        *   How far an image is from the expected one, over the B, G and R
+        *   channels; alpha is ignored.
+        */
+
+    public:
+        ImageComparison();
+
+        // mean SSIM of the three channels over 8x8 windows 4 pixels apart,
+        // 1.0 for identical images
+        double ssim;
+
+        // in dB, infinite for identical images
+        double psnr;
+
+        // the largest difference of one channel, 0 - 255
+        int maxDelta;
+
+        size_t differentPixels;
+    };
+
+    // images of one size, throws std::runtime_error otherwise
+    extern ImageComparison CompareImages(const RenderedImage & expected, const RenderedImage & actual);
+
+    // the expected image dimmed where the pixels match, elsewhere the
+    // largest channel difference from dark red (1) to yellow (64 and more)
+    extern RenderedImage CreateDifferenceHeatmap(const RenderedImage & expected, const RenderedImage & actual);
+
+    // the heatmap of a single rectangle, written to the same rectangle of a
+    // heatmap image of the size of both images
+    extern void DrawDifferenceHeatmapInTile(const RenderedImage & expected,
+                                            const RenderedImage & actual,
+                                            RenderedImage & heatmap,
+                                            int tileX,
+                                            int tileY,
+                                            int tileWidth,
+                                            int tileHeight);
+}
@@ -0,0 +1,781 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "image_writer.h"
+#include "inflate_stream.h"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../gdipp-conf-editor/util.h"
+#include "../gdipp-conf-editor/trace.h"
+#include "../gdipp-conf-editor/metrics.h"
+
+namespace GDIPPRenderer
+{
+    class Crc32Table
+    {
+    public:
+        Crc32Table()
+        {
+            for (unsigned int i = 0; i < 256; ++i)
+            {
+                unsigned int crc = i;
+
+                for (int bit = 0; bit < 8; ++bit)
+                {
+                    crc = (crc & 1) ? 0xEDB88320U ^ (crc >> 1) : crc >> 1;
+                }
+
+                table[i] = crc;
+            }
+        }
+
+        unsigned int Update(unsigned int crc, const unsigned char * data, size_t size) const
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+            }
+
+            return crc;
+        }
+
+    private:
+        unsigned int table[256];
+    };
+
+    static const Crc32Table crc32Table;
+
+    ImageFormat GetImageFormat(const MetaString & fileName)
+    {
+        if (fileName == TEXT("-"))
+        {
+            return Image_Frame;
+        }
+
+        const size_t dot = fileName.find_last_of(TEXT('.'));
+        MetaString extension = dot == MetaString::npos ? MetaString() : fileName.substr(dot + 1);
+
+        for (size_t i = 0; i < extension.length(); ++i)
+        {
+            if (extension[i] >= TEXT('A') && extension[i] <= TEXT('Z'))
+            {
+                extension[i] = static_cast<MetaString::value_type>(extension[i] - TEXT('A') + TEXT('a'));
+            }
+        }
+
+        if (extension == TEXT("png"))
+        {
+            return Image_Png;
+        }
+
+        if (extension == TEXT("raw") || extension == TEXT("bgra"))
+        {
+            return Image_Raw;
+        }
+
+        if (extension == TEXT("gdpf"))
+        {
+            return Image_Frame;
+        }
+
+        return Image_Bmp;
+    }
+
+    void ImageWriter::Write(const void * data, size_t size)
+    {
+        stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+
+        if (!stream)
+        {
+            throw std::runtime_error("ImageWriter: unable to write the image.");
+        }
+    }
+
+    void ImageWriter::WriteU16(unsigned int value)
+    {
+        // little endian, BMP headers
+        const unsigned char bytes[2] =
+        {
+            static_cast<unsigned char>(value & 0xFF),
+            static_cast<unsigned char>((value >> 8) & 0xFF)
+        };
+
+        Write(bytes, 2);
+    }
+
+    void ImageWriter::WriteU32(unsigned int value)
+    {
+        const unsigned char bytes[4] =
+        {
+            static_cast<unsigned char>(value & 0xFF),
+            static_cast<unsigned char>((value >> 8) & 0xFF),
+            static_cast<unsigned char>((value >> 16) & 0xFF),
+            static_cast<unsigned char>((value >> 24) & 0xFF)
+        };
+
+        Write(bytes, 4);
+    }
+
+    RawImageWriter::RawImageWriter(std::ostream & stream)
+        : ImageWriter(stream),
+          width(0)
+    {
+
+    }
+
+    void RawImageWriter::Begin(int width, int)
+    {
+        this->width = width;
+    }
+
+    void RawImageWriter::WriteRow(const unsigned char * row)
+    {
+        Write(row, static_cast<size_t>(width) * 4);
+    }
+
+    void RawImageWriter::End()
+    {
+        stream.flush();
+    }
+
+    FrameImageWriter::FrameImageWriter(std::ostream & stream)
+        : ImageWriter(stream),
+          width(0)
+    {
+
+    }
+
+    void FrameImageWriter::Begin(int width, int height)
+    {
+        this->width = width;
+
+        Write("GDPF", 4);
+        WriteU16(Version);
+        WriteU16(4);
+        WriteU32(static_cast<unsigned int>(width));
+        WriteU32(static_cast<unsigned int>(height));
+    }
+
+    void FrameImageWriter::WriteRow(const unsigned char * row)
+    {
+        Write(row, static_cast<size_t>(width) * 4);
+    }
+
+    void FrameImageWriter::End()
+    {
+        stream.flush();
+    }
+
+    static unsigned int ReadU16(const unsigned char * data)
+    {
+        return data[0] | (data[1] << 8);
+    }
+
+    static unsigned int ReadU32(const unsigned char * data)
+    {
+        return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<unsigned int>(data[3]) << 24);
+    }
+
+    bool ReadFrame(std::istream & stream, RenderedImage & image)
+    {
+        unsigned char header[FrameImageWriter::HeaderSize];
+
+        stream.read(reinterpret_cast<char*>(header), FrameImageWriter::HeaderSize);
+
+        if (stream.gcount() == 0)
+        {
+            return false;
+        }
+
+        if (stream.gcount() != FrameImageWriter::HeaderSize)
+        {
+            throw std::runtime_error("ReadFrame: truncated frame.");
+        }
+
+        if (header[0] != 'G' || header[1] != 'D' || header[2] != 'P' || header[3] != 'F')
+        {
+            throw std::runtime_error("ReadFrame: not a frame header.");
+        }
+
+        if (ReadU16(header + 4) != FrameImageWriter::Version || ReadU16(header + 6) != 4)
+        {
+            throw std::runtime_error("ReadFrame: unsupported frame version.");
+        }
+
+        const unsigned int width = ReadU32(header + 8);
+        const unsigned int height = ReadU32(header + 12);
+
+        // anything bigger than 32k x 32k is a corrupted header
+        if (width > 32768 || height > 32768)
+        {
+            throw std::runtime_error("ReadFrame: invalid frame size.");
+        }
+
+        // reuses the pixel buffer when frames of one size are read in a loop
+        image.Resize(static_cast<int>(width), static_cast<int>(height), 0);
+
+        for (unsigned int y = 0; y < height; ++y)
+        {
+            stream.read(reinterpret_cast<char*>(image.GetRow(y)), static_cast<std::streamsize>(width) * 4);
+
+            if (stream.gcount() != static_cast<std::streamsize>(width) * 4)
+            {
+                throw std::runtime_error("ReadFrame: truncated frame.");
+            }
+        }
+
+        return true;
+    }
+
+    BmpImageWriter::BmpImageWriter(std::ostream & stream)
+        : ImageWriter(stream),
+          width(0)
+    {
+
+    }
+
+    void BmpImageWriter::Begin(int width, int height)
+    {
+        this->width = width;
+
+        const unsigned int rowSize = (static_cast<unsigned int>(width) * 3 + 3) & ~3U;
+        const unsigned int imageSize = rowSize * height;
+        const unsigned int headersSize = 14 + 40;
+
+        // padding bytes stay zero
+        scanline.assign(rowSize, 0);
+
+        // BITMAPFILEHEADER
+        Write("BM", 2);
+        WriteU32(headersSize + imageSize);
+        WriteU32(0);
+        WriteU32(headersSize);
+
+        // BITMAPINFOHEADER, negative height - top-down rows
+        WriteU32(40);
+        WriteU32(static_cast<unsigned int>(width));
+        WriteU32(static_cast<unsigned int>(-height));
+        WriteU16(1);
+        WriteU16(24);
+        WriteU32(0);
+        WriteU32(imageSize);
+        WriteU32(2835);
+        WriteU32(2835);
+        WriteU32(0);
+        WriteU32(0);
+    }
+
+    void BmpImageWriter::WriteRow(const unsigned char * row)
+    {
+        unsigned char * target = &scanline[0];
+
+        for (int x = 0; x < width; ++x)
+        {
+            target[0] = row[0];
+            target[1] = row[1];
+            target[2] = row[2];
+
+            target += 3;
+            row += 4;
+        }
+
+        Write(&scanline[0], scanline.size());
+    }
+
+    void BmpImageWriter::End()
+    {
+        stream.flush();
+    }
+
+    PngImageWriter::PngImageWriter(std::ostream & stream, bool compress)
+        : ImageWriter(stream),
+          compress(compress),
+          width(0),
+          deflate(NULL)
+    {
+
+    }
+
+    PngImageWriter::~PngImageWriter()
+    {
+        // End() was not reached, e.g. the stream threw
+        delete deflate;
+    }
+
+    void PngImageWriter::WriteChunk(const char * type, const unsigned char * data, size_t size)
+    {
+        const unsigned char length[4] =
+        {
+            static_cast<unsigned char>((size >> 24) & 0xFF),
+            static_cast<unsigned char>((size >> 16) & 0xFF),
+            static_cast<unsigned char>((size >> 8) & 0xFF),
+            static_cast<unsigned char>(size & 0xFF)
+        };
+
+        unsigned int crc = crc32Table.Update(0xFFFFFFFFU, reinterpret_cast<const unsigned char*>(type), 4);
+        crc = crc32Table.Update(crc, data, size) ^ 0xFFFFFFFFU;
+
+        const unsigned char crcBytes[4] =
+        {
+            static_cast<unsigned char>(crc >> 24),
+            static_cast<unsigned char>(crc >> 16),
+            static_cast<unsigned char>(crc >> 8),
+            static_cast<unsigned char>(crc)
+        };
+
+        Write(length, 4);
+        Write(type, 4);
+
+        if (size > 0)
+        {
+            Write(data, size);
+        }
+
+        Write(crcBytes, 4);
+    }
+
+    void PngImageWriter::FlushData(size_t minimumSize)
+    {
+        // IDAT chunks of a few tens of KB, as soon as there is enough data
+        if (compressed.size() >= minimumSize && !compressed.empty())
+        {
+            WriteChunk("IDAT", &compressed[0], compressed.size());
+            compressed.clear();
+        }
+    }
+
+    void PngImageWriter::Begin(int width, int height)
+    {
+        static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+
+        this->width = width;
+
+        const unsigned char header[13] =
+        {
+            static_cast<unsigned char>((width >> 24) & 0xFF),
+            static_cast<unsigned char>((width >> 16) & 0xFF),
+            static_cast<unsigned char>((width >> 8) & 0xFF),
+            static_cast<unsigned char>(width & 0xFF),
+            static_cast<unsigned char>((height >> 24) & 0xFF),
+            static_cast<unsigned char>((height >> 16) & 0xFF),
+            static_cast<unsigned char>((height >> 8) & 0xFF),
+            static_cast<unsigned char>(height & 0xFF),
+            8,  // bit depth
+            2,  // RGB
+            0,  // deflate
+            0,  // adaptive filtering
+            0   // no interlace
+        };
+
+        Write(signature, 8);
+        WriteChunk("IHDR", header, 13);
+
+        scanline.resize(1 + static_cast<size_t>(width) * 3);
+        compressed.clear();
+
+        delete deflate;
+        deflate = new DeflateStream(compressed, compress);
+    }
+
+    void PngImageWriter::WriteRow(const unsigned char * row)
+    {
+        // filter type 1 - Sub, every byte minus the same channel on the left
+        unsigned char * target = &scanline[0];
+        * target++ = 1;
+
+        unsigned char left[3] = { 0, 0, 0 };
+
+        for (int x = 0; x < width; ++x)
+        {
+            const unsigned char red = row[2];
+            const unsigned char green = row[1];
+            const unsigned char blue = row[0];
+
+            target[0] = static_cast<unsigned char>(red - left[0]);
+            target[1] = static_cast<unsigned char>(green - left[1]);
+            target[2] = static_cast<unsigned char>(blue - left[2]);
+
+            left[0] = red;
+            left[1] = green;
+            left[2] = blue;
+
+            target += 3;
+            row += 4;
+        }
+
+        deflate->Write(&scanline[0], scanline.size());
+        FlushData(65536);
+    }
+
+    void PngImageWriter::End()
+    {
+        deflate->Finish();
+        FlushData(0);
+
+        delete deflate;
+        deflate = NULL;
+
+        WriteChunk("IEND", NULL, 0);
+        stream.flush();
+    }
+
+    void WriteImage(ImageWriter & writer,
+                    const unsigned char * pixels,
+                    int width,
+                    int height,
+                    int stride)
+    {
+        writer.Begin(width, height);
+
+        for (int y = 0; y < height; ++y)
+        {
+            writer.WriteRow(pixels + static_cast<ptrdiff_t>(y) * stride);
+        }
+
+        writer.End();
+    }
+
+    void WriteImage(ImageWriter & writer, const RenderedImage & image)
+    {
+        writer.Begin(image.GetWidth(), image.GetHeight());
+
+        for (int y = 0; y < image.GetHeight(); ++y)
+        {
+            writer.WriteRow(image.GetRow(y));
+        }
+
+        writer.End();
+    }
+
+    void SaveImage(const unsigned char * pixels,
+                   int width,
+                   int height,
+                   int stride,
+                   const MetaString & fileName)
+    {
+        GDIPP_TRACE_SCOPE("SaveImage");
+
+        if (fileName == TEXT("-"))
+        {
+            FrameImageWriter writer(std::cout);
+            WriteImage(writer, pixels, width, height, stride);
+            return;
+        }
+
+        std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+
+        if (!file)
+        {
+            throw std::runtime_error("Unable to create image file: " + Util::MetaStringToAnsi(fileName));
+        }
+
+        switch (GetImageFormat(fileName))
+        {
+        case Image_Raw:
+            {
+                RawImageWriter writer(file);
+                WriteImage(writer, pixels, width, height, stride);
+                break;
+            }
+        case Image_Png:
+            {
+                PngImageWriter writer(file);
+                WriteImage(writer, pixels, width, height, stride);
+                break;
+            }
+        case Image_Frame:
+            {
+                FrameImageWriter writer(file);
+                WriteImage(writer, pixels, width, height, stride);
+                break;
+            }
+        default:
+            {
+                BmpImageWriter writer(file);
+                WriteImage(writer, pixels, width, height, stride);
+                break;
+            }
+        }
+
+        if (file)
+        {
+            Metrics::Add(Metrics::Counter_BytesWritten, static_cast<unsigned long long>(file.tellp()));
+        }
+    }
+
+    RenderedImage LoadFrame(const MetaString & fileName)
+    {
+        std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+
+        if (!file)
+        {
+            throw std::runtime_error("Unable to open image file: " + Util::MetaStringToAnsi(fileName));
+        }
+
+        RenderedImage image;
+
+        if (!ReadFrame(file, image))
+        {
+            throw std::runtime_error("Empty image file: " + Util::MetaStringToAnsi(fileName));
+        }
+
+        return image;
+    }
+
+    void SaveImage(const RenderedImage & image, const MetaString & fileName)
+    {
+        if (image.IsEmpty())
+        {
+            throw std::runtime_error("Nothing to save, the image is empty.");
+        }
+
+        SaveImage(image.GetRow(0), image.GetWidth(), image.GetHeight(), image.GetStride(), fileName);
+    }
+
+    static unsigned int ReadU32BigEndian(const unsigned char * data)
+    {
+        return (static_cast<unsigned int>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+    }
+
+    static int PaethPredictor(int left, int above, int aboveLeft)
+    {
+        const int estimate = left + above - aboveLeft;
+        const int distanceLeft = std::abs(estimate - left);
+        const int distanceAbove = std::abs(estimate - above);
+        const int distanceAboveLeft = std::abs(estimate - aboveLeft);
+
+        if (distanceLeft <= distanceAbove && distanceLeft <= distanceAboveLeft)
+        {
+            return left;
+        }
+
+        return distanceAbove <= distanceAboveLeft ? above : aboveLeft;
+    }
+
+    // undoes the filter of one scanline in place, previous is the
+    // unfiltered line above, zeros for the first one
+    static void UnfilterScanline(int filter,
+                                 unsigned char * line,
+                                 const unsigned char * previous,
+                                 size_t size,
+                                 size_t pixelSize)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            const int left = i >= pixelSize ? line[i - pixelSize] : 0;
+            const int above = previous[i];
+            const int aboveLeft = i >= pixelSize ? previous[i - pixelSize] : 0;
+            int prediction;
+
+            switch (filter)
+            {
+            case 0:
+                prediction = 0;
+                break;
+
+            case 1:
+                prediction = left;
+                break;
+
+            case 2:
+                prediction = above;
+                break;
+
+            case 3:
+                prediction = (left + above) / 2;
+                break;
+
+            case 4:
+                prediction = PaethPredictor(left, above, aboveLeft);
+                break;
+
+            default:
+                throw std::runtime_error("LoadPng: invalid filter type.");
+            }
+
+            line[i] = static_cast<unsigned char>(line[i] + prediction);
+        }
+    }
+
+    RenderedImage LoadPng(const MetaString & fileName)
+    {
+        static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+
+        std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+
+        if (!file)
+        {
+            throw std::runtime_error("Unable to open image file: " + Util::MetaStringToAnsi(fileName));
+        }
+
+        unsigned char header[8];
+        file.read(reinterpret_cast<char*>(header), 8);
+
+        if (file.gcount() != 8 || !std::equal(header, header + 8, signature))
+        {
+            throw std::runtime_error("LoadPng: not a PNG file.");
+        }
+
+        unsigned int width = 0;
+        unsigned int height = 0;
+        size_t pixelSize = 0;
+        std::vector<unsigned char> compressed;
+        std::vector<unsigned char> chunk;
+
+        while (true)
+        {
+            file.read(reinterpret_cast<char*>(header), 8);
+
+            if (file.gcount() != 8)
+            {
+                throw std::runtime_error("LoadPng: truncated file.");
+            }
+
+            const unsigned int size = ReadU32BigEndian(header);
+
+            if (size > 0x7FFFFFFFU)
+            {
+                throw std::runtime_error("LoadPng: invalid chunk size.");
+            }
+
+            // the data and the CRC
+            chunk.resize(static_cast<size_t>(size) + 4);
+            file.read(reinterpret_cast<char*>(&chunk[0]), static_cast<std::streamsize>(chunk.size()));
+
+            if (file.gcount() != static_cast<std::streamsize>(chunk.size()))
+            {
+                throw std::runtime_error("LoadPng: truncated file.");
+            }
+
+            unsigned int crc = crc32Table.Update(0xFFFFFFFFU, header + 4, 4);
+            crc = crc32Table.Update(crc, &chunk[0], size) ^ 0xFFFFFFFFU;
+
+            if (crc != ReadU32BigEndian(&chunk[size]))
+            {
+                throw std::runtime_error("LoadPng: chunk CRC mismatch.");
+            }
+
+            const std::string type(reinterpret_cast<const char*>(header + 4), 4);
+
+            if (type == "IHDR")
+            {
+                if (size != 13)
+                {
+                    throw std::runtime_error("LoadPng: invalid header.");
+                }
+
+                width = ReadU32BigEndian(&chunk[0]);
+                height = ReadU32BigEndian(&chunk[4]);
+
+                // bit depth 8, RGB or RGBA, deflate, adaptive filtering, no interlace
+                if (chunk[8] != 8 || (chunk[9] != 2 && chunk[9] != 6) || chunk[10] != 0 || chunk[11] != 0 || chunk[12] != 0)
+                {
+                    throw std::runtime_error("LoadPng: only 8-bit RGB and RGBA non-interlaced images are supported.");
+                }
+
+                // anything bigger than 32k x 32k is a corrupted header
+                if (width == 0 || height == 0 || width > 32768 || height > 32768)
+                {
+                    throw std::runtime_error("LoadPng: invalid image size.");
+                }
+
+                pixelSize = chunk[9] == 6 ? 4 : 3;
+            }
+            else if (type == "IDAT")
+            {
+                compressed.insert(compressed.end(), chunk.begin(), chunk.begin() + size);
+            }
+            else if (type == "IEND")
+            {
+                break;
+            }
+            else if ((header[4] & 0x20) == 0)
+            {
+                // an unknown critical chunk, e.g. PLTE, cannot be ignored
+                throw std::runtime_error("LoadPng: unsupported chunk " + type + ".");
+            }
+        }
+
+        if (pixelSize == 0 || compressed.empty())
+        {
+            throw std::runtime_error("LoadPng: missing image data.");
+        }
+
+        std::vector<unsigned char> data;
+        Inflate(&compressed[0], compressed.size(), data);
+
+        const size_t lineSize = width * pixelSize;
+
+        if (data.size() != (lineSize + 1) * height)
+        {
+            throw std::runtime_error("LoadPng: invalid image data size.");
+        }
+
+        RenderedImage image(static_cast<int>(width), static_cast<int>(height), 0);
+        const std::vector<unsigned char> zeros(lineSize, 0);
+        const unsigned char * previous = &zeros[0];
+
+        for (unsigned int y = 0; y < height; ++y)
+        {
+            unsigned char * line = &data[y * (lineSize + 1)];
+            UnfilterScanline(line[0], line + 1, previous, lineSize, pixelSize);
+
+            const unsigned char * source = line + 1;
+            unsigned char * target = image.GetRow(static_cast<int>(y));
+
+            for (unsigned int x = 0; x < width; ++x)
+            {
+                target[0] = source[2];
+                target[1] = source[1];
+                target[2] = source[0];
+                target[3] = pixelSize == 4 ? source[3] : 0xFF;
+
+                source += pixelSize;
+                target += 4;
+            }
+
+            previous = line + 1;
+        }
+
+        return image;
+    }
+
+    RenderedImage LoadImageFile(const MetaString & fileName)
+    {
+        switch (GetImageFormat(fileName))
+        {
+        case Image_Png:
+            return LoadPng(fileName);
+
+        case Image_Frame:
+            return LoadFrame(fileName);
+
+        default:
+            throw std::runtime_error("Only .png and .gdpf images can be loaded: " + Util::MetaStringToAnsi(fileName));
+        }
+    }
+} // namespace GDIPPRenderer
@@ -0,0 +1,205 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <ostream>
+#include <istream>
+
+#include "../gdipp-conf-editor/local_types.h"
+
+#include "rendered_image.h"
+#include "deflate_stream.h"
+
+namespace GDIPPRenderer
+{
+    enum ImageFormat
+    {
+        Image_Raw = 0,
+        Image_Bmp = 1,
+        Image_Png = 2,
+        Image_Frame = 3
+    };
+
+    // by the file name extension: .png, .raw / .bgra, .gdpf (a frame),
+    // anything else is BMP; "-" is a frame on the standard output
+    extern ImageFormat GetImageFormat(const MetaString & fileName);
+
+    class ImageWriter
+    {
+        /*
+        *   Encodes 32-bit top-down BGRA rows, the RenderedImage and DIB
+        *   section layout, as they arrive. Only the encoder state is kept
+        *   in memory, never the whole image.
+        */
+
+    public:
+        ImageWriter(std::ostream & stream)
+            : stream(stream)
+        {
+
+        }
+
+        virtual ~ImageWriter()
+        {
+
+        }
+
+        virtual void Begin(int width, int height) = 0;
+        virtual void WriteRow(const unsigned char * row) = 0;
+        virtual void End() = 0;
+
+    protected:
+        std::ostream & stream;
+
+        void Write(const void * data, size_t size);
+        void WriteU16(unsigned int value);
+        void WriteU32(unsigned int value);
+    };
+
+    class RawImageWriter : public ImageWriter
+    {
+        /*
+        *   The BGRA rows exactly as they are, no header.
+        */
+
+    public:
+        RawImageWriter(std::ostream & stream);
+
+        virtual void Begin(int width, int height);
+        virtual void WriteRow(const unsigned char * row);
+        virtual void End();
+
+    private:
+        int width;
+    };
+
+    class FrameImageWriter : public ImageWriter
+    {
+        /*
+        *   Raw BGRA rows after a 16-byte header, for piping frames between
+        *   processes without an encoder:
+        *
+        *   "GDPF", version (u16), bytes per pixel (u16), width (u32),
+        *   height (u32), little endian.
+        */
+
+    public:
+        static const unsigned int HeaderSize = 16;
+        static const unsigned int Version = 1;
+
+        FrameImageWriter(std::ostream & stream);
+
+        virtual void Begin(int width, int height);
+        virtual void WriteRow(const unsigned char * row);
+        virtual void End();
+
+    private:
+        int width;
+    };
+
+    // reads one frame written by FrameImageWriter, false at the end of the
+    // stream, throws std::runtime_error on a malformed or truncated frame
+    extern bool ReadFrame(std::istream & stream, RenderedImage & image);
+
+    // the first frame of a .gdpf file, throws std::runtime_error when there
+    // is none
+    extern RenderedImage LoadFrame(const MetaString & fileName);
+
+    class BmpImageWriter : public ImageWriter
+    {
+        /*
+        *   24-bit top-down BMP, rows padded to four bytes.
+        */
+
+    public:
+        BmpImageWriter(std::ostream & stream);
+
+        virtual void Begin(int width, int height);
+        virtual void WriteRow(const unsigned char * row);
+        virtual void End();
+
+    private:
+        int width;
+        std::vector<unsigned char> scanline;
+    };
+
+    class PngImageWriter : public ImageWriter
+    {
+        /*
+        *   8-bit RGB PNG, every row with the Sub filter, which turns the
+        *   flat background into zeros. compress false stores the data
+        *   uncompressed, true compresses it like zlib level 1.
+        */
+
+    public:
+        PngImageWriter(std::ostream & stream, bool compress = true);
+        virtual ~PngImageWriter();
+
+        virtual void Begin(int width, int height);
+        virtual void WriteRow(const unsigned char * row);
+        virtual void End();
+
+    private:
+        bool compress;
+        int width;
+
+        std::vector<unsigned char> scanline;
+        std::vector<unsigned char> compressed;
+        DeflateStream * deflate;
+
+        void WriteChunk(const char * type, const unsigned char * data, size_t size);
+        void FlushData(size_t minimumSize);
+
+        PngImageWriter(const PngImageWriter &);
+        PngImageWriter & operator=(const PngImageWriter &);
+    };
+
+    // reads an 8-bit RGB or RGBA, non-interlaced PNG, e.g. one written by
+    // PngImageWriter; throws std::runtime_error on anything else or on a
+    // malformed file
+    extern RenderedImage LoadPng(const MetaString & fileName);
+
+    // stride in bytes, may be negative for bottom-up buffers
+    extern void WriteImage(ImageWriter & writer,
+                           const unsigned char * pixels,
+                           int width,
+                           int height,
+                           int stride);
+
+    extern void WriteImage(ImageWriter & writer, const RenderedImage & image);
+
+    // throws std::runtime_error when the file cannot be written; fileName
+    // "-" writes a frame to std::cout, which the caller puts in binary mode
+    extern void SaveImage(const unsigned char * pixels,
+                          int width,
+                          int height,
+                          int stride,
+                          const MetaString & fileName);
+
+    extern void SaveImage(const RenderedImage & image, const MetaString & fileName);
+
+    // a .png file or the first frame of a .gdpf file, by the file name
+    // extension; throws std::runtime_error for the other formats
+    extern RenderedImage LoadImageFile(const MetaString & fileName);
+}
@@ -0,0 +1,410 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "inflate_stream.h"
+
+#include <stdexcept>
+
+namespace GDIPPRenderer
+{
+    static const int LengthBase[29] =
+    {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+
+    static const int LengthExtraBits[29] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+
+    static const int DistanceBase[30] =
+    {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+
+    static const int DistanceExtraBits[30] =
+    {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+
+    // order the code length code lengths are stored in
+    static const int CodeLengthOrder[19] =
+    {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+    };
+
+    static const int MaximumCodeLength = 15;
+
+    class BitReader
+    {
+        /*
+        *   Deflate data, least significant bit first. At most 7 bits are
+        *   buffered, so dropping them aligns the reader to a byte.
+        */
+
+    public:
+        BitReader(const unsigned char * data, size_t size)
+            : data(data),
+              size(size),
+              position(0),
+              bitBuffer(0),
+              bitCount(0)
+        {
+
+        }
+
+        unsigned int GetBits(int count)
+        {
+            while (bitCount < count)
+            {
+                bitBuffer |= static_cast<unsigned int>(GetBytes(1)[0]) << bitCount;
+                bitCount += 8;
+            }
+
+            const unsigned int bits = bitBuffer & ((1U << count) - 1);
+            bitBuffer >>= count;
+            bitCount -= count;
+
+            return bits;
+        }
+
+        void AlignToByte()
+        {
+            bitBuffer = 0;
+            bitCount = 0;
+        }
+
+        const unsigned char * GetBytes(size_t count)
+        {
+            if (count > size - position)
+            {
+                throw std::runtime_error("Unexpected end of deflate data.");
+            }
+
+            const unsigned char * bytes = data + position;
+            position += count;
+
+            return bytes;
+        }
+
+    private:
+        const unsigned char * data;
+        size_t size;
+        size_t position;
+
+        unsigned int bitBuffer;
+        int bitCount;
+    };
+
+    class HuffmanDecoder
+    {
+        /*
+        *   Canonical Huffman code given by the code length of every
+        *   symbol, decoded one bit at a time.
+        */
+
+    public:
+        // length 0 - the symbol does not occur
+        void Build(const unsigned char * lengths, int symbolCount)
+        {
+            int offsets[MaximumCodeLength + 1];
+
+            for (int length = 0; length <= MaximumCodeLength; ++length)
+            {
+                counts[length] = 0;
+            }
+
+            for (int symbol = 0; symbol < symbolCount; ++symbol)
+            {
+                ++counts[lengths[symbol]];
+            }
+
+            offsets[1] = 0;
+
+            for (int length = 1; length < MaximumCodeLength; ++length)
+            {
+                offsets[length + 1] = offsets[length] + counts[length];
+            }
+
+            for (int symbol = 0; symbol < symbolCount; ++symbol)
+            {
+                if (lengths[symbol] != 0)
+                {
+                    symbols[offsets[lengths[symbol]]++] = symbol;
+                }
+            }
+        }
+
+        int Decode(BitReader & reader) const
+        {
+            // codes of one length are consecutive, first is the first of them
+            int code = 0;
+            int first = 0;
+            int index = 0;
+
+            for (int length = 1; length <= MaximumCodeLength; ++length)
+            {
+                code |= reader.GetBits(1);
+
+                if (code - first < counts[length])
+                {
+                    return symbols[index + code - first];
+                }
+
+                index += counts[length];
+                first = (first + counts[length]) << 1;
+                code <<= 1;
+            }
+
+            throw std::runtime_error("Invalid Huffman code in deflate data.");
+        }
+
+    private:
+        int counts[MaximumCodeLength + 1];
+        int symbols[288];
+    };
+
+    static void InflateCodes(BitReader & reader,
+                             const HuffmanDecoder & literals,
+                             const HuffmanDecoder & distances,
+                             std::vector<unsigned char> & output,
+                             size_t start)
+    {
+        while (true)
+        {
+            const int symbol = literals.Decode(reader);
+
+            if (symbol < 256)
+            {
+                output.push_back(static_cast<unsigned char>(symbol));
+                continue;
+            }
+
+            if (symbol == 256)
+            {
+                return;
+            }
+
+            if (symbol > 285)
+            {
+                throw std::runtime_error("Invalid length in deflate data.");
+            }
+
+            const int lengthSymbol = symbol - 257;
+            const int length = LengthBase[lengthSymbol] + reader.GetBits(LengthExtraBits[lengthSymbol]);
+
+            const int distanceSymbol = distances.Decode(reader);
+
+            if (distanceSymbol >= 30)
+            {
+                throw std::runtime_error("Invalid distance in deflate data.");
+            }
+
+            const size_t distance = DistanceBase[distanceSymbol] + reader.GetBits(DistanceExtraBits[distanceSymbol]);
+
+            if (distance > output.size() - start)
+            {
+                throw std::runtime_error("Deflate data refers before its start.");
+            }
+
+            // byte by byte, the copy may overlap what it writes
+            for (int i = 0; i < length; ++i)
+            {
+                output.push_back(output[output.size() - distance]);
+            }
+        }
+    }
+
+    static void ReadDynamicCodes(BitReader & reader, HuffmanDecoder & literals, HuffmanDecoder & distances)
+    {
+        const int literalCount = reader.GetBits(5) + 257;
+        const int distanceCount = reader.GetBits(5) + 1;
+        const int codeLengthCount = reader.GetBits(4) + 4;
+
+        if (literalCount > 286 || distanceCount > 30)
+        {
+            throw std::runtime_error("Invalid code counts in deflate data.");
+        }
+
+        unsigned char lengths[286 + 30] = { 0 };
+
+        for (int i = 0; i < codeLengthCount; ++i)
+        {
+            lengths[CodeLengthOrder[i]] = static_cast<unsigned char>(reader.GetBits(3));
+        }
+
+        HuffmanDecoder codeLengths;
+        codeLengths.Build(lengths, 19);
+
+        int index = 0;
+
+        while (index < literalCount + distanceCount)
+        {
+            const int symbol = codeLengths.Decode(reader);
+
+            if (symbol < 16)
+            {
+                lengths[index++] = static_cast<unsigned char>(symbol);
+                continue;
+            }
+
+            // 16 repeats the previous length, 17 and 18 write zeros
+            unsigned char length = 0;
+            int repeat;
+
+            if (symbol == 16)
+            {
+                if (index == 0)
+                {
+                    throw std::runtime_error("Invalid code lengths in deflate data.");
+                }
+
+                length = lengths[index - 1];
+                repeat = 3 + reader.GetBits(2);
+            }
+            else if (symbol == 17)
+            {
+                repeat = 3 + reader.GetBits(3);
+            }
+            else
+            {
+                repeat = 11 + reader.GetBits(7);
+            }
+
+            if (index + repeat > literalCount + distanceCount)
+            {
+                throw std::runtime_error("Invalid code lengths in deflate data.");
+            }
+
+            while (repeat-- > 0)
+            {
+                lengths[index++] = length;
+            }
+        }
+
+        literals.Build(lengths, literalCount);
+        distances.Build(lengths + literalCount, distanceCount);
+    }
+
+    static void BuildFixedCodes(HuffmanDecoder & literals, HuffmanDecoder & distances)
+    {
+        unsigned char lengths[288];
+
+        for (int symbol = 0; symbol < 288; ++symbol)
+        {
+            lengths[symbol] = symbol < 144 ? 8 : symbol < 256 ? 9 : symbol < 280 ? 7 : 8;
+        }
+
+        literals.Build(lengths, 288);
+
+        for (int symbol = 0; symbol < 30; ++symbol)
+        {
+            lengths[symbol] = 5;
+        }
+
+        distances.Build(lengths, 30);
+    }
+
+    void Inflate(const unsigned char * data, size_t size, std::vector<unsigned char> & output)
+    {
+        if (size < 6)
+        {
+            throw std::runtime_error("Unexpected end of zlib data.");
+        }
+
+        // deflate, no preset dictionary, header check
+        if ((data[0] & 0x0F) != 8 || (data[1] & 0x20) != 0 || (data[0] * 256 + data[1]) % 31 != 0)
+        {
+            throw std::runtime_error("Unsupported zlib header.");
+        }
+
+        const size_t start = output.size();
+        BitReader reader(data + 2, size - 2);
+        bool last = false;
+
+        while (!last)
+        {
+            last = reader.GetBits(1) != 0;
+            const unsigned int type = reader.GetBits(2);
+
+            if (type == 0)
+            {
+                reader.AlignToByte();
+
+                const unsigned char * header = reader.GetBytes(4);
+                const unsigned int length = header[0] | (header[1] << 8);
+
+                if (static_cast<unsigned int>(header[2] | (header[3] << 8)) != (~length & 0xFFFF))
+                {
+                    throw std::runtime_error("Invalid stored block in deflate data.");
+                }
+
+                const unsigned char * bytes = reader.GetBytes(length);
+                output.insert(output.end(), bytes, bytes + length);
+            }
+            else if (type == 1 || type == 2)
+            {
+                HuffmanDecoder literals;
+                HuffmanDecoder distances;
+
+                if (type == 1)
+                {
+                    BuildFixedCodes(literals, distances);
+                }
+                else
+                {
+                    ReadDynamicCodes(reader, literals, distances);
+                }
+
+                InflateCodes(reader, literals, distances, output, start);
+            }
+            else
+            {
+                throw std::runtime_error("Invalid block type in deflate data.");
+            }
+        }
+
+        reader.AlignToByte();
+        const unsigned char * trailer = reader.GetBytes(4);
+
+        unsigned int adlerA = 1;
+        unsigned int adlerB = 0;
+
+        for (size_t i = start; i < output.size(); ++i)
+        {
+            adlerA = (adlerA + output[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+
+        const unsigned int adler = (static_cast<unsigned int>(trailer[0]) << 24) |
+                                   (trailer[1] << 16) | (trailer[2] << 8) | trailer[3];
+
+        if (adler != ((adlerB << 16) | adlerA))
+        {
+            throw std::runtime_error("zlib checksum mismatch.");
+        }
+    }
+} // namespace GDIPPRenderer
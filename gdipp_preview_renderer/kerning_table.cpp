@@ -0,0 +1,558 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "kerning_table.h"
+
+#include <map>
+#include <set>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+namespace GDIPPRenderer
+{
+    // GPOS value record fields
+    static const unsigned int Value_XPlacement = 0x0001;
+    static const unsigned int Value_YPlacement = 0x0002;
+    static const unsigned int Value_XAdvance = 0x0004;
+
+    static const unsigned int Lookup_PairAdjustment = 2;
+    static const unsigned int Lookup_Extension = 9;
+
+    // legacy kern subtable coverage bits
+    static const unsigned int Kern_Horizontal = 0x01;
+    static const unsigned int Kern_Minimum = 0x02;
+    static const unsigned int Kern_CrossStream = 0x04;
+    static const unsigned int Kern_Override = 0x08;
+
+    class FontDataReader
+    {
+    public:
+        FontDataReader(const std::vector<unsigned char> & data)
+            : data(data)
+        {
+
+        }
+
+        unsigned int U16(unsigned int offset) const
+        {
+            if (offset + 2 > data.size() || offset + 2 < offset)
+            {
+                throw std::runtime_error("Unexpected end of font data.");
+            }
+
+            return (static_cast<unsigned int>(data[offset]) << 8) | data[offset + 1];
+        }
+
+        int S16(unsigned int offset) const
+        {
+            return static_cast<short>(static_cast<unsigned short>(U16(offset)));
+        }
+
+        unsigned int U32(unsigned int offset) const
+        {
+            return (U16(offset) << 16) | U16(offset + 2);
+        }
+
+        bool TagEquals(unsigned int offset, const char * tag) const
+        {
+            return offset + 4 <= data.size() && memcmp(&data[offset], tag, 4) == 0;
+        }
+
+    private:
+        const std::vector<unsigned char> & data;
+    };
+
+    static int GetValueRecordSize(unsigned int valueFormat)
+    {
+        int size = 0;
+
+        for (unsigned int bit = 1; bit <= 0x80; bit <<= 1)
+        {
+            if (valueFormat & bit)
+            {
+                size += 2;
+            }
+        }
+
+        return size;
+    }
+
+    // x advance of a value record, 0 when the record has none
+    static int ReadXAdvance(const FontDataReader & reader, unsigned int record, unsigned int valueFormat)
+    {
+        if (!(valueFormat & Value_XAdvance))
+        {
+            return 0;
+        }
+
+        unsigned int offset = record;
+
+        if (valueFormat & Value_XPlacement)
+        {
+            offset += 2;
+        }
+
+        if (valueFormat & Value_YPlacement)
+        {
+            offset += 2;
+        }
+
+        return reader.S16(offset);
+    }
+
+    // appends (glyph, coverage index) for every covered glyph
+    static void ReadCoverage(const FontDataReader & reader,
+                             unsigned int coverage,
+                             int numGlyphs,
+                             std::vector<std::pair<unsigned int, unsigned int> > & glyphs)
+    {
+        const unsigned int format = reader.U16(coverage);
+
+        if (format == 1)
+        {
+            const unsigned int count = reader.U16(coverage + 2);
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                glyphs.push_back(std::make_pair(reader.U16(coverage + 4 + 2 * i), i));
+            }
+        }
+        else if (format == 2)
+        {
+            const unsigned int rangeCount = reader.U16(coverage + 2);
+
+            for (unsigned int r = 0; r < rangeCount; ++r)
+            {
+                const unsigned int range = coverage + 4 + 6 * r;
+                const unsigned int first = reader.U16(range);
+                const unsigned int last = reader.U16(range + 2);
+                const unsigned int startIndex = reader.U16(range + 4);
+
+                for (unsigned int glyph = first; glyph <= last && glyph < static_cast<unsigned int>(numGlyphs); ++glyph)
+                {
+                    glyphs.push_back(std::make_pair(glyph, startIndex + glyph - first));
+                }
+            }
+        }
+    }
+
+    static void ReadClassDefinition(const FontDataReader & reader,
+                                    unsigned int classDefinition,
+                                    std::vector<unsigned short> & classes)
+    {
+        // glyphs not listed are class 0
+        const unsigned int format = reader.U16(classDefinition);
+
+        if (format == 1)
+        {
+            const unsigned int startGlyph = reader.U16(classDefinition + 2);
+            const unsigned int count = reader.U16(classDefinition + 4);
+
+            for (unsigned int i = 0; i < count && startGlyph + i < classes.size(); ++i)
+            {
+                classes[startGlyph + i] = static_cast<unsigned short>(reader.U16(classDefinition + 6 + 2 * i));
+            }
+        }
+        else if (format == 2)
+        {
+            const unsigned int rangeCount = reader.U16(classDefinition + 2);
+
+            for (unsigned int r = 0; r < rangeCount; ++r)
+            {
+                const unsigned int range = classDefinition + 4 + 6 * r;
+                const unsigned int first = reader.U16(range);
+                const unsigned int last = reader.U16(range + 2);
+                const unsigned short value = static_cast<unsigned short>(reader.U16(range + 4));
+
+                for (unsigned int glyph = first; glyph <= last && glyph < classes.size(); ++glyph)
+                {
+                    classes[glyph] = value;
+                }
+            }
+        }
+    }
+
+    KerningTable::KerningTable()
+        : mask(0),
+          shift(32),
+          pairCount(0)
+    {
+
+    }
+
+    void KerningTable::Clear()
+    {
+        slots.clear();
+        mask = 0;
+        shift = 32;
+        pairCount = 0;
+        classSubtables.clear();
+    }
+
+    int KerningTable::GetClassAdjustment(unsigned int left, unsigned int right) const
+    {
+        int adjustment = 0;
+
+        for (size_t i = FindClassSubtable(0, left); i < classSubtables.size(); i = FindClassSubtable(i, left))
+        {
+            const unsigned int lookup = classSubtables[i].lookup;
+            adjustment += classSubtables[i].GetValue(left, right);
+
+            // the first subtable covering the left glyph applies, skip the
+            // rest of its lookup
+            while (i < classSubtables.size() && classSubtables[i].lookup == lookup)
+            {
+                ++i;
+            }
+        }
+
+        return adjustment;
+    }
+
+    size_t KerningTable::FindClassSubtable(size_t first, unsigned int left) const
+    {
+        for (size_t i = first; i < classSubtables.size(); ++i)
+        {
+            if (left < classSubtables[i].firstClasses.size() && classSubtables[i].firstClasses[left] != NotCovered)
+            {
+                return i;
+            }
+        }
+
+        return classSubtables.size();
+    }
+
+    void KerningTable::SetPairs(const std::vector<std::pair<unsigned int, int> > & pairs)
+    {
+        // at most half full, probe sequences stay short
+        unsigned int capacity = 16;
+        shift = 28;
+
+        while (capacity < pairs.size() * 2)
+        {
+            capacity *= 2;
+            --shift;
+        }
+
+        mask = capacity - 1;
+
+        Slot empty;
+        empty.key = EmptyKey;
+        empty.value = 0;
+
+        slots.assign(capacity, empty);
+
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            if (pairs[i].first == EmptyKey)
+            {
+                continue;
+            }
+
+            unsigned int slot = Hash(pairs[i].first);
+
+            while (slots[slot].key != EmptyKey)
+            {
+                slot = (slot + 1) & mask;
+            }
+
+            slots[slot].key = pairs[i].first;
+            slots[slot].value = pairs[i].second;
+        }
+
+        pairCount = pairs.size();
+    }
+
+    void KerningTable::Build(const std::vector<unsigned char> & fontData,
+                             unsigned int kernTable,
+                             unsigned int gposTable,
+                             int numGlyphs)
+    {
+        Clear();
+
+        const FontDataReader reader(fontData);
+
+        // summed over the lookups
+        std::map<unsigned int, int> pairs;
+
+        try
+        {
+            if (gposTable != 0)
+            {
+                const unsigned int featureList = gposTable + reader.U16(gposTable + 6);
+                const unsigned int lookupList = gposTable + reader.U16(gposTable + 8);
+
+                // lookups of every `kern` feature, in lookup list order
+                std::set<unsigned int> lookupIndices;
+                const unsigned int featureCount = reader.U16(featureList);
+
+                for (unsigned int f = 0; f < featureCount; ++f)
+                {
+                    const unsigned int record = featureList + 2 + 6 * f;
+
+                    if (!reader.TagEquals(record, "kern"))
+                    {
+                        continue;
+                    }
+
+                    const unsigned int feature = featureList + reader.U16(record + 4);
+                    const unsigned int lookupCount = reader.U16(feature + 2);
+
+                    for (unsigned int l = 0; l < lookupCount; ++l)
+                    {
+                        lookupIndices.insert(reader.U16(feature + 4 + 2 * l));
+                    }
+                }
+
+                for (std::set<unsigned int>::const_iterator it = lookupIndices.begin(); it != lookupIndices.end(); ++it)
+                {
+                    // class subtables of this lookup start here
+                    const size_t lookupClassSubtables = classSubtables.size();
+
+                    // first value wins, the order subtables are applied in
+                    std::map<unsigned int, int> lookupPairs;
+
+                    const unsigned int lookup = lookupList + reader.U16(lookupList + 2 + 2 * (* it));
+                    const unsigned int lookupType = reader.U16(lookup);
+                    const unsigned int subtableCount = reader.U16(lookup + 4);
+
+                    for (unsigned int s = 0; s < subtableCount; ++s)
+                    {
+                        unsigned int subtable = lookup + reader.U16(lookup + 6 + 2 * s);
+                        unsigned int type = lookupType;
+
+                        if (type == Lookup_Extension)
+                        {
+                            type = reader.U16(subtable + 2);
+                            subtable += reader.U32(subtable + 4);
+                        }
+
+                        if (type != Lookup_PairAdjustment)
+                        {
+                            continue;
+                        }
+
+                        const unsigned int format = reader.U16(subtable);
+                        const unsigned int valueFormat1 = reader.U16(subtable + 4);
+                        const unsigned int valueFormat2 = reader.U16(subtable + 6);
+                        const int valueSize1 = GetValueRecordSize(valueFormat1);
+                        const int valueSize2 = GetValueRecordSize(valueFormat2);
+
+                        std::vector<std::pair<unsigned int, unsigned int> > covered;
+                        ReadCoverage(reader, subtable + reader.U16(subtable + 2), numGlyphs, covered);
+
+                        if (format == 1)
+                        {
+                            const unsigned int pairSetCount = reader.U16(subtable + 8);
+
+                            for (size_t c = 0; c < covered.size(); ++c)
+                            {
+                                const unsigned int left = covered[c].first;
+
+                                // an earlier class subtable of the lookup applies instead
+                                if (covered[c].second >= pairSetCount ||
+                                    FindClassSubtable(lookupClassSubtables, left) != classSubtables.size())
+                                {
+                                    continue;
+                                }
+
+                                const unsigned int pairSet = subtable + reader.U16(subtable + 10 + 2 * covered[c].second);
+                                const unsigned int pairValueCount = reader.U16(pairSet);
+                                const unsigned int recordSize = 2 + valueSize1 + valueSize2;
+
+                                for (unsigned int p = 0; p < pairValueCount; ++p)
+                                {
+                                    const unsigned int record = pairSet + 2 + recordSize * p;
+                                    const unsigned int right = reader.U16(record);
+
+                                    lookupPairs.insert(std::make_pair((left << 16) | right,
+                                                                ReadXAdvance(reader, record + 2, valueFormat1)));
+                                }
+                            }
+                        }
+                        else if (format == 2)
+                        {
+                            ClassSubtable classSubtable;
+
+                            const unsigned int class1Count = reader.U16(subtable + 12);
+                            const unsigned int class2Count = reader.U16(subtable + 14);
+
+                            if (class1Count == 0 || class2Count == 0)
+                            {
+                                continue;
+                            }
+
+                            const unsigned int recordSize = valueSize1 + valueSize2;
+                            const unsigned long long matrixSize =
+                                static_cast<unsigned long long>(class1Count) * class2Count * std::max(recordSize, 1U);
+
+                            // a malformed count must not allocate more than the font holds
+                            if (subtable + 16 + matrixSize > fontData.size())
+                            {
+                                throw std::runtime_error("Class pair matrix exceeds the font data.");
+                            }
+
+                            classSubtable.lookup = * it;
+                            classSubtable.class2Count = static_cast<int>(class2Count);
+                            classSubtable.firstClasses.assign(numGlyphs, 0);
+                            classSubtable.secondClasses.assign(numGlyphs, 0);
+
+                            ReadClassDefinition(reader, subtable + reader.U16(subtable + 8), classSubtable.firstClasses);
+                            ReadClassDefinition(reader, subtable + reader.U16(subtable + 10), classSubtable.secondClasses);
+
+                            // only covered first glyphs, with classes in range
+                            std::vector<unsigned short> firstClasses(numGlyphs, static_cast<unsigned short>(NotCovered));
+
+                            for (size_t c = 0; c < covered.size(); ++c)
+                            {
+                                const unsigned int glyph = covered[c].first;
+
+                                if (glyph < firstClasses.size() && classSubtable.firstClasses[glyph] < class1Count)
+                                {
+                                    firstClasses[glyph] = classSubtable.firstClasses[glyph];
+                                }
+                            }
+
+                            classSubtable.firstClasses.swap(firstClasses);
+
+                            for (size_t g = 0; g < classSubtable.secondClasses.size(); ++g)
+                            {
+                                if (classSubtable.secondClasses[g] >= class2Count)
+                                {
+                                    classSubtable.secondClasses[g] = 0;
+                                }
+                            }
+
+                            classSubtable.values.resize(class1Count * class2Count);
+
+                            for (unsigned int c1 = 0; c1 < class1Count; ++c1)
+                            {
+                                for (unsigned int c2 = 0; c2 < class2Count; ++c2)
+                                {
+                                    const unsigned int record = subtable + 16 + recordSize * (c1 * class2Count + c2);
+
+                                    classSubtable.values[c1 * class2Count + c2] =
+                                        static_cast<short>(ReadXAdvance(reader, record, valueFormat1));
+                                }
+                            }
+
+                            classSubtables.push_back(classSubtable);
+                        }
+                    }
+
+                    for (std::map<unsigned int, int>::const_iterator pair = lookupPairs.begin(); pair != lookupPairs.end(); ++pair)
+                    {
+                        const unsigned int left = pair->first >> 16;
+                        const unsigned int right = pair->first & 0xFFFF;
+                        const size_t classSubtable = FindClassSubtable(lookupClassSubtables, left);
+                        int value = pair->second;
+
+                        // the pair takes the place of the class value of a
+                        // later subtable in the lookup, which GetAdjustment()
+                        // adds as well
+                        if (classSubtable != classSubtables.size())
+                        {
+                            value -= classSubtables[classSubtable].GetValue(left, right);
+                        }
+
+                        pairs[pair->first] += value;
+                    }
+                }
+            }
+
+            if (pairs.empty() && classSubtables.empty() && kernTable != 0)
+            {
+                const bool apple = reader.U32(kernTable) == 0x00010000;
+                const unsigned int tableCount = apple ? reader.U32(kernTable + 4) : reader.U16(kernTable + 2);
+                unsigned int subtable = kernTable + (apple ? 8 : 4);
+
+                for (unsigned int t = 0; t < tableCount; ++t)
+                {
+                    unsigned int length, format, coverage, header;
+
+                    if (apple)
+                    {
+                        // length, coverage (flags in the high byte), tuple index
+                        length = reader.U32(subtable);
+                        const unsigned int flags = reader.U16(subtable + 4);
+                        format = flags & 0xFF;
+                        coverage = (flags & 0x8000) ? 0 : Kern_Horizontal;
+                        coverage |= (flags & 0x4000) ? Kern_CrossStream : 0;
+                        header = 8;
+                    }
+                    else
+                    {
+                        // version, length, coverage (format in the high byte)
+                        length = reader.U16(subtable + 2);
+                        const unsigned int flags = reader.U16(subtable + 4);
+                        format = flags >> 8;
+                        coverage = flags & 0xFF;
+                        header = 6;
+                    }
+
+                    if (format == 0 && (coverage & Kern_Horizontal) &&
+                        !(coverage & (Kern_Minimum | Kern_CrossStream)))
+                    {
+                        const unsigned int pairCount = reader.U16(subtable + header);
+
+                        for (unsigned int p = 0; p < pairCount; ++p)
+                        {
+                            const unsigned int record = subtable + header + 8 + 6 * p;
+                            const unsigned int key = (reader.U16(record) << 16) | reader.U16(record + 2);
+                            const int value = reader.S16(record + 4);
+
+                            // subtables add up unless one overrides
+                            if (coverage & Kern_Override)
+                            {
+                                pairs[key] = value;
+                            }
+                            else
+                            {
+                                pairs[key] += value;
+                            }
+                        }
+                    }
+
+                    if (length == 0)
+                    {
+                        break;
+                    }
+
+                    subtable += length;
+                }
+            }
+        }
+        catch (const std::exception &)
+        {
+            // kerning is optional, a broken table, or one too large to
+            // load, only disables it
+            Clear();
+            return;
+        }
+
+        if (!pairs.empty())
+        {
+            SetPairs(std::vector<std::pair<unsigned int, int> >(pairs.begin(), pairs.end()));
+        }
+    }
+} // namespace GDIPPRenderer
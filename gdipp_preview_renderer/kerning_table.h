@@ -0,0 +1,163 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace GDIPPRenderer
+{
+    class KerningTable
+    {
+        /*
+        *   Horizontal pair kerning of one font, built once when the font is
+        *   loaded. Glyph pairs from the GPOS `kern` feature (or the legacy
+        *   `kern` table when there is no GPOS kerning) go to an open
+        *   addressing hash table; class based GPOS subtables stay as
+        *   per-glyph class arrays and a class matrix. Both cost a couple of
+        *   array reads per pair.
+        *
+        *   As in GPOS, the adjustments of all lookups of the feature add up,
+        *   within one lookup the first subtable that applies to a pair wins.
+        */
+
+    public:
+        KerningTable();
+
+        // tables at offset 0 are missing; malformed tables leave the
+        // font without kerning
+        void Build(const std::vector<unsigned char> & fontData,
+                   unsigned int kernTable,
+                   unsigned int gposTable,
+                   int numGlyphs);
+
+        void Clear();
+
+        bool IsEmpty() const
+        {
+            return pairCount == 0 && classSubtables.empty();
+        }
+
+        size_t GetPairCount() const
+        {
+            return pairCount;
+        }
+
+        size_t GetClassSubtableCount() const
+        {
+            return classSubtables.size();
+        }
+
+        // advance adjustment in font units
+        int GetAdjustment(unsigned int left, unsigned int right) const
+        {
+            int adjustment = 0;
+
+            if (pairCount != 0)
+            {
+                const unsigned int key = (left << 16) | right;
+
+                for (unsigned int slot = Hash(key);; slot = (slot + 1) & mask)
+                {
+                    if (slots[slot].key == key)
+                    {
+                        adjustment = slots[slot].value;
+                        break;
+                    }
+
+                    if (slots[slot].key == EmptyKey)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            return adjustment + GetClassAdjustment(left, right);
+        }
+
+    private:
+        static const unsigned int EmptyKey = 0xFFFFFFFF;
+
+        class Slot
+        {
+        public:
+            unsigned int key;
+            int value;
+        };
+
+        class ClassSubtable
+        {
+        public:
+            ClassSubtable()
+                : lookup(0),
+                  class2Count(0)
+            {
+
+            }
+
+            // for a covered left glyph
+            int GetValue(unsigned int left, unsigned int right) const
+            {
+                const int secondClass = right < secondClasses.size() ? secondClasses[right] : 0;
+
+                return values[firstClasses[left] * class2Count + secondClass];
+            }
+
+            // index in the GPOS lookup list
+            unsigned int lookup;
+
+            // class of every glyph, NotCovered for first glyphs the
+            // subtable does not apply to
+            std::vector<unsigned short> firstClasses;
+            std::vector<unsigned short> secondClasses;
+
+            int class2Count;
+
+            // x advance of the first glyph per class pair
+            std::vector<short> values;
+        };
+
+        static const unsigned short NotCovered = 0xFFFF;
+
+        std::vector<Slot> slots;
+        unsigned int mask;
+        unsigned int shift;
+        size_t pairCount;
+
+        std::vector<ClassSubtable> classSubtables;
+
+        unsigned int Hash(unsigned int key) const
+        {
+            return (key * 2654435769U) >> shift;
+        }
+
+        int GetClassAdjustment(unsigned int left, unsigned int right) const;
+
+        // the first class subtable from index first on covering the left
+        // glyph, classSubtables.size() when there is none
+        size_t FindClassSubtable(size_t first, unsigned int left) const;
+
+        void SetPairs(const std::vector<std::pair<unsigned int, int> > & pairs);
+    };
+}
@@ -0,0 +1,481 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "lcd_filter.h"
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+
+namespace GDIPPRenderer
+{
+    typedef GDIPPConfiguration::Values::LCDFilter LCDFilter;
+    typedef GDIPPConfiguration::Values::PixelGeometry PixelGeometry;
+
+    // FreeType FIR weights, each phase (R, G, B subpixel) sums up to 256
+    static const short DefaultWeights[3][5] =
+    {
+        { 0x08, 0x4D, 0x56, 0x4D, 0x08 },
+        { 0x08, 0x4D, 0x56, 0x4D, 0x08 },
+        { 0x08, 0x4D, 0x56, 0x4D, 0x08 }
+    };
+
+    static const short LightWeights[3][5] =
+    {
+        { 0x00, 0x55, 0x56, 0x55, 0x00 },
+        { 0x00, 0x55, 0x56, 0x55, 0x00 },
+        { 0x00, 0x55, 0x56, 0x55, 0x00 }
+    };
+
+    // FreeType legacy intra-pixel filter (9/13 3/13 1/13, 1/6 4/6 1/6),
+    // written as a 5-tap FIR whose weights depend on the subpixel phase
+    static const short LegacyWeights[3][5] =
+    {
+        { 0, 0, 177, 59, 20 },
+        { 0, 43, 170, 43, 0 },
+        { 20, 59, 177, 0, 0 }
+    };
+
+    static const short PassThroughWeights[3][5] =
+    {
+        { 0, 0, 256, 0, 0 },
+        { 0, 0, 256, 0, 0 },
+        { 0, 0, 256, 0, 0 }
+    };
+
+    LCDFilterKernel::LCDFilterKernel(int filter)
+        : filter(filter)
+    {
+        const short (* source)[5] = PassThroughWeights;
+
+        switch (filter)
+        {
+        case LCDFilter::Default:
+            source = DefaultWeights;
+            break;
+
+        case LCDFilter::Light:
+            source = LightWeights;
+            break;
+
+        case LCDFilter::Legacy:
+            source = LegacyWeights;
+            break;
+        }
+
+        for (int phase = 0; phase < 3; ++phase)
+        {
+            for (int tap = 0; tap < 5; ++tap)
+            {
+                weights[phase][tap] = source[phase][tap];
+
+                // lane j of a vector starting at the given phase
+                for (int lane = 0; lane < 16; ++lane)
+                {
+                    lanes[phase][tap][lane] = source[(phase + lane) % 3][tap];
+                }
+            }
+        }
+    }
+
+    inline unsigned char LCDFilterKernel::FilterSample(const unsigned char * source,
+                                                       int count,
+                                                       int index) const
+    {
+        const short * tapWeights = weights[index % 3];
+        int sum = 0;
+
+        for (int tap = 0; tap < 5; ++tap)
+        {
+            int sourceIndex = index + tap - 2;
+
+            if (sourceIndex >= 0 && sourceIndex < count)
+            {
+                sum += tapWeights[tap] * source[sourceIndex];
+            }
+        }
+
+        return static_cast<unsigned char>(sum >> 8);
+    }
+
+    void LCDFilterKernel::Apply(const unsigned char * source,
+                                unsigned char * destination,
+                                int count) const
+    {
+        /*
+        *   The two samples at each end see the zero padding and go through
+        *   the scalar path, everything in between is filtered a whole
+        *   vector at a time. All paths produce identical results.
+        */
+
+        if (filter != LCDFilter::Default &&
+            filter != LCDFilter::Light &&
+            filter != LCDFilter::Legacy)
+        {
+            memmove(destination, source, count);
+            return;
+        }
+
+        int i = 0;
+
+        for (; i < count && i < 2; ++i)
+        {
+            destination[i] = FilterSample(source, count, i);
+        }
+
+#if defined(GDIPP_SIMD_AVX2)
+        for (; i + 32 + 2 <= count; i += 32)
+        {
+            const int phaseLow = i % 3;
+            const int phaseHigh = (phaseLow + 1) % 3;
+
+            __m256i sumLow = _mm256_setzero_si256();
+            __m256i sumHigh = _mm256_setzero_si256();
+
+            for (int tap = 0; tap < 5; ++tap)
+            {
+                const unsigned char * input = source + i + tap - 2;
+
+                __m256i low = _mm256_cvtepu8_epi16(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(input)));
+                __m256i high = _mm256_cvtepu8_epi16(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 16)));
+
+                __m256i weightsLow = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(lanes[phaseLow][tap]));
+                __m256i weightsHigh = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(lanes[phaseHigh][tap]));
+
+                sumLow = _mm256_add_epi16(sumLow, _mm256_mullo_epi16(low, weightsLow));
+                sumHigh = _mm256_add_epi16(sumHigh, _mm256_mullo_epi16(high, weightsHigh));
+            }
+
+            // packus works per 128-bit lane, restore the order afterwards
+            __m256i packed = _mm256_packus_epi16(_mm256_srli_epi16(sumLow, 8),
+                                                 _mm256_srli_epi16(sumHigh, 8));
+            packed = _mm256_permute4x64_epi64(packed, 0xD8);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), packed);
+        }
+#endif
+
+#if defined(GDIPP_SIMD_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; i + 16 + 2 <= count; i += 16)
+        {
+            const int phaseLow = i % 3;
+            const int phaseHigh = (phaseLow + 2) % 3;
+
+            __m128i sumLow = _mm_setzero_si128();
+            __m128i sumHigh = _mm_setzero_si128();
+
+            for (int tap = 0; tap < 5; ++tap)
+            {
+                __m128i input = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(source + i + tap - 2));
+
+                __m128i weightsLow = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(lanes[phaseLow][tap]));
+                __m128i weightsHigh = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(lanes[phaseHigh][tap]));
+
+                // 255 * 256 still fits into an unsigned 16-bit lane
+                sumLow = _mm_add_epi16(sumLow,
+                    _mm_mullo_epi16(_mm_unpacklo_epi8(input, zero), weightsLow));
+                sumHigh = _mm_add_epi16(sumHigh,
+                    _mm_mullo_epi16(_mm_unpackhi_epi8(input, zero), weightsHigh));
+            }
+
+            __m128i packed = _mm_packus_epi16(_mm_srli_epi16(sumLow, 8),
+                                              _mm_srli_epi16(sumHigh, 8));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), packed);
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            destination[i] = FilterSample(source, count, i);
+        }
+    }
+
+    void FilterScanline(const unsigned char * source,
+                        unsigned char * destination,
+                        int count,
+                        int filter)
+    {
+        LCDFilterKernel kernel(filter);
+        kernel.Apply(source, destination, count);
+    }
+
+    class PhaseMasks
+    {
+        /*
+        *   Byte masks selecting the lanes of a 16-byte vector which hold
+        *   subpixel k, for a vector starting at subpixel phase p.
+        */
+
+    public:
+        PhaseMasks()
+        {
+            for (int phase = 0; phase < 3; ++phase)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    for (int lane = 0; lane < 16; ++lane)
+                    {
+                        masks[phase][k][lane] = ((phase + lane) % 3 == k) ? 0xFF : 0x00;
+                    }
+                }
+            }
+        }
+
+        unsigned char masks[3][3][16];
+    };
+
+    // built before main(), the render threads only read it
+    static const PhaseMasks phaseMasks;
+
+    static void ResolveSubpixelRow(const unsigned char * filtered,
+                                   unsigned char * destination,
+                                   int count,
+                                   int pixelGeometry)
+    {
+        if (pixelGeometry != PixelGeometry::BGR)
+        {
+            memcpy(destination, filtered, count);
+            return;
+        }
+
+        // BGR: sample i comes from i + 2, i or i - 2 depending on its phase
+        static const int order[3] = { 2, 1, 0 };
+        int i = 0;
+
+        for (; i < count && i < 2; ++i)
+        {
+            destination[i] = filtered[i - i % 3 + order[i % 3]];
+        }
+
+#if defined(GDIPP_SIMD_SSE2)
+        for (; i + 16 + 2 <= count; i += 16)
+        {
+            const unsigned char (* masks)[16] = phaseMasks.masks[i % 3];
+
+            __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(filtered + i - 2));
+            __m128i middle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(filtered + i));
+            __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(filtered + i + 2));
+
+            __m128i result = _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(right, _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks[0]))),
+                             _mm_and_si128(middle, _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks[1])))),
+                _mm_and_si128(left, _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks[2]))));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), result);
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            destination[i] = filtered[i - i % 3 + order[i % 3]];
+        }
+    }
+
+#if defined(GDIPP_SIMD_SSE2)
+    static inline __m128i AverageThree(__m128i s0, __m128i s1, __m128i s2, __m128i s3, __m128i s4,
+                                       __m128i mask0, __m128i mask1, __m128i mask2)
+    {
+        /*
+        *   16-bit samples s0 - s4 at offsets -2 .. 2. Every lane takes the
+        *   mean of the three samples of its pixel, selected by its phase.
+        */
+
+        const __m128i center = _mm_add_epi16(s1, _mm_add_epi16(s2, s3));
+        const __m128i sum0 = _mm_add_epi16(_mm_sub_epi16(center, s1), s4);
+        const __m128i sum2 = _mm_add_epi16(_mm_sub_epi16(center, s3), s0);
+
+        __m128i sum = _mm_or_si128(_mm_or_si128(_mm_and_si128(sum0, mask0),
+                                                _mm_and_si128(center, mask1)),
+                                   _mm_and_si128(sum2, mask2));
+
+        // x * 21846 >> 16 == x / 3 for every sum of three bytes plus one
+        return _mm_mulhi_epu16(_mm_add_epi16(sum, _mm_set1_epi16(1)), _mm_set1_epi16(21846));
+    }
+#endif
+
+    static void ResolveGrayRow(const unsigned char * source,
+                               unsigned char * destination,
+                               int count,
+                               bool mono)
+    {
+        /*
+        *   Every output pixel gets the mean of its three subpixel samples in
+        *   all of its channels, mono output thresholds the mean at 128.
+        */
+
+        int i = 0;
+
+        for (; i < count && i < 2; ++i)
+        {
+            const unsigned char * pixel = &source[i - i % 3];
+            int value = (pixel[0] + pixel[1] + pixel[2] + 1) / 3;
+
+            if (mono)
+            {
+                value = -(value >> 7) & 0xFF;
+            }
+
+            destination[i] = static_cast<unsigned char>(value);
+        }
+
+#if defined(GDIPP_SIMD_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i minusOne = _mm_set1_epi8(-1);
+        const __m128i signBit = _mm_set1_epi8(static_cast<char>(0x80));
+
+        for (; i + 16 + 2 <= count; i += 16)
+        {
+            const unsigned char (* masks)[16] = phaseMasks.masks[i % 3];
+
+            const __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i - 2));
+            const __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i - 1));
+            const __m128i s2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+            const __m128i s3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 1));
+            const __m128i s4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 2));
+
+            const __m128i m0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks[0]));
+            const __m128i m1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks[1]));
+            const __m128i m2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks[2]));
+
+            __m128i result = _mm_packus_epi16(
+                AverageThree(_mm_unpacklo_epi8(s0, zero), _mm_unpacklo_epi8(s1, zero),
+                             _mm_unpacklo_epi8(s2, zero), _mm_unpacklo_epi8(s3, zero),
+                             _mm_unpacklo_epi8(s4, zero),
+                             _mm_unpacklo_epi8(m0, m0), _mm_unpacklo_epi8(m1, m1),
+                             _mm_unpacklo_epi8(m2, m2)),
+                AverageThree(_mm_unpackhi_epi8(s0, zero), _mm_unpackhi_epi8(s1, zero),
+                             _mm_unpackhi_epi8(s2, zero), _mm_unpackhi_epi8(s3, zero),
+                             _mm_unpackhi_epi8(s4, zero),
+                             _mm_unpackhi_epi8(m0, m0), _mm_unpackhi_epi8(m1, m1),
+                             _mm_unpackhi_epi8(m2, m2)));
+
+            if (mono)
+            {
+                result = _mm_cmpgt_epi8(_mm_xor_si128(result, signBit), minusOne);
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), result);
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            const unsigned char * pixel = &source[i - i % 3];
+            int value = (pixel[0] + pixel[1] + pixel[2] + 1) / 3;
+
+            if (mono)
+            {
+                value = -(value >> 7) & 0xFF;
+            }
+
+            destination[i] = static_cast<unsigned char>(value);
+        }
+    }
+
+    class ResolveTask : public ParallelTask
+    {
+    public:
+        // bands of rows, every band has its own filter scratch line
+        static const int BandHeight = 32;
+
+        ResolveTask(const CoverageBitmap & coverage,
+                    CoverageBitmap & channels,
+                    OutputMode mode,
+                    int filter,
+                    int pixelGeometry)
+            : coverage(coverage),
+              channels(channels),
+              mode(mode),
+              kernel(filter),
+              pixelGeometry(pixelGeometry)
+        {
+
+        }
+
+        virtual void Run(int index, int)
+        {
+            const int count = channels.GetWidth();
+            const int endY = std::min(channels.GetHeight(), (index + 1) * BandHeight);
+
+            std::vector<unsigned char> filtered(mode == Output_Subpixel ? count : 0);
+
+            for (int y = index * BandHeight; y < endY; ++y)
+            {
+                const unsigned char * source = coverage.GetRow(y);
+                unsigned char * destination = channels.GetRow(y);
+
+                switch (mode)
+                {
+                case Output_Subpixel:
+                    kernel.Apply(source, &filtered[0], count);
+                    ResolveSubpixelRow(&filtered[0], destination, count, pixelGeometry);
+                    break;
+
+                case Output_Mono:
+                    ResolveGrayRow(source, destination, count, true);
+                    break;
+
+                default:
+                    ResolveGrayRow(source, destination, count, false);
+                    break;
+                }
+            }
+        }
+
+    private:
+        const CoverageBitmap & coverage;
+        CoverageBitmap & channels;
+        OutputMode mode;
+        LCDFilterKernel kernel;
+        int pixelGeometry;
+    };
+
+    void ResolveChannels(const CoverageBitmap & coverage,
+                         CoverageBitmap & channels,
+                         OutputMode mode,
+                         int filter,
+                         int pixelGeometry,
+                         ThreadPool * pool)
+    {
+        channels.Resize(coverage.GetWidth() / SubpixelOversample * 3, coverage.GetHeight());
+
+        if (channels.IsEmpty())
+        {
+            return;
+        }
+
+        ResolveTask task(coverage, channels, mode, filter, pixelGeometry);
+        RunParallel(pool, task, (channels.GetHeight() + ResolveTask::BandHeight - 1) / ResolveTask::BandHeight);
+    }
+} // namespace GDIPPRenderer
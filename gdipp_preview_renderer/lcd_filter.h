@@ -0,0 +1,76 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "coverage_bitmap.h"
+#include "render_mode.h"
+#include "simd.h"
+#include "thread_pool.h"
+
+namespace GDIPPRenderer
+{
+    class LCDFilterKernel
+    {
+        /*
+        *   5-tap FIR subpixel filter for one GDIPPConfiguration::Values::LCDFilter
+        *   mode, vectorized with SSE2 / AVX2 when available. Source and
+        *   destination scanlines must not overlap.
+        */
+
+    public:
+        LCDFilterKernel(int filter);
+
+        void Apply(const unsigned char * source,
+                   unsigned char * destination,
+                   int count) const;
+
+    private:
+        int filter;
+
+        // weights per subpixel phase and tap
+        short weights[3][5];
+
+        // the same weights spread over vector lanes, per starting phase
+        short lanes[3][5][16];
+
+        unsigned char FilterSample(const unsigned char * source,
+                                   int count,
+                                   int index) const;
+    };
+
+    // filter is a GDIPPConfiguration::Values::LCDFilter mode
+    extern void FilterScanline(const unsigned char * source,
+                               unsigned char * destination,
+                               int count,
+                               int filter);
+
+    // turns the glyph coverage, oversampled SubpixelOversample times
+    // horizontally, into interleaved R, G, B coverage, three bytes for
+    // every output pixel
+    extern void ResolveChannels(const CoverageBitmap & coverage,
+                                CoverageBitmap & channels,
+                                OutputMode mode,
+                                int filter,
+                                int pixelGeometry,
+                                ThreadPool * pool = NULL);
+}
@@ -0,0 +1,115 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+namespace GDIPPRenderer
+{
+#if defined(_WIN32)
+    class Mutex
+    {
+    public:
+        Mutex()
+        {
+            InitializeCriticalSection(&section);
+        }
+
+        ~Mutex()
+        {
+            DeleteCriticalSection(&section);
+        }
+
+        void Lock()
+        {
+            EnterCriticalSection(&section);
+        }
+
+        void Unlock()
+        {
+            LeaveCriticalSection(&section);
+        }
+
+    private:
+        CRITICAL_SECTION section;
+
+        Mutex(const Mutex &);
+        Mutex & operator=(const Mutex &);
+    };
+#else
+    class Mutex
+    {
+    public:
+        Mutex()
+        {
+            pthread_mutex_init(&mutex, NULL);
+        }
+
+        ~Mutex()
+        {
+            pthread_mutex_destroy(&mutex);
+        }
+
+        void Lock()
+        {
+            pthread_mutex_lock(&mutex);
+        }
+
+        void Unlock()
+        {
+            pthread_mutex_unlock(&mutex);
+        }
+
+    private:
+        pthread_mutex_t mutex;
+
+        Mutex(const Mutex &);
+        Mutex & operator=(const Mutex &);
+    };
+#endif
+
+    class ScopedLock
+    {
+    public:
+        explicit ScopedLock(Mutex & mutex)
+            : mutex(mutex)
+        {
+            mutex.Lock();
+        }
+
+        ~ScopedLock()
+        {
+            mutex.Unlock();
+        }
+
+    private:
+        Mutex & mutex;
+
+        ScopedLock(const ScopedLock &);
+        ScopedLock & operator=(const ScopedLock &);
+    };
+}
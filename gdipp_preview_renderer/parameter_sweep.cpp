@@ -0,0 +1,445 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "parameter_sweep.h"
+
+#include <map>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+
+#include "../gdipp-conf-editor/util.h"
+
+#include "render_mode.h"
+#include "software_renderer.h"
+#include "thread_pool.h"
+
+namespace GDIPPRenderer
+{
+    typedef GDIPPConfiguration::Values Values;
+
+    static void ThrowInvalidSetting(const MetaString & field, const MetaString & setting)
+    {
+        throw std::runtime_error("Sweep: `" + Util::MetaStringToAnsi(setting) +
+                                 "` is not a valid value of `" + Util::MetaStringToAnsi(field) + "`.");
+    }
+
+    static int ToInt(const MetaString & field, const MetaString & setting)
+    {
+        int value = Util::TryIntFromStr(setting, INT_MIN);
+
+        if (value == INT_MIN)
+        {
+            ThrowInvalidSetting(field, setting);
+        }
+
+        return value;
+    }
+
+    static int ToInt(const MetaString & field, const MetaString & setting, int min, int max)
+    {
+        int value = ToInt(field, setting);
+
+        if (!Util::ValueInRange(value, min, max))
+        {
+            ThrowInvalidSetting(field, setting);
+        }
+
+        return value;
+    }
+
+    static MetaString ToGamma(const MetaString & field, const MetaString & setting)
+    {
+        if (Values::Gamma(setting, setting, setting).GetRValue() <= 0.0)
+        {
+            ThrowInvalidSetting(field, setting);
+        }
+
+        return setting;
+    }
+
+    static Values::RenderMode WithRenderMode(const Values::RenderMode & renderMode, int component, int mode)
+    {
+        int modes[3] =
+        {
+            static_cast<int>(renderMode.GetMonoMode()),
+            static_cast<int>(renderMode.GetGrayMode()),
+            static_cast<int>(renderMode.GetSubpixelMode())
+        };
+
+        modes[component] = mode;
+
+        return Values::RenderMode(Util::IntToStr(modes[0]),
+                                  Util::IntToStr(modes[1]),
+                                  Util::IntToStr(modes[2]));
+    }
+
+    SweepAxis::SweepAxis(const MetaString & field, const std::vector<MetaString> & settings)
+        : field(field),
+          settings(settings)
+    {
+        if (settings.empty())
+        {
+            throw std::runtime_error("Sweep: no values given for `" + Util::MetaStringToAnsi(field) + "`.");
+        }
+
+        // reject unknown fields and invalid values up front
+        Values values;
+
+        for (size_t i = 0; i < settings.size(); ++i)
+        {
+            Apply(values, i);
+        }
+    }
+
+    void SweepAxis::Apply(Values & values, size_t index) const
+    {
+        const MetaString & setting = settings[index];
+
+        if (field == TEXT("hinting"))
+        {
+            values.hinting = ToInt(field, setting);
+        }
+        else if (field == TEXT("embolden"))
+        {
+            values.embolden = ToInt(field, setting);
+        }
+        else if (field == TEXT("kerning"))
+        {
+            values.kerning = ToInt(field, setting);
+        }
+        else if (field == TEXT("lcd_filter"))
+        {
+            const int filter = ToInt(field, setting);
+
+            if (filter != Values::LCDFilter::None && filter != Values::LCDFilter::Default &&
+                filter != Values::LCDFilter::Light && filter != Values::LCDFilter::Legacy)
+            {
+                ThrowInvalidSetting(field, setting);
+            }
+
+            values.lcdFilter = Values::LCDFilter(setting);
+        }
+        else if (field == TEXT("gamma"))
+        {
+            const MetaString gamma = ToGamma(field, setting);
+            values.gamma = Values::Gamma(gamma, gamma, gamma);
+        }
+        else if (field == TEXT("gamma/red"))
+        {
+            values.gamma = Values::Gamma(ToGamma(field, setting), values.gamma.GetG(), values.gamma.GetB());
+        }
+        else if (field == TEXT("gamma/green"))
+        {
+            values.gamma = Values::Gamma(values.gamma.GetR(), ToGamma(field, setting), values.gamma.GetB());
+        }
+        else if (field == TEXT("gamma/blue"))
+        {
+            values.gamma = Values::Gamma(values.gamma.GetR(), values.gamma.GetG(), ToGamma(field, setting));
+        }
+        else if (field == TEXT("render_mode/mono"))
+        {
+            values.renderMode = WithRenderMode(values.renderMode, 0,
+                                               ToInt(field, setting, Values::RenderMode::Disabled, Values::RenderMode::Forced));
+        }
+        else if (field == TEXT("render_mode/gray"))
+        {
+            values.renderMode = WithRenderMode(values.renderMode, 1,
+                                               ToInt(field, setting, Values::RenderMode::Disabled, Values::RenderMode::Forced));
+        }
+        else if (field == TEXT("render_mode/subpixel"))
+        {
+            values.renderMode = WithRenderMode(values.renderMode, 2,
+                                               ToInt(field, setting, Values::RenderMode::Disabled, Values::RenderMode::Forced));
+        }
+        else if (field == TEXT("render_mode/pixel_geometry"))
+        {
+            ToInt(field, setting, Values::PixelGeometry::RGB, Values::PixelGeometry::BGR);
+            values.pixelGeometry = Values::PixelGeometry(setting);
+        }
+        else if (field == TEXT("render_mode/aliased_text"))
+        {
+            values.aliasedText = ToInt(field, setting);
+        }
+        else if (field == TEXT("shadow/offset_x"))
+        {
+            values.shadow = Values::Shadow(ToInt(field, setting), values.shadow.GetOffsetY(), values.shadow.GetAlpha());
+        }
+        else if (field == TEXT("shadow/offset_y"))
+        {
+            values.shadow = Values::Shadow(values.shadow.GetOffsetX(), ToInt(field, setting), values.shadow.GetAlpha());
+        }
+        else if (field == TEXT("shadow/alpha"))
+        {
+            values.shadow = Values::Shadow(values.shadow.GetOffsetX(), values.shadow.GetOffsetY(), ToInt(field, setting));
+        }
+        else
+        {
+            throw std::runtime_error("Sweep: unknown field `" + Util::MetaStringToAnsi(field) + "`.");
+        }
+    }
+
+    static MetaString Trim(const MetaString & text)
+    {
+        const MetaString whitespace(TEXT(" \t\r\n"));
+        const size_t begin = text.find_first_not_of(whitespace);
+
+        if (begin == MetaString::npos)
+        {
+            return MetaString();
+        }
+
+        return text.substr(begin, text.find_last_not_of(whitespace) - begin + 1);
+    }
+
+    static std::vector<MetaString> Split(const MetaString & text, MetaString::value_type separator)
+    {
+        std::vector<MetaString> parts;
+        size_t begin = 0;
+
+        for (;;)
+        {
+            const size_t end = text.find(separator, begin);
+            const MetaString part = Trim(text.substr(begin, end == MetaString::npos ? MetaString::npos : end - begin));
+
+            if (!part.empty())
+            {
+                parts.push_back(part);
+            }
+
+            if (end == MetaString::npos)
+            {
+                return parts;
+            }
+
+            begin = end + 1;
+        }
+    }
+
+    std::vector<SweepAxis> ParseSweepAxes(const MetaString & text)
+    {
+        std::vector<SweepAxis> axes;
+        const std::vector<MetaString> definitions = Split(text, TEXT(';'));
+
+        for (size_t i = 0; i < definitions.size(); ++i)
+        {
+            const size_t equalSignPos = definitions[i].find(TEXT('='));
+
+            if (equalSignPos == MetaString::npos)
+            {
+                throw std::runtime_error("Sweep: expected `field=value,value` instead of `" +
+                                         Util::MetaStringToAnsi(definitions[i]) + "`.");
+            }
+
+            axes.push_back(SweepAxis(Trim(definitions[i].substr(0, equalSignPos)),
+                                     Split(definitions[i].substr(equalSignPos + 1), TEXT(','))));
+        }
+
+        return axes;
+    }
+
+    ParameterSweep::ParameterSweep(const Values & base, const std::vector<SweepAxis> & axes)
+        : axes(axes),
+          rasterizationCount(0)
+    {
+        size_t count = 1;
+
+        for (size_t i = 0; i < axes.size(); ++i)
+        {
+            count *= axes[i].GetSettings().size();
+        }
+
+        // the last axis changes fastest
+        for (size_t v = 0; v < count; ++v)
+        {
+            SweepVariant variant;
+            variant.values = base;
+
+            size_t remainder = v;
+            std::vector<size_t> settings(axes.size());
+
+            for (size_t a = axes.size(); a-- > 0;)
+            {
+                settings[a] = remainder % axes[a].GetSettings().size();
+                remainder /= axes[a].GetSettings().size();
+            }
+
+            for (size_t a = 0; a < axes.size(); ++a)
+            {
+                axes[a].Apply(variant.values, settings[a]);
+
+                if (!variant.label.empty())
+                {
+                    variant.label += TEXT(" ");
+                }
+
+                variant.label += axes[a].GetField() + TEXT("=") + axes[a].GetSettings()[settings[a]];
+            }
+
+            variants.push_back(variant);
+        }
+    }
+
+    class SweepGroupTask : public ParallelTask
+    {
+    public:
+        SweepGroupTask(const PreviewRequest & request,
+                       const std::vector<SweepVariant> & variants,
+                       const std::vector<std::vector<size_t> > & groups,
+                       int rendererThreads,
+                       GlyphCache & glyphCache,
+                       std::vector<RenderedImage> & images,
+                       std::vector<size_t> & rasterizeCounts)
+            : request(request),
+              variants(variants),
+              groups(groups),
+              rendererThreads(rendererThreads),
+              glyphCache(glyphCache),
+              images(images),
+              rasterizeCounts(rasterizeCounts)
+        {
+
+        }
+
+        virtual void Run(int index, int)
+        {
+            SoftwareRenderer renderer(rendererThreads, &glyphCache);
+            const std::vector<size_t> & group = groups[index];
+
+            for (size_t i = 0; i < group.size(); ++i)
+            {
+                images[group[i]] = renderer.Render(request, variants[group[i]].values);
+            }
+
+            rasterizeCounts[index] = renderer.GetStageRunCount(SoftwareRenderer::Stage_Rasterize);
+        }
+
+    private:
+        const PreviewRequest & request;
+        const std::vector<SweepVariant> & variants;
+        const std::vector<std::vector<size_t> > & groups;
+        int rendererThreads;
+        GlyphCache & glyphCache;
+        std::vector<RenderedImage> & images;
+        std::vector<size_t> & rasterizeCounts;
+    };
+
+    std::vector<RenderedImage> ParameterSweep::RenderVariants(const PreviewRequest & request, int threadCount)
+    {
+        // variants with the same coverage, in sweep order, by
+        // ((hinting, kerning), embolden)
+        typedef std::pair<std::pair<int, bool>, int> GroupKey;
+
+        std::map<GroupKey, size_t> groupIndices;
+        std::vector<std::vector<size_t> > groups;
+
+        for (size_t v = 0; v < variants.size(); ++v)
+        {
+            const GroupKey key(std::make_pair(ResolveHinting(variants[v].values),
+                                              ResolveKerning(variants[v].values)),
+                               ResolveEmbolden(variants[v].values));
+
+            std::map<GroupKey, size_t>::iterator it = groupIndices.find(key);
+
+            if (it == groupIndices.end())
+            {
+                it = groupIndices.insert(std::make_pair(key, groups.size())).first;
+                groups.push_back(std::vector<size_t>());
+            }
+
+            groups[it->second].push_back(v);
+        }
+
+        const int threads = threadCount > 0 ? threadCount : ThreadPool::GetProcessorCount();
+        const int groupThreads = std::max(1, std::min(threads, static_cast<int>(groups.size())));
+        const int rendererThreads = std::max(1, threads / groupThreads);
+
+        std::vector<RenderedImage> images(variants.size());
+        std::vector<size_t> rasterizeCounts(groups.size(), 0);
+
+        ThreadPool pool(groupThreads);
+        SweepGroupTask task(request, variants, groups, rendererThreads, glyphCache, images, rasterizeCounts);
+        pool.Run(task, static_cast<int>(groups.size()));
+
+        // as the group renderers counted them, not one per group assumed
+        rasterizationCount = 0;
+
+        for (size_t g = 0; g < rasterizeCounts.size(); ++g)
+        {
+            rasterizationCount += rasterizeCounts[g];
+        }
+
+        return images;
+    }
+
+    RenderedImage ParameterSweep::RenderContactSheet(const PreviewRequest & request, int threadCount)
+    {
+        const std::vector<RenderedImage> images = RenderVariants(request, threadCount);
+
+        // labels in the same font
+        SoftwareRenderer labelRenderer(1, &glyphCache);
+        std::vector<RenderedImage> labels(variants.size());
+
+        PreviewRequest labelRequest;
+        labelRequest.fontFileName = request.fontFileName;
+        labelRequest.pixelSizes.assign(1, 12);
+        labelRequest.margin = 2;
+        labelRequest.foreground = request.foreground;
+        labelRequest.background = request.background;
+
+        for (size_t v = 0; v < variants.size(); ++v)
+        {
+            labelRequest.lines.assign(1, Util::MetaStringToUnicode(variants[v].label.empty() ? MetaString(TEXT("base")) : variants[v].label));
+            labels[v] = labelRenderer.Render(labelRequest, Values());
+        }
+
+        const int columns = axes.empty() ? 1 : static_cast<int>(axes.back().GetSettings().size());
+        const int rows = (static_cast<int>(variants.size()) + columns - 1) / columns;
+        const int gap = 8;
+
+        int cellWidth = 0, labelHeight = 0, imageHeight = 0;
+
+        for (size_t v = 0; v < variants.size(); ++v)
+        {
+            cellWidth = std::max(cellWidth, std::max(images[v].GetWidth(), labels[v].GetWidth()));
+            labelHeight = std::max(labelHeight, labels[v].GetHeight());
+            imageHeight = std::max(imageHeight, images[v].GetHeight());
+        }
+
+        const int cellHeight = labelHeight + imageHeight;
+
+        RenderedImage sheet(columns * (cellWidth + gap) + gap,
+                            rows * (cellHeight + gap) + gap,
+                            request.background);
+
+        for (size_t v = 0; v < variants.size(); ++v)
+        {
+            const int x = gap + static_cast<int>(v % columns) * (cellWidth + gap);
+            const int y = gap + static_cast<int>(v / columns) * (cellHeight + gap);
+
+            sheet.Draw(labels[v], x, y);
+            sheet.Draw(images[v], x, y + labelHeight);
+        }
+
+        return sheet;
+    }
+} // namespace GDIPPRenderer
@@ -0,0 +1,129 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "../gdipp-conf-editor/local_types.h"
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+
+#include "preview_renderer.h"
+#include "rendered_image.h"
+#include "glyph_cache.h"
+
+namespace GDIPPRenderer
+{
+    class SweepAxis
+    {
+        /*
+        *   One Values field and the settings to try for it. Fields are named
+        *   after their gdipp_setting.xml elements: hinting, embolden, kerning,
+        *   lcd_filter, gamma (all three channels), gamma/red, gamma/green,
+        *   gamma/blue, render_mode/mono, render_mode/gray, render_mode/subpixel,
+        *   render_mode/pixel_geometry, render_mode/aliased_text,
+        *   shadow/offset_x, shadow/offset_y, shadow/alpha.
+        */
+
+    public:
+        SweepAxis(const MetaString & field, const std::vector<MetaString> & settings);
+
+        const MetaString & GetField() const
+        {
+            return field;
+        }
+
+        const std::vector<MetaString> & GetSettings() const
+        {
+            return settings;
+        }
+
+        // sets the field to the given setting
+        void Apply(GDIPPConfiguration::Values & values, size_t setting) const;
+
+    private:
+        MetaString field;
+        std::vector<MetaString> settings;
+    };
+
+    // "hinting=0,1,2,3;lcd_filter=0,1,2,16;gamma=1.0,1.4"
+    extern std::vector<SweepAxis> ParseSweepAxes(const MetaString & text);
+
+    class SweepVariant
+    {
+    public:
+        GDIPPConfiguration::Values values;
+
+        // "hinting=1 lcd_filter=2"
+        MetaString label;
+    };
+
+    class ParameterSweep
+    {
+        /*
+        *   Renders the cartesian product of the axes applied on top of the
+        *   base values and lays the previews out on one contact sheet, one
+        *   column for every setting of the last axis.
+        *
+        *   Variants sharing hinting, kerning and embolden share one
+        *   rasterized coverage: every such group is rendered by its own
+        *   renderer, which only re-runs the later stages from one variant
+        *   to the next.
+        *   Groups run in parallel, each renderer also parallelizes its own
+        *   stages when there are fewer groups than threads. All renderers
+        *   share one glyph cache, rendering the sweep again rasterizes
+        *   nothing.
+        */
+
+    public:
+        ParameterSweep(const GDIPPConfiguration::Values & base, const std::vector<SweepAxis> & axes);
+
+        const std::vector<SweepVariant> & GetVariants() const
+        {
+            return variants;
+        }
+
+        // previews in the order of GetVariants()
+        std::vector<RenderedImage> RenderVariants(const PreviewRequest & request, int threadCount = 0);
+
+        RenderedImage RenderContactSheet(const PreviewRequest & request, int threadCount = 0);
+
+        // times the rasterize stage ran in the last RenderVariants, summed
+        // over the renderers; one per coverage group when the stages after
+        // it are reused
+        size_t GetRasterizationCount() const
+        {
+            return rasterizationCount;
+        }
+
+        GlyphCache & GetGlyphCache()
+        {
+            return glyphCache;
+        }
+
+    private:
+        GlyphCache glyphCache;
+        std::vector<SweepAxis> axes;
+        std::vector<SweepVariant> variants;
+        size_t rasterizationCount;
+    };
+}
@@ -0,0 +1,308 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "perceptual_metrics.h"
+
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+#include "simd.h"
+
+namespace GDIPPRenderer
+{
+    PerceptualMetrics::PerceptualMetrics()
+        : stemContrast(0.0),
+          fringeEnergy(0.0),
+          inkPixels(0)
+    {
+        std::fill(coverageHistogram, coverageHistogram + HistogramBins, 0);
+    }
+
+    // Rec. 601 weights summing to 256
+    static int GetLuma(int blue, int green, int red)
+    {
+        return (blue * 29 + green * 150 + red * 77) >> 8;
+    }
+
+    static int GetColorLuma(unsigned int color)
+    {
+        return GetLuma(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF);
+    }
+
+#if defined(GDIPP_SIMD_SSE2)
+    static int CountBits(unsigned int value)
+    {
+        value = value - ((value >> 1) & 0x55555555);
+        value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+
+        return static_cast<int>((((value + (value >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+    }
+#endif
+
+    static void ComputeInk(const unsigned char * row,
+                           int count,
+                           int backgroundLuma,
+                           unsigned int scale,
+                           unsigned char * ink)
+    {
+        /*
+        *   ink = |luma - background luma| * 255 / luma range, as
+        *   ((distance << 7) * scale) >> 16 with scale = 255 * 512 / range
+        */
+
+        int x = 0;
+
+#if defined(GDIPP_SIMD_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weights = _mm_setr_epi16(29, 150, 77, 0, 29, 150, 77, 0);
+        const __m128i background = _mm_set1_epi16(static_cast<short>(backgroundLuma));
+        const __m128i factor = _mm_set1_epi16(static_cast<short>(scale));
+        const __m128i maximum = _mm_set1_epi16(255);
+
+        for (; x + 8 <= count; x += 8)
+        {
+            __m128i luma[2];
+
+            for (int half = 0; half < 2; ++half)
+            {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (x + half * 4) * 4));
+
+                // B * 29 + G * 150 and R * 77 of every pixel
+                const __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights);
+                const __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+
+                const __m128i blueGreen = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(2, 0, 2, 0)));
+                const __m128i red = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(3, 1, 3, 1)));
+
+                luma[half] = _mm_srli_epi32(_mm_add_epi32(blueGreen, red), 8);
+            }
+
+            const __m128i luma16 = _mm_packs_epi32(luma[0], luma[1]);
+            const __m128i distance = _mm_or_si128(_mm_subs_epu16(luma16, background), _mm_subs_epu16(background, luma16));
+            const __m128i level = _mm_min_epi16(_mm_mulhi_epu16(_mm_slli_epi16(distance, 7), factor), maximum);
+
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(ink + x), _mm_packus_epi16(level, zero));
+        }
+#endif
+
+        for (; x < count; ++x)
+        {
+            const unsigned char * pixel = &row[x * 4];
+            const unsigned int distance = static_cast<unsigned int>(std::abs(GetLuma(pixel[0], pixel[1], pixel[2]) - backgroundLuma));
+
+            ink[x] = static_cast<unsigned char>(std::min(((distance << 7) * scale) >> 16, 255u));
+        }
+    }
+
+    static void SumStemPeaks(const unsigned char * ink,
+                             int count,
+                             unsigned long long & sum,
+                             unsigned long long & peaks)
+    {
+        /*
+        *   Pixels with ink at least as high as both horizontal neighbors,
+        *   outside of the row counts as no ink.
+        */
+
+        int x = 0;
+
+#if defined(GDIPP_SIMD_SSE2)
+        if (count > 0)
+        {
+            // the first pixel has no left neighbor
+            const int right = count > 1 ? ink[1] : 0;
+
+            if (ink[0] != 0 && ink[0] >= right)
+            {
+                sum += ink[0];
+                ++peaks;
+            }
+
+            x = 1;
+        }
+
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; x + 17 <= count; x += 16)
+        {
+            const __m128i center = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ink + x));
+            const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ink + x - 1));
+            const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ink + x + 1));
+
+            __m128i peak = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(center, left), center),
+                                         _mm_cmpeq_epi8(_mm_max_epu8(center, right), center));
+            peak = _mm_andnot_si128(_mm_cmpeq_epi8(center, zero), peak);
+
+            const __m128i sums = _mm_sad_epu8(_mm_and_si128(center, peak), zero);
+
+            sum += static_cast<unsigned int>(_mm_cvtsi128_si32(sums)) +
+                   static_cast<unsigned int>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+            peaks += CountBits(static_cast<unsigned int>(_mm_movemask_epi8(peak)));
+        }
+#endif
+
+        for (; x < count; ++x)
+        {
+            const int left = x > 0 ? ink[x - 1] : 0;
+            const int right = x + 1 < count ? ink[x + 1] : 0;
+
+            if (ink[x] != 0 && ink[x] >= left && ink[x] >= right)
+            {
+                sum += ink[x];
+                ++peaks;
+            }
+        }
+    }
+
+    static unsigned long long SumFringeEnergy(const unsigned char * row, int count)
+    {
+        unsigned long long total = 0;
+        int x = 0;
+
+#if defined(GDIPP_SIMD_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i channelMask = _mm_set1_epi32(0x0000FFFF);
+
+        while (x + 4 <= count)
+        {
+            // flushed often enough that the 32-bit lanes never overflow
+            const int end = std::min(count, x + 1024 * 4) & ~3;
+            __m128i squares = zero;
+
+            for (; x < end; x += 4)
+            {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+                const __m128i next = _mm_srli_epi32(pixels, 8);
+
+                // |B - G| and |G - R| in the low two bytes of every pixel
+                const __m128i delta = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(pixels, next), _mm_subs_epu8(next, pixels)), channelMask);
+
+                const __m128i low = _mm_unpacklo_epi8(delta, zero);
+                const __m128i high = _mm_unpackhi_epi8(delta, zero);
+                squares = _mm_add_epi32(squares, _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high)));
+            }
+
+            unsigned int lanes[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), squares);
+
+            total += static_cast<unsigned long long>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+        }
+#endif
+
+        for (; x < count; ++x)
+        {
+            const int blueGreen = row[x * 4 + 0] - row[x * 4 + 1];
+            const int greenRed = row[x * 4 + 1] - row[x * 4 + 2];
+
+            total += static_cast<unsigned long long>(blueGreen * blueGreen + greenRed * greenRed);
+        }
+
+        return total;
+    }
+
+    PerceptualMetrics MeasureImage(const RenderedImage & image,
+                                   unsigned int foreground,
+                                   unsigned int background)
+    {
+        PerceptualMetrics metrics;
+
+        const int backgroundLuma = GetColorLuma(background);
+        const int range = std::abs(GetColorLuma(foreground) - backgroundLuma);
+        const unsigned int scale = range > 0 ? std::min(255u * 512 / range, 65535u) : 0;
+
+        std::vector<unsigned char> ink(static_cast<size_t>(std::max(image.GetWidth(), 1)));
+
+        unsigned long long peakSum = 0;
+        unsigned long long peaks = 0;
+        unsigned long long fringe = 0;
+
+        for (int y = 0; y < image.GetHeight(); ++y)
+        {
+            const unsigned char * row = image.GetRow(y);
+
+            ComputeInk(row, image.GetWidth(), backgroundLuma, scale, &ink[0]);
+            SumStemPeaks(&ink[0], image.GetWidth(), peakSum, peaks);
+            fringe += SumFringeEnergy(row, image.GetWidth());
+
+            for (int x = 0; x < image.GetWidth(); ++x)
+            {
+                if (ink[x] != 0)
+                {
+                    ++metrics.coverageHistogram[ink[x] >> 4];
+                    ++metrics.inkPixels;
+                }
+            }
+        }
+
+        if (peaks > 0)
+        {
+            metrics.stemContrast = static_cast<double>(peakSum) / (peaks * 255.0);
+        }
+
+        if (metrics.inkPixels > 0)
+        {
+            metrics.fringeEnergy = static_cast<double>(fringe) / (metrics.inkPixels * 2.0 * 255.0 * 255.0);
+        }
+
+        return metrics;
+    }
+
+    void WriteMetricsCsvHeader(std::ostream & stream)
+    {
+        stream << "label,stem_contrast,fringe_energy,ink_pixels";
+
+        for (int bin = 0; bin < PerceptualMetrics::HistogramBins; ++bin)
+        {
+            stream << ",coverage_" << bin;
+        }
+
+        stream << "\n";
+    }
+
+    void WriteMetricsCsvRow(std::ostream & stream,
+                            const std::string & label,
+                            const PerceptualMetrics & metrics)
+    {
+        // quoted, doubled quotes inside
+        std::string quoted = "\"";
+
+        for (size_t i = 0; i < label.length(); ++i)
+        {
+            quoted += label[i] == '"' ? "\"\"" : std::string(1, label[i]);
+        }
+
+        quoted += "\"";
+
+        stream << quoted << "," << metrics.stemContrast << "," << metrics.fringeEnergy << "," << metrics.inkPixels;
+
+        for (int bin = 0; bin < PerceptualMetrics::HistogramBins; ++bin)
+        {
+            const double share = metrics.inkPixels > 0 ?
+                static_cast<double>(metrics.coverageHistogram[bin]) / metrics.inkPixels : 0.0;
+
+            stream << "," << share;
+        }
+
+        stream << "\n";
+    }
+} // namespace GDIPPRenderer
@@ -0,0 +1,71 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+#include "rendered_image.h"
+
+namespace GDIPPRenderer
+{
+    class PerceptualMetrics
+    {
+        /*
+        *   What a rendered sample looks like, for ranking the variants of a
+        *   parameter sweep. Ink is the luma distance from the background
+        *   relative to the foreground, 0 - 255.
+        */
+
+    public:
+        static const int HistogramBins = 16;
+
+        PerceptualMetrics();
+
+        // mean ink of the horizontal ink peaks (stem cores), 0 - 1; 1 when
+        // every stem reaches the full foreground
+        double stemContrast;
+
+        // mean (B - G)^2 + (G - R)^2 of the inked pixels over its maximum,
+        // 0 - 1; 0 for mono and gray output
+        double fringeEnergy;
+
+        size_t inkPixels;
+
+        // inked pixels by ink level, 16 levels per bin
+        size_t coverageHistogram[HistogramBins];
+    };
+
+    // colors are 0x00RRGGBB, the ones the image was rendered with
+    extern PerceptualMetrics MeasureImage(const RenderedImage & image,
+                                          unsigned int foreground,
+                                          unsigned int background);
+
+    // label,stem_contrast,fringe_energy,ink_pixels,coverage_0 ... coverage_15;
+    // the histogram as shares of the inked pixels
+    extern void WriteMetricsCsvHeader(std::ostream & stream);
+    extern void WriteMetricsCsvRow(std::ostream & stream,
+                                   const std::string & label,
+                                   const PerceptualMetrics & metrics);
+}
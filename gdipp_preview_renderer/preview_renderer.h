@@ -0,0 +1,76 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../gdipp-conf-editor/local_types.h"
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+
+#include "rendered_image.h"
+
+namespace GDIPPRenderer
+{
+    class PreviewRequest
+    {
+    public:
+        PreviewRequest();
+
+        // TrueType font used to render the preview
+        MetaString fontFileName;
+
+        // every line is rendered once for every pixel size, 1 to 512
+        std::vector<std::wstring> lines;
+        std::vector<int> pixelSizes;
+
+        int margin;
+
+        // render the sheet in mono, gray and subpixel mode, stacked top to
+        // bottom, instead of only the mode selected by the values
+        bool allOutputModes;
+
+        // 0x00RRGGBB
+        unsigned int foreground;
+        unsigned int background;
+    };
+
+    class PreviewRenderer
+    {
+        /*
+        *   Produces a preview of text rendered with the given gdipp
+        *   configuration values.
+        */
+
+    public:
+        virtual ~PreviewRenderer()
+        {
+
+        }
+
+        // the image is owned by the renderer and stays valid until the next
+        // Render call; a preview that did not change costs no copy
+        virtual const RenderedImage & Render(const PreviewRequest & request,
+                                             const GDIPPConfiguration::Values & values) = 0;
+    };
+} // namespace GDIPPRenderer
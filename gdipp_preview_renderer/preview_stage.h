@@ -0,0 +1,100 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace GDIPPRenderer
+{
+    template <typename Key, typename Output>
+    class PreviewStage
+    {
+        /*
+        *   One node of the preview pipeline: the output of its last run and
+        *   the key it was computed for. The key holds the Values fields the
+        *   stage reads and the generations of the stages it reads from, so a
+        *   stage re-runs only when one of those changes.
+        */
+
+    public:
+        PreviewStage()
+            : valid(false), generation(0), runCount(0)
+        {
+
+        }
+
+        bool IsCurrent(const Key & key) const
+        {
+            return valid && this->key == key;
+        }
+
+        // the output to recompute, invalid until Commit() is called
+        Output & Begin()
+        {
+            valid = false;
+            return output;
+        }
+
+        void Commit(const Key & key)
+        {
+            this->key = key;
+            valid = true;
+
+            ++generation;
+            ++runCount;
+        }
+
+        void Invalidate()
+        {
+            valid = false;
+        }
+
+        const Key & GetKey() const
+        {
+            return key;
+        }
+
+        const Output & GetOutput() const
+        {
+            return output;
+        }
+
+        // changes every time the output does
+        unsigned int GetGeneration() const
+        {
+            return generation;
+        }
+
+        size_t GetRunCount() const
+        {
+            return runCount;
+        }
+
+    private:
+        Key key;
+        Output output;
+        bool valid;
+        unsigned int generation;
+        size_t runCount;
+    };
+}
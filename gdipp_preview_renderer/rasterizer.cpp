@@ -0,0 +1,391 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "rasterizer.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace GDIPPRenderer
+{
+    Rasterizer::Rasterizer()
+        : width(0),
+          height(0),
+          rowStride(0),
+          startX(0), startY(0),
+          lastX(0), lastY(0)
+    {
+
+    }
+
+    void Rasterizer::Reset(int width, int height)
+    {
+        // two spare cells per row, a segment touching the right edge
+        // deposits its remainder one cell past the last column
+        this->width = width;
+        this->height = height;
+        this->rowStride = width + 2;
+
+        accumulation.assign(static_cast<size_t>(rowStride) * height, 0.0f);
+
+        startX = startY = lastX = lastY = 0;
+    }
+
+    void Rasterizer::MoveTo(float x, float y)
+    {
+        startX = lastX = x;
+        startY = lastY = y;
+    }
+
+    void Rasterizer::LineTo(float x, float y)
+    {
+        DrawLine(lastX, lastY, x, y);
+
+        lastX = x;
+        lastY = y;
+    }
+
+    void Rasterizer::QuadTo(float controlX, float controlY, float x, float y)
+    {
+        // flatten with the number of segments derived from the curve deviation
+        float devX = lastX - 2 * controlX + x;
+        float devY = lastY - 2 * controlY + y;
+        float devSquared = devX * devX + devY * devY;
+
+        if (devSquared < 0.333f)
+        {
+            LineTo(x, y);
+            return;
+        }
+
+        const float tolerance = 3.0f;
+        int segments = 1 + static_cast<int>(std::floor(std::sqrt(std::sqrt(tolerance * devSquared))));
+
+        float x0 = lastX;
+        float y0 = lastY;
+
+        for (int i = 1; i < segments; ++i)
+        {
+            float t = static_cast<float>(i) / segments;
+            float mt = 1.0f - t;
+
+            LineTo(mt * mt * x0 + 2 * mt * t * controlX + t * t * x,
+                   mt * mt * y0 + 2 * mt * t * controlY + t * t * y);
+        }
+
+        LineTo(x, y);
+    }
+
+    void Rasterizer::ClosePath()
+    {
+        if (lastX != startX || lastY != startY)
+        {
+            LineTo(startX, startY);
+        }
+    }
+
+    void Rasterizer::DrawLine(float x0, float y0, float x1, float y1)
+    {
+        if (std::fabs(y0 - y1) <= 1e-6f)
+        {
+            // horizontal segments do not contribute
+            return;
+        }
+
+        float direction = 1.0f;
+
+        if (y0 > y1)
+        {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+            direction = -1.0f;
+        }
+
+        // keep all the writes inside of the buffer
+        const float maxX = static_cast<float>(width);
+
+        x0 = std::min(std::max(x0, 0.0f), maxX);
+        x1 = std::min(std::max(x1, 0.0f), maxX);
+
+        const float dxdy = (x1 - x0) / (y1 - y0);
+        float x = x0;
+
+        if (y0 < 0)
+        {
+            x -= y0 * dxdy;
+        }
+
+        int rowBegin = std::max(0, static_cast<int>(std::floor(y0)));
+        int rowEnd = std::min(height, static_cast<int>(std::ceil(y1)));
+
+        for (int y = rowBegin; y < rowEnd; ++y)
+        {
+            float * row = &accumulation[static_cast<size_t>(y) * rowStride];
+
+            float dy = std::min(static_cast<float>(y + 1), y1) - std::max(static_cast<float>(y), y0);
+            float xNext = x + dxdy * dy;
+            float d = dy * direction;
+
+            float left = std::min(x, xNext);
+            float right = std::max(x, xNext);
+
+            float leftFloor = std::floor(left);
+            int leftIndex = static_cast<int>(leftFloor);
+            float rightCeil = std::ceil(right);
+            int rightIndex = static_cast<int>(rightCeil);
+
+            if (rightIndex <= leftIndex + 1)
+            {
+                // segment stays within one pixel column
+                float xMiddle = 0.5f * (x + xNext) - leftFloor;
+
+                row[leftIndex] += d - d * xMiddle;
+                row[leftIndex + 1] += d * xMiddle;
+            }
+            else
+            {
+                float s = 1.0f / (right - left);
+                float leftFraction = left - leftFloor;
+                float a0 = 0.5f * s * (1.0f - leftFraction) * (1.0f - leftFraction);
+                float rightFraction = right - rightCeil + 1.0f;
+                float am = 0.5f * s * rightFraction * rightFraction;
+
+                row[leftIndex] += d * a0;
+
+                if (rightIndex == leftIndex + 2)
+                {
+                    row[leftIndex + 1] += d * (1.0f - a0 - am);
+                }
+                else
+                {
+                    float a1 = s * (1.5f - leftFraction);
+                    row[leftIndex + 1] += d * (a1 - a0);
+
+                    for (int xi = leftIndex + 2; xi < rightIndex - 1; ++xi)
+                    {
+                        row[xi] += d * s;
+                    }
+
+                    float a2 = a1 + (rightIndex - leftIndex - 3) * s;
+                    row[rightIndex - 1] += d * (1.0f - a2 - am);
+                }
+
+                row[rightIndex] += d * am;
+            }
+
+            x = xNext;
+        }
+    }
+
+    void Rasterizer::Resolve(CoverageBitmap & target) const
+    {
+        target.Resize(width, height);
+
+        for (int y = 0; y < height; ++y)
+        {
+            const float * source = &accumulation[static_cast<size_t>(y) * rowStride];
+            unsigned char * destination = target.GetRow(y);
+            float sum = 0;
+
+            for (int x = 0; x < width; ++x)
+            {
+                sum += source[x];
+
+                float coverage = std::min(std::fabs(sum), 1.0f);
+                destination[x] = static_cast<unsigned char>(coverage * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    GlyphRasterizer::GlyphRasterizer()
+    {
+
+    }
+
+    GlyphBitmap GlyphRasterizer::Rasterize(const GlyphOutline & outline,
+                                           float scale,
+                                           int oversample,
+                                           int hinting)
+    {
+        /*
+        *   Hinting instructions are not executed, hinting levels are
+        *   approximated by grid fitting of on-curve points:
+        *   2 - snap vertical positions to whole pixels (crisp horizontals),
+        *   3 - additionally snap horizontal positions to whole pixels.
+        */
+
+        GlyphBitmap glyph;
+
+        if (outline.points.empty())
+        {
+            return glyph;
+        }
+
+        const float scaleX = scale * oversample;
+        const float scaleY = scale;
+
+        std::vector<GlyphOutline::Point> points(outline.points);
+
+        float minX = 0, maxX = 0, minY = 0, maxY = 0;
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            GlyphOutline::Point & point = points[i];
+
+            // font units -> pixels, y axis pointing down
+            point.x = point.x * scaleX;
+            point.y = -point.y * scaleY;
+
+            if (point.onCurve && hinting >= 2)
+            {
+                point.y = std::floor(point.y + 0.5f);
+            }
+
+            if (point.onCurve && hinting >= 3)
+            {
+                point.x = std::floor(point.x / oversample + 0.5f) * oversample;
+            }
+
+            if (i == 0)
+            {
+                minX = maxX = point.x;
+                minY = maxY = point.y;
+            }
+            else
+            {
+                minX = std::min(minX, point.x);
+                maxX = std::max(maxX, point.x);
+                minY = std::min(minY, point.y);
+                maxY = std::max(maxY, point.y);
+            }
+        }
+
+        // one pixel of padding around the outline
+        glyph.left = static_cast<int>(std::floor(minX)) - 1;
+        glyph.top = static_cast<int>(std::floor(minY)) - 1;
+
+        int width = static_cast<int>(std::ceil(maxX)) + 1 - glyph.left;
+        int height = static_cast<int>(std::ceil(maxY)) + 1 - glyph.top;
+
+        rasterizer.Reset(width, height);
+
+        const float offsetX = static_cast<float>(-glyph.left);
+        const float offsetY = static_cast<float>(-glyph.top);
+
+        int contourStart = 0;
+
+        for (size_t c = 0; c < outline.contourEnds.size(); ++c)
+        {
+            int contourEnd = outline.contourEnds[c];
+            int count = contourEnd - contourStart + 1;
+
+            if (count < 2)
+            {
+                contourStart = contourEnd + 1;
+                continue;
+            }
+
+            const GlyphOutline::Point & first = points[contourStart];
+            const GlyphOutline::Point & last = points[contourEnd];
+
+            float beginX, beginY;
+            int index, remaining;
+
+            if (first.onCurve)
+            {
+                beginX = first.x;
+                beginY = first.y;
+                index = contourStart + 1;
+                remaining = count - 1;
+            }
+            else if (last.onCurve)
+            {
+                beginX = last.x;
+                beginY = last.y;
+                index = contourStart;
+                remaining = count - 1;
+            }
+            else
+            {
+                beginX = 0.5f * (first.x + last.x);
+                beginY = 0.5f * (first.y + last.y);
+                index = contourStart;
+                remaining = count;
+            }
+
+            rasterizer.MoveTo(beginX + offsetX, beginY + offsetY);
+
+            bool pendingControl = false;
+            float controlX = 0, controlY = 0;
+
+            for (; remaining > 0; --remaining, ++index)
+            {
+                const GlyphOutline::Point & point = points[index];
+
+                if (point.onCurve)
+                {
+                    if (pendingControl)
+                    {
+                        rasterizer.QuadTo(controlX + offsetX, controlY + offsetY,
+                                          point.x + offsetX, point.y + offsetY);
+                    }
+                    else
+                    {
+                        rasterizer.LineTo(point.x + offsetX, point.y + offsetY);
+                    }
+
+                    pendingControl = false;
+                }
+                else
+                {
+                    if (pendingControl)
+                    {
+                        // implied on-curve point between two control points
+                        float middleX = 0.5f * (controlX + point.x);
+                        float middleY = 0.5f * (controlY + point.y);
+
+                        rasterizer.QuadTo(controlX + offsetX, controlY + offsetY,
+                                          middleX + offsetX, middleY + offsetY);
+                    }
+
+                    controlX = point.x;
+                    controlY = point.y;
+                    pendingControl = true;
+                }
+            }
+
+            if (pendingControl)
+            {
+                rasterizer.QuadTo(controlX + offsetX, controlY + offsetY,
+                                  beginX + offsetX, beginY + offsetY);
+            }
+
+            rasterizer.ClosePath();
+
+            contourStart = contourEnd + 1;
+        }
+
+        rasterizer.Resolve(glyph.coverage);
+
+        return glyph;
+    }
+} // namespace GDIPPRenderer
@@ -0,0 +1,93 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "coverage_bitmap.h"
+#include "truetype_font.h"
+
+namespace GDIPPRenderer
+{
+    class Rasterizer
+    {
+        /*
+        *   Scanline rasterizer based on signed area accumulation. Every line
+        *   segment deposits its exact area contribution into a float buffer,
+        *   a running sum along each row turns it into coverage.
+        */
+
+    public:
+        Rasterizer();
+
+        void Reset(int width, int height);
+
+        void MoveTo(float x, float y);
+        void LineTo(float x, float y);
+        void QuadTo(float controlX, float controlY, float x, float y);
+        void ClosePath();
+
+        void Resolve(CoverageBitmap & target) const;
+
+    private:
+        int width;
+        int height;
+        int rowStride;
+        std::vector<float> accumulation;
+        float startX, startY;
+        float lastX, lastY;
+
+        void DrawLine(float x0, float y0, float x1, float y1);
+    };
+
+    class GlyphBitmap
+    {
+    public:
+        GlyphBitmap()
+            : left(0), top(0)
+        {
+
+        }
+
+        CoverageBitmap coverage;
+
+        // position of the bitmap relative to the pen position on the baseline,
+        // horizontally in oversampled pixels
+        int left;
+        int top;
+    };
+
+    class GlyphRasterizer
+    {
+    public:
+        GlyphRasterizer();
+
+        GlyphBitmap Rasterize(const GlyphOutline & outline,
+                              float scale,
+                              int oversample,
+                              int hinting);
+
+    private:
+        Rasterizer rasterizer;
+    };
+} // namespace GDIPPRenderer
@@ -0,0 +1,108 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "render_mode.h"
+
+#include "../gdipp-conf-editor/util.h"
+
+namespace GDIPPRenderer
+{
+    OutputMode ResolveOutputMode(const GDIPPConfiguration::Values & values)
+    {
+        /*
+        *   Forced modes win, mono first as gdipp does. Otherwise pick the
+        *   richest mode allowed to be chosen automatically, aliased text
+        *   requests prefer mono when it is allowed.
+        */
+
+        typedef GDIPPConfiguration::Values::RenderMode RenderMode;
+
+        const RenderMode & renderMode = values.renderMode;
+
+        if (renderMode.GetMonoMode() == RenderMode::Forced)
+        {
+            return Output_Mono;
+        }
+
+        if (renderMode.GetGrayMode() == RenderMode::Forced)
+        {
+            return Output_Gray;
+        }
+
+        if (renderMode.GetSubpixelMode() == RenderMode::Forced)
+        {
+            return Output_Subpixel;
+        }
+
+        if (values.aliasedText == 1 && renderMode.GetMonoMode() == RenderMode::Auto)
+        {
+            return Output_Mono;
+        }
+
+        if (renderMode.GetSubpixelMode() == RenderMode::Auto)
+        {
+            return Output_Subpixel;
+        }
+
+        if (renderMode.GetGrayMode() == RenderMode::Auto)
+        {
+            return Output_Gray;
+        }
+
+        if (renderMode.GetMonoMode() == RenderMode::Auto)
+        {
+            return Output_Mono;
+        }
+
+        return Output_Gray;
+    }
+
+    const char * GetOutputModeName(OutputMode mode)
+    {
+        switch (mode)
+        {
+        case Output_Mono:
+            return "mono";
+
+        case Output_Subpixel:
+            return "subpixel";
+
+        default:
+            return "gray";
+        }
+    }
+
+    int ResolveHinting(const GDIPPConfiguration::Values & values)
+    {
+        return Util::ValueInRange(values.hinting, 0, 3) ? values.hinting : 0;
+    }
+
+    int ResolveEmbolden(const GDIPPConfiguration::Values & values)
+    {
+        return Util::ValueInRange(values.embolden, -1000, 1000) ? values.embolden : 0;
+    }
+
+    bool ResolveKerning(const GDIPPConfiguration::Values & values)
+    {
+        return values.kerning == 1;
+    }
+} // namespace GDIPPRenderer
@@ -0,0 +1,51 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+
+namespace GDIPPRenderer
+{
+    enum OutputMode
+    {
+        Output_Mono = 0,
+        Output_Gray = 1,
+        Output_Subpixel = 2
+    };
+
+    // glyphs are always rasterized with three horizontal samples per pixel,
+    // every output mode is resolved from the same coverage
+    const int SubpixelOversample = 3;
+
+    extern OutputMode ResolveOutputMode(const GDIPPConfiguration::Values & values);
+
+    extern const char * GetOutputModeName(OutputMode mode);
+
+    // hinting (0 - 3) and embolden strength the renderer uses,
+    // values which are not set are neutral
+    extern int ResolveHinting(const GDIPPConfiguration::Values & values);
+    extern int ResolveEmbolden(const GDIPPConfiguration::Values & values);
+
+    // kerning is applied only when the flag is 1
+    extern bool ResolveKerning(const GDIPPConfiguration::Values & values);
+}
@@ -0,0 +1,124 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+namespace GDIPPRenderer
+{
+    class RenderedImage
+    {
+        /*
+        *   32-bit top-down BGRA image, the same memory layout as a Windows
+        *   DIB section, so it can be blitted or encoded without conversion.
+        */
+
+    public:
+        RenderedImage()
+            : width(0), height(0)
+        {
+
+        }
+
+        RenderedImage(int width, int height, unsigned int color)
+        {
+            Resize(width, height, color);
+        }
+
+        void Resize(int width, int height, unsigned int color)
+        {
+            // color is 0x00RRGGBB
+            this->width = width;
+            this->height = height;
+
+            pixels.resize(static_cast<size_t>(width) * height * 4);
+
+            for (size_t i = 0; i < pixels.size(); i += 4)
+            {
+                pixels[i + 0] = static_cast<unsigned char>(color & 0xFF);
+                pixels[i + 1] = static_cast<unsigned char>((color >> 8) & 0xFF);
+                pixels[i + 2] = static_cast<unsigned char>((color >> 16) & 0xFF);
+                pixels[i + 3] = 0xFF;
+            }
+        }
+
+        int GetWidth() const
+        {
+            return width;
+        }
+
+        int GetHeight() const
+        {
+            return height;
+        }
+
+        int GetStride() const
+        {
+            return width * 4;
+        }
+
+        bool IsEmpty() const
+        {
+            return width == 0 || height == 0;
+        }
+
+        // copies the whole source image to (x, y), clipped to this image
+        void Draw(const RenderedImage & source, int x, int y)
+        {
+            const int beginX = std::max(0, -x);
+            const int endX = std::min(source.width, width - x);
+            const int beginY = std::max(0, -y);
+            const int endY = std::min(source.height, height - y);
+
+            if (beginX >= endX)
+            {
+                return;
+            }
+
+            for (int row = beginY; row < endY; ++row)
+            {
+                memcpy(GetRow(y + row) + (x + beginX) * 4,
+                       source.GetRow(row) + beginX * 4,
+                       static_cast<size_t>(endX - beginX) * 4);
+            }
+        }
+
+        unsigned char * GetRow(int y)
+        {
+            return &pixels[static_cast<size_t>(y) * width * 4];
+        }
+
+        const unsigned char * GetRow(int y) const
+        {
+            return &pixels[static_cast<size_t>(y) * width * 4];
+        }
+
+    private:
+        int width;
+        int height;
+        std::vector<unsigned char> pixels;
+    };
+} // namespace GDIPPRenderer
@@ -0,0 +1,100 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "shadow.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "../gdipp-conf-editor/util.h"
+
+namespace GDIPPRenderer
+{
+    static int ClampOffset(int offset)
+    {
+        if (offset > ShadowParameters::MaxOffset)
+        {
+            return ShadowParameters::MaxOffset;
+        }
+
+        if (offset < -ShadowParameters::MaxOffset)
+        {
+            return -ShadowParameters::MaxOffset;
+        }
+
+        return offset;
+    }
+
+    ShadowParameters::ShadowParameters()
+        : offsetX(0),
+          offsetY(0),
+          alpha(0),
+          visible(false)
+    {
+
+    }
+
+    ShadowParameters::ShadowParameters(const GDIPPConfiguration::Values::Shadow & shadow)
+        : offsetX(shadow.GetOffsetX()),
+          offsetY(shadow.GetOffsetY()),
+          alpha(shadow.GetAlpha()),
+          visible(false)
+    {
+        visible = offsetX != INT_MIN && offsetY != INT_MIN &&
+                  Util::ValueInRange(alpha, 1, 255);
+
+        if (!visible)
+        {
+            offsetX = offsetY = alpha = 0;
+        }
+
+        offsetX = ClampOffset(offsetX);
+        offsetY = ClampOffset(offsetY);
+    }
+
+    int ShadowParameters::GetPadding() const
+    {
+        if (!visible)
+        {
+            return 0;
+        }
+
+        return std::max(std::abs(offsetX), std::abs(offsetY));
+    }
+
+    void AddShadowLayer(std::vector<CoverageLayer> & layers,
+                        const CoverageBitmap & channels,
+                        int originX,
+                        int originY,
+                        const ShadowParameters & shadow)
+    {
+        if (!shadow.IsVisible())
+        {
+            return;
+        }
+
+        layers.push_back(CoverageLayer(channels,
+                                       originX + shadow.offsetX,
+                                       originY + shadow.offsetY,
+                                       shadow.alpha));
+    }
+} // namespace GDIPPRenderer
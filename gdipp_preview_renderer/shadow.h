@@ -0,0 +1,72 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "../gdipp-conf-editor/gdipp_configuration_values.h"
+
+#include "coverage_bitmap.h"
+#include "compositor.h"
+
+namespace GDIPPRenderer
+{
+    class ShadowParameters
+    {
+        /*
+        *   gdipp draws the shadow as the text coverage itself, moved by the
+        *   offset and scaled by alpha, underneath the text.
+        */
+
+    public:
+        // offsets are clamped to +-MaxOffset pixels, a hand edited config
+        // must not make the padded preview buffers arbitrarily large
+        static const int MaxOffset = 64;
+
+        ShadowParameters();
+        explicit ShadowParameters(const GDIPPConfiguration::Values::Shadow & shadow);
+
+        // false for unset values and alpha out of the 1 - 255 range
+        bool IsVisible() const
+        {
+            return visible;
+        }
+
+        // room needed around the text so the shadow is not clipped
+        int GetPadding() const;
+
+        int offsetX;
+        int offsetY;
+        int alpha;
+
+    private:
+        bool visible;
+    };
+
+    // adds the shadow layer of text placed at (originX, originY)
+    extern void AddShadowLayer(std::vector<CoverageLayer> & layers,
+                               const CoverageBitmap & channels,
+                               int originX,
+                               int originY,
+                               const ShadowParameters & shadow);
+}
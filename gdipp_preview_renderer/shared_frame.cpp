@@ -0,0 +1,296 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "shared_frame.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "../gdipp-conf-editor/util.h"
+
+#if !defined(_WIN32)
+    #include <sched.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace GDIPPRenderer
+{
+    // orders the sequence number against the frame contents
+    static void MemoryFence()
+    {
+#if defined(_WIN32)
+        MemoryBarrier();
+#else
+        __sync_synchronize();
+#endif
+    }
+
+    static void YieldToWriter()
+    {
+#if defined(_WIN32)
+        SwitchToThread();
+#else
+        sched_yield();
+#endif
+    }
+
+    SharedFrame::SharedFrame(const MetaString & name, size_t capacity, bool create)
+        : name(name),
+          capacity(capacity),
+          owner(create),
+          size(sizeof(Header) + capacity),
+          header(NULL),
+          pixels(NULL)
+    {
+        void * view = NULL;
+
+#if defined(_WIN32)
+        const unsigned long long size64 = size;
+
+        if (create)
+        {
+            mapping = CreateFileMapping(INVALID_HANDLE_VALUE,
+                                        NULL,
+                                        PAGE_READWRITE,
+                                        static_cast<DWORD>(size64 >> 32),
+                                        static_cast<DWORD>(size64 & 0xFFFFFFFF),
+                                        name.c_str());
+        }
+        else
+        {
+            mapping = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+        }
+
+        if (mapping == NULL)
+        {
+            throw std::runtime_error("SharedFrame: unable to open shared memory " + Util::MetaStringToAnsi(name));
+        }
+
+        /*
+        *   A reader maps the whole section, whatever its size, and takes the
+        *   size from the view.
+        */
+        view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, create ? size : 0);
+
+        if (view == NULL)
+        {
+            CloseHandle(mapping);
+            throw std::runtime_error("SharedFrame: unable to map shared memory " + Util::MetaStringToAnsi(name));
+        }
+
+        if (!create)
+        {
+            MEMORY_BASIC_INFORMATION information;
+
+            if (VirtualQuery(view, &information, sizeof(information)) == 0)
+            {
+                UnmapViewOfFile(view);
+                CloseHandle(mapping);
+                throw std::runtime_error("SharedFrame: unable to query shared memory " + Util::MetaStringToAnsi(name));
+            }
+
+            size = information.RegionSize;
+        }
+#else
+        const std::string fileName = Util::MetaStringToAnsi(name);
+
+        descriptor = shm_open(fileName.c_str(), create ? O_CREAT | O_RDWR : O_RDWR, 0600);
+
+        if (descriptor < 0)
+        {
+            throw std::runtime_error("SharedFrame: unable to open shared memory " + fileName);
+        }
+
+        if (create && ftruncate(descriptor, static_cast<off_t>(size)) != 0)
+        {
+            close(descriptor);
+            shm_unlink(fileName.c_str());
+            throw std::runtime_error("SharedFrame: unable to size shared memory " + fileName);
+        }
+
+        if (!create)
+        {
+            /*
+            *   A reader maps what the writer made, a bigger capacity than
+            *   that would map past the end of the object.
+            */
+            struct stat status;
+
+            if (fstat(descriptor, &status) != 0)
+            {
+                close(descriptor);
+                throw std::runtime_error("SharedFrame: unable to query shared memory " + fileName);
+            }
+
+            size = static_cast<size_t>(status.st_size);
+        }
+
+        if (size < sizeof(Header))
+        {
+            close(descriptor);
+            throw std::runtime_error("SharedFrame: the shared memory " + fileName + " is too small for a frame.");
+        }
+
+        view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+
+        if (view == MAP_FAILED)
+        {
+            close(descriptor);
+
+            if (create)
+            {
+                shm_unlink(fileName.c_str());
+            }
+
+            throw std::runtime_error("SharedFrame: unable to map shared memory " + fileName);
+        }
+#endif
+
+        header = static_cast<Header *>(view);
+        pixels = static_cast<unsigned char *>(view) + sizeof(Header);
+
+        if (create)
+        {
+            header->sequence = 0;
+            header->capacity = static_cast<unsigned int>(capacity);
+            header->width = 0;
+            header->height = 0;
+        }
+        else if (header->capacity > size - sizeof(Header))
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile(view);
+            CloseHandle(mapping);
+#else
+            munmap(view, size);
+            close(descriptor);
+#endif
+            throw std::runtime_error("SharedFrame: the shared memory " + Util::MetaStringToAnsi(name) + " is smaller than its capacity.");
+        }
+        else
+        {
+            this->capacity = header->capacity;
+        }
+    }
+
+    SharedFrame::~SharedFrame()
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(header);
+        CloseHandle(mapping);
+#else
+        munmap(header, size);
+        close(descriptor);
+
+        if (owner)
+        {
+            shm_unlink(Util::MetaStringToAnsi(name).c_str());
+        }
+#endif
+    }
+
+    void SharedFrame::Write(const RenderedImage & image)
+    {
+        const size_t rowSize = static_cast<size_t>(image.GetWidth()) * 4;
+
+        if (rowSize * image.GetHeight() > capacity)
+        {
+            throw std::runtime_error("SharedFrame: the image does not fit into the shared memory.");
+        }
+
+        const unsigned int sequence = header->sequence;
+
+        header->sequence = sequence + 1;
+        MemoryFence();
+
+        header->width = image.GetWidth();
+        header->height = image.GetHeight();
+
+        for (int y = 0; y < image.GetHeight(); ++y)
+        {
+            memcpy(pixels + y * rowSize, image.GetRow(y), rowSize);
+        }
+
+        MemoryFence();
+        header->sequence = sequence + 2;
+    }
+
+    bool SharedFrame::Read(RenderedImage & image) const
+    {
+        for (int attempt = 0; attempt < 1000; ++attempt)
+        {
+            const unsigned int before = header->sequence;
+
+            if (before == 0)
+            {
+                return false;
+            }
+
+            if (before & 1)
+            {
+                YieldToWriter();
+                continue;
+            }
+
+            MemoryFence();
+
+            const int width = header->width;
+            const int height = header->height;
+
+            if (width < 0 || height < 0 || static_cast<size_t>(width) * 4 * height > capacity)
+            {
+                // torn header, the sequence check below fails as well
+                YieldToWriter();
+                continue;
+            }
+
+            if (image.GetWidth() != width || image.GetHeight() != height)
+            {
+                image.Resize(width, height, 0);
+            }
+
+            const size_t rowSize = static_cast<size_t>(width) * 4;
+
+            for (int y = 0; y < height; ++y)
+            {
+                memcpy(image.GetRow(y), pixels + y * rowSize, rowSize);
+            }
+
+            MemoryFence();
+
+            if (header->sequence == before)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    unsigned int SharedFrame::GetSequence() const
+    {
+        return header->sequence;
+    }
+} // namespace GDIPPRenderer
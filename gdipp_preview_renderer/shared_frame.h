@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "../gdipp-conf-editor/local_types.h"
+
+#include "rendered_image.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#endif
+
+namespace GDIPPRenderer
+{
+    class SharedFrame
+    {
+        /*
+        *   One preview frame in named shared memory, handed from the
+        *   process rendering it to the one showing it without a file or an
+        *   image codec in between. The region is a 16-byte header (a
+        *   sequence number, the pixel capacity, width and height) and BGRA
+        *   rows.
+        *
+        *   The sequence number is odd while a frame is being written;
+        *   readers retry until they copied a frame with the same even
+        *   number before and after, so one writer and any number of
+        *   readers need no lock.
+        *
+        *   Names are "Local\\..." on Windows and "/..." on POSIX systems.
+        */
+
+    public:
+        // create true - makes a new region of the given pixel capacity (in
+        // bytes) and removes it again in the destructor; false - opens the
+        // region of an existing writer and takes the capacity from its
+        // header, ignoring the argument; throws std::runtime_error when the
+        // region is smaller than the header says
+        SharedFrame(const MetaString & name, size_t capacity, bool create);
+        ~SharedFrame();
+
+        // throws std::runtime_error when the image is bigger than the region
+        void Write(const RenderedImage & image);
+
+        // false when no frame was written yet, or the writer kept
+        // overwriting it while reading
+        bool Read(RenderedImage & image) const;
+
+        // changes with every written frame
+        unsigned int GetSequence() const;
+
+    private:
+        struct Header
+        {
+            volatile unsigned int sequence;
+            unsigned int capacity;
+            int width;
+            int height;
+        };
+
+        MetaString name;
+        size_t capacity;
+        bool owner;
+        size_t size;
+
+        Header * header;
+        unsigned char * pixels;
+
+#if defined(_WIN32)
+        HANDLE mapping;
+#else
+        int descriptor;
+#endif
+
+        SharedFrame(const SharedFrame &);
+        SharedFrame & operator=(const SharedFrame &);
+    };
+}
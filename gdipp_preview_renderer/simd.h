@@ -0,0 +1,57 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+/*
+*   Compile time selection of the vector instruction set used by the
+*   pixel kernels. Define GDIPP_SIMD_DISABLE to build the scalar code only.
+*/
+
+#if !defined(GDIPP_SIMD_DISABLE)
+    #if defined(__AVX2__)
+        #define GDIPP_SIMD_AVX2
+        #define GDIPP_SIMD_SSE2
+    #elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define GDIPP_SIMD_SSE2
+    #endif
+#endif
+
+#if defined(GDIPP_SIMD_AVX2)
+    #include <immintrin.h>
+#elif defined(GDIPP_SIMD_SSE2)
+    #include <emmintrin.h>
+#endif
+
+namespace GDIPPRenderer
+{
+    inline const char * GetSimdLevelName()
+    {
+#if defined(GDIPP_SIMD_AVX2)
+        return "avx2";
+#elif defined(GDIPP_SIMD_SSE2)
+        return "sse2";
+#else
+        return "scalar";
+#endif
+    }
+}
@@ -0,0 +1,200 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "slab_allocator.h"
+
+namespace GDIPPRenderer
+{
+    SlabAllocator::SlabAllocator(size_t slabSize)
+        : slabSize(MinimumBlockSize * 4),
+          reservedBytes(0)
+    {
+        const size_t limit = slabSize < MaximumSlabSize ? slabSize : MaximumSlabSize;
+
+        while (this->slabSize * 2 <= limit)
+        {
+            this->slabSize *= 2;
+        }
+
+        // at least four blocks per slab
+        maximumBlockSize = this->slabSize / 4;
+
+        for (int i = 0; i < MaximumClassCount; ++i)
+        {
+            partialSlabs[i] = NULL;
+        }
+    }
+
+    SlabAllocator::~SlabAllocator()
+    {
+        for (std::map<unsigned char*, Slab*>::iterator it = slabs.begin(); it != slabs.end(); ++it)
+        {
+            delete [] it->second->memory;
+            delete it->second;
+        }
+    }
+
+    int SlabAllocator::GetClass(size_t size)
+    {
+        int sizeClass = 0;
+
+        for (size_t blockSize = MinimumBlockSize; blockSize < size; blockSize *= 2)
+        {
+            ++sizeClass;
+        }
+
+        return sizeClass;
+    }
+
+    void SlabAllocator::LinkPartialSlab(int sizeClass, Slab * slab)
+    {
+        slab->previous = NULL;
+        slab->next = partialSlabs[sizeClass];
+
+        if (slab->next != NULL)
+        {
+            slab->next->previous = slab;
+        }
+
+        partialSlabs[sizeClass] = slab;
+    }
+
+    void SlabAllocator::UnlinkPartialSlab(int sizeClass, Slab * slab)
+    {
+        if (slab->previous != NULL)
+        {
+            slab->previous->next = slab->next;
+        }
+        else
+        {
+            partialSlabs[sizeClass] = slab->next;
+        }
+
+        if (slab->next != NULL)
+        {
+            slab->next->previous = slab->previous;
+        }
+
+        slab->previous = slab->next = NULL;
+    }
+
+    size_t SlabAllocator::GetBlockSize(size_t size) const
+    {
+        if (size > maximumBlockSize)
+        {
+            return size;
+        }
+
+        return MinimumBlockSize << GetClass(size);
+    }
+
+    unsigned char * SlabAllocator::Allocate(size_t size, size_t & blockSize)
+    {
+        blockSize = GetBlockSize(size);
+
+        if (size > maximumBlockSize)
+        {
+            reservedBytes += size;
+
+            return new unsigned char[size];
+        }
+
+        const int sizeClass = GetClass(size);
+
+        if (partialSlabs[sizeClass] == NULL)
+        {
+            // a new slab, all of it goes to its free list
+            Slab * slab = new Slab;
+            slab->memory = new unsigned char[slabSize];
+            slab->freeBlocks = NULL;
+            slab->usedBlocks = 0;
+
+            for (size_t offset = slabSize; offset >= blockSize; offset -= blockSize)
+            {
+                FreeBlock * block = reinterpret_cast<FreeBlock*>(slab->memory + offset - blockSize);
+                block->next = slab->freeBlocks;
+                slab->freeBlocks = block;
+            }
+
+            slabs[slab->memory] = slab;
+            reservedBytes += slabSize;
+
+            LinkPartialSlab(sizeClass, slab);
+        }
+
+        Slab * slab = partialSlabs[sizeClass];
+
+        FreeBlock * block = slab->freeBlocks;
+        slab->freeBlocks = block->next;
+        ++slab->usedBlocks;
+
+        if (slab->freeBlocks == NULL)
+        {
+            UnlinkPartialSlab(sizeClass, slab);
+        }
+
+        return reinterpret_cast<unsigned char*>(block);
+    }
+
+    void SlabAllocator::Free(unsigned char * block, size_t blockSize)
+    {
+        if (block == NULL)
+        {
+            return;
+        }
+
+        if (blockSize > maximumBlockSize)
+        {
+            delete [] block;
+            reservedBytes -= blockSize;
+
+            return;
+        }
+
+        // the last slab starting at or before the block
+        std::map<unsigned char*, Slab*>::iterator it = slabs.upper_bound(block);
+        --it;
+
+        Slab * slab = it->second;
+        const int sizeClass = GetClass(blockSize);
+
+        if (slab->freeBlocks == NULL)
+        {
+            LinkPartialSlab(sizeClass, slab);
+        }
+
+        FreeBlock * freeBlock = reinterpret_cast<FreeBlock*>(block);
+        freeBlock->next = slab->freeBlocks;
+        slab->freeBlocks = freeBlock;
+
+        if (--slab->usedBlocks == 0)
+        {
+            UnlinkPartialSlab(sizeClass, slab);
+            slabs.erase(it);
+
+            delete [] slab->memory;
+            delete slab;
+
+            reservedBytes -= slabSize;
+        }
+    }
+} // namespace GDIPPRenderer
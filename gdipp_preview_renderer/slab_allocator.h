@@ -0,0 +1,101 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <map>
+#include <cstddef>
+
+namespace GDIPPRenderer
+{
+    class SlabAllocator
+    {
+        /*
+        *   Power of two size classes from 64 bytes to a quarter of the slab
+        *   size, carved out of slabs and recycled through a free list per
+        *   class, so a cache churning through small bitmaps does not
+        *   fragment the heap. Larger blocks go straight to the heap. A slab
+        *   goes back to the heap as soon as all of its blocks are free, so
+        *   the reserved memory follows the live blocks. Not thread-safe.
+        */
+
+    public:
+        static const size_t MinimumBlockSize = 64;
+        static const size_t MaximumSlabSize = 65536;
+
+        // slabSize is rounded down to a power of two, 256 - 64 KB
+        explicit SlabAllocator(size_t slabSize = MaximumSlabSize);
+        ~SlabAllocator();
+
+        // bytes Allocate() takes for a block of size bytes
+        size_t GetBlockSize(size_t size) const;
+
+        // blockSize receives the bytes actually taken, pass it to Free()
+        unsigned char * Allocate(size_t size, size_t & blockSize);
+        void Free(unsigned char * block, size_t blockSize);
+
+        // memory taken from the heap, slabs and large blocks
+        size_t GetReservedBytes() const
+        {
+            return reservedBytes;
+        }
+
+    private:
+        static const int MaximumClassCount = 11;
+
+        class FreeBlock
+        {
+        public:
+            FreeBlock * next;
+        };
+
+        class Slab
+        {
+        public:
+            unsigned char * memory;
+            FreeBlock * freeBlocks;
+            size_t usedBlocks;
+
+            // in the list of slabs of the class with free blocks
+            Slab * previous;
+            Slab * next;
+        };
+
+        size_t slabSize;
+        size_t maximumBlockSize;
+
+        // per class, slabs with at least one free block
+        Slab * partialSlabs[MaximumClassCount];
+
+        // by start address, Free() looks up the slab of a block here
+        std::map<unsigned char*, Slab*> slabs;
+        size_t reservedBytes;
+
+        static int GetClass(size_t size);
+
+        void LinkPartialSlab(int sizeClass, Slab * slab);
+        void UnlinkPartialSlab(int sizeClass, Slab * slab);
+
+        SlabAllocator(const SlabAllocator &);
+        SlabAllocator & operator=(const SlabAllocator &);
+    };
+}
@@ -0,0 +1,535 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "software_renderer.h"
+
+#include <algorithm>
+#include <map>
+
+#include "text_layout.h"
+#include "embolden.h"
+#include "lcd_filter.h"
+#include "compositor.h"
+#include "shadow.h"
+
+#include "../gdipp-conf-editor/trace.h"
+#include "../gdipp-conf-editor/metrics.h"
+
+namespace GDIPPRenderer
+{
+    static void AddGlyph(CoverageBitmap & target,
+                         const GlyphBitmap & glyph,
+                         int x,
+                         int y,
+                         int bandBegin,
+                         int bandEnd)
+    {
+        // only the target rows bandBegin - bandEnd - 1 are touched
+        const CoverageBitmap & source = glyph.coverage;
+
+        const int beginX = std::max(0, -x);
+        const int endX = std::min(source.GetWidth(), target.GetWidth() - x);
+        const int beginY = std::max(0, bandBegin - y);
+        const int endY = std::min(source.GetHeight(), bandEnd - y);
+
+        for (int row = beginY; row < endY; ++row)
+        {
+            const unsigned char * sourceRow = source.GetRow(row);
+            unsigned char * targetRow = target.GetRow(y + row) + x;
+
+            for (int column = beginX; column < endX; ++column)
+            {
+                // saturating add, overlapping glyphs stay opaque whatever
+                // the order they are added in
+                int value = targetRow[column] + sourceRow[column];
+                targetRow[column] = static_cast<unsigned char>(std::min(value, 255));
+            }
+        }
+    }
+
+    class RasterizeTask : public ParallelTask
+    {
+    public:
+        // glyphs[i] is the glyph of layout.glyphs[firstUses[i]]
+        RasterizeTask(const TrueTypeFont & font,
+                      const TextLayout & layout,
+                      const std::vector<size_t> & firstUses,
+                      int hinting,
+                      GlyphCache & cache,
+                      std::vector<GlyphRasterizer> & rasterizers,
+                      std::vector<GlyphBitmap> & glyphs)
+            : font(font),
+              layout(layout),
+              firstUses(firstUses),
+              hinting(hinting),
+              cache(cache),
+              fontId(cache.GetFontId(font.GetFileName())),
+              rasterizers(rasterizers),
+              glyphs(glyphs)
+        {
+
+        }
+
+        virtual void Run(int index, int worker)
+        {
+            const PositionedGlyph & positioned = layout.glyphs[firstUses[index]];
+            const GlyphCacheKey key(fontId, positioned.glyphIndex, positioned.pixelSize, SubpixelOversample, hinting);
+
+            if (cache.Find(key, glyphs[index]))
+            {
+                return;
+            }
+
+            const float unitsPerEm = static_cast<float>(font.GetUnitsPerEm());
+
+            glyphs[index] = rasterizers[worker].Rasterize(font.GetGlyphOutline(positioned.glyphIndex),
+                                                          positioned.pixelSize / unitsPerEm,
+                                                          SubpixelOversample,
+                                                          hinting);
+
+            cache.Insert(key, glyphs[index]);
+        }
+
+    private:
+        const TrueTypeFont & font;
+        const TextLayout & layout;
+        const std::vector<size_t> & firstUses;
+        int hinting;
+        GlyphCache & cache;
+        unsigned int fontId;
+        std::vector<GlyphRasterizer> & rasterizers;
+        std::vector<GlyphBitmap> & glyphs;
+    };
+
+    class PlaceTask : public ParallelTask
+    {
+    public:
+        static const int BandHeight = 32;
+
+        // layout.glyphs[i] is drawn with glyphs[slots[i]]
+        PlaceTask(const TextLayout & layout,
+                  const std::vector<GlyphBitmap> & glyphs,
+                  const std::vector<size_t> & slots,
+                  CoverageBitmap & coverage)
+            : layout(layout), glyphs(glyphs), slots(slots), coverage(coverage)
+        {
+
+        }
+
+        virtual void Run(int index, int)
+        {
+            const int bandBegin = index * BandHeight;
+            const int bandEnd = std::min(coverage.GetHeight(), bandBegin + BandHeight);
+
+            for (size_t i = 0; i < layout.glyphs.size(); ++i)
+            {
+                const PositionedGlyph & positioned = layout.glyphs[i];
+                const GlyphBitmap & glyph = glyphs[slots[i]];
+                const int top = positioned.baseline + glyph.top;
+
+                if (top < bandEnd && top + glyph.coverage.GetHeight() > bandBegin)
+                {
+                    AddGlyph(coverage, glyph, positioned.x + glyph.left, top, bandBegin, bandEnd);
+                }
+            }
+        }
+
+    private:
+        const TextLayout & layout;
+        const std::vector<GlyphBitmap> & glyphs;
+        const std::vector<size_t> & slots;
+        CoverageBitmap & coverage;
+    };
+
+    SoftwareRenderer::LayoutKey::LayoutKey()
+        : hinting(0),
+          kerning(false),
+          margin(0)
+    {
+
+    }
+
+    bool SoftwareRenderer::LayoutKey::operator==(const LayoutKey & other) const
+    {
+        return hinting == other.hinting &&
+               kerning == other.kerning &&
+               margin == other.margin &&
+               request.fontFileName == other.request.fontFileName &&
+               request.lines == other.request.lines &&
+               request.pixelSizes == other.request.pixelSizes;
+    }
+
+    SoftwareRenderer::EmboldenKey::EmboldenKey()
+        : rasterizeGeneration(0),
+          strength(0)
+    {
+
+    }
+
+    bool SoftwareRenderer::EmboldenKey::operator==(const EmboldenKey & other) const
+    {
+        return rasterizeGeneration == other.rasterizeGeneration &&
+               strength == other.strength;
+    }
+
+    SoftwareRenderer::SubpixelKey::SubpixelKey()
+        : emboldenGeneration(0),
+          lcdFilter(0),
+          pixelGeometry(0)
+    {
+
+    }
+
+    bool SoftwareRenderer::SubpixelKey::operator==(const SubpixelKey & other) const
+    {
+        return emboldenGeneration == other.emboldenGeneration &&
+               lcdFilter == other.lcdFilter &&
+               pixelGeometry == other.pixelGeometry;
+    }
+
+    SoftwareRenderer::GammaKey::GammaKey()
+        : subpixelGeneration(0),
+          red(0.0),
+          green(0.0),
+          blue(0.0)
+    {
+
+    }
+
+    bool SoftwareRenderer::GammaKey::operator==(const GammaKey & other) const
+    {
+        return subpixelGeneration == other.subpixelGeneration &&
+               red == other.red &&
+               green == other.green &&
+               blue == other.blue;
+    }
+
+    SoftwareRenderer::CompositeKey::CompositeKey()
+        : shadowOffsetX(0),
+          shadowOffsetY(0),
+          shadowAlpha(0),
+          foreground(0),
+          background(0)
+    {
+
+    }
+
+    bool SoftwareRenderer::CompositeKey::operator==(const CompositeKey & other) const
+    {
+        return modes == other.modes &&
+               gammaGenerations == other.gammaGenerations &&
+               shadowOffsetX == other.shadowOffsetX &&
+               shadowOffsetY == other.shadowOffsetY &&
+               shadowAlpha == other.shadowAlpha &&
+               foreground == other.foreground &&
+               background == other.background;
+    }
+
+    const char * SoftwareRenderer::GetStageName(Stage stage)
+    {
+        switch (stage)
+        {
+        case Stage_Layout:
+            return "layout";
+        case Stage_Rasterize:
+            return "rasterize";
+        case Stage_Embolden:
+            return "embolden";
+        case Stage_Subpixel:
+            return "subpixel";
+        case Stage_GammaTable:
+            return "gamma_table";
+        case Stage_Gamma:
+            return "gamma";
+        case Stage_Composite:
+            return "composite";
+        default:
+            return "unknown";
+        }
+    }
+
+    SoftwareRenderer::SoftwareRenderer(int threadCount, GlyphCache * glyphCache)
+        : pool(threadCount),
+          glyphRasterizers(pool.GetThreadCount()),
+          glyphCache(glyphCache != NULL ? glyphCache : &ownGlyphCache)
+    {
+
+    }
+
+    size_t SoftwareRenderer::GetStageRunCount(Stage stage) const
+    {
+        switch (stage)
+        {
+        case Stage_Layout:
+            return layoutStage.GetRunCount();
+        case Stage_Rasterize:
+            return rasterizeStage.GetRunCount();
+        case Stage_Embolden:
+            return emboldenStage.GetRunCount();
+        case Stage_Subpixel:
+            return subpixelStages[0].GetRunCount() + subpixelStages[1].GetRunCount() + subpixelStages[2].GetRunCount();
+        case Stage_GammaTable:
+            return gammaTables.GetBuildCount();
+        case Stage_Gamma:
+            return gammaStages[0].GetRunCount() + gammaStages[1].GetRunCount() + gammaStages[2].GetRunCount();
+        case Stage_Composite:
+            return compositeStage.GetRunCount();
+        default:
+            return 0;
+        }
+    }
+
+    void SoftwareRenderer::LoadFont(const MetaString & fileName)
+    {
+        if (fileName.empty())
+        {
+            throw std::runtime_error("SoftwareRenderer: no font file given.");
+        }
+
+        if (font.IsLoaded() && font.GetFileName() == fileName)
+        {
+            return;
+        }
+
+        font.Load(fileName);
+    }
+
+    void SoftwareRenderer::RunLayout(const LayoutKey & key)
+    {
+        GDIPP_TRACE_SCOPE("SoftwareRenderer::RunLayout");
+
+        TextLayout & layout = layoutStage.Begin();
+        layout = LayoutText(font, key.request, SubpixelOversample, key.hinting, key.kerning, key.margin);
+
+        layoutStage.Commit(key);
+    }
+
+    void SoftwareRenderer::RunRasterize()
+    {
+        GDIPP_TRACE_SCOPE("SoftwareRenderer::RunRasterize");
+        Metrics::ScopedLatency latency(Metrics::Histogram_PreviewRasterize);
+
+        const TextLayout & layout = layoutStage.GetOutput();
+        const int hinting = layoutStage.GetKey().hinting;
+        CoverageBitmap & coverage = rasterizeStage.Begin();
+
+        // one bitmap per distinct glyph and size, a glyph repeated in the
+        // text is looked up and copied from the cache once
+        std::map<std::pair<unsigned int, int>, size_t> slotIndices;
+        std::vector<size_t> slots(layout.glyphs.size());
+        std::vector<size_t> firstUses;
+
+        for (size_t i = 0; i < layout.glyphs.size(); ++i)
+        {
+            const std::pair<unsigned int, int> glyphKey(layout.glyphs[i].glyphIndex, layout.glyphs[i].pixelSize);
+            const std::pair<std::map<std::pair<unsigned int, int>, size_t>::iterator, bool> inserted =
+                slotIndices.insert(std::make_pair(glyphKey, firstUses.size()));
+
+            if (inserted.second)
+            {
+                firstUses.push_back(i);
+            }
+
+            slots[i] = inserted.first->second;
+        }
+
+        // rasterize every glyph not cached yet, then add them up band by band
+        std::vector<GlyphBitmap> glyphs(firstUses.size());
+
+        RasterizeTask rasterizeTask(font, layout, firstUses, hinting, * glyphCache, glyphRasterizers, glyphs);
+        pool.Run(rasterizeTask, static_cast<int>(glyphs.size()));
+
+        coverage.Resize(layout.width * SubpixelOversample, layout.height);
+
+        PlaceTask placeTask(layout, glyphs, slots, coverage);
+        pool.Run(placeTask, (coverage.GetHeight() + PlaceTask::BandHeight - 1) / PlaceTask::BandHeight);
+
+        rasterizeStage.Commit(layoutStage.GetGeneration());
+    }
+
+    void SoftwareRenderer::RunEmbolden(const EmboldenKey & key)
+    {
+        GDIPP_TRACE_SCOPE("SoftwareRenderer::RunEmbolden");
+
+        CoverageBitmap & coverage = emboldenStage.Begin();
+
+        coverage = rasterizeStage.GetOutput();
+        Embolden(coverage, key.strength, SubpixelOversample, &pool);
+
+        emboldenStage.Commit(key);
+    }
+
+    void SoftwareRenderer::RunSubpixel(OutputMode mode, const SubpixelKey & key)
+    {
+        GDIPP_TRACE_SCOPE("SoftwareRenderer::RunSubpixel");
+
+        // subpixel filter, pixel geometry
+        ResolveChannels(emboldenStage.GetOutput(),
+                        subpixelStages[mode].Begin(),
+                        mode,
+                        key.lcdFilter,
+                        key.pixelGeometry,
+                        &pool);
+
+        subpixelStages[mode].Commit(key);
+    }
+
+    void SoftwareRenderer::RunGamma(OutputMode mode, const GammaKey & key)
+    {
+        GDIPP_TRACE_SCOPE("SoftwareRenderer::RunGamma");
+
+        // tables are reused for a known triple
+        const GammaTable & gammaTable = gammaTables.Get(key.red, key.green, key.blue);
+
+        gammaTable.Apply(subpixelStages[mode].GetOutput(), gammaStages[mode].Begin(), &pool);
+        gammaStages[mode].Commit(key);
+    }
+
+    void SoftwareRenderer::RunComposite(const CompositeKey & key)
+    {
+        GDIPP_TRACE_SCOPE("SoftwareRenderer::RunComposite");
+
+        const ShadowParameters shadow(GDIPPConfiguration::Values::Shadow(key.shadowOffsetX,
+                                                                         key.shadowOffsetY,
+                                                                         key.shadowAlpha));
+
+        // room for the shadow around every sheet
+        const int padding = shadow.GetPadding();
+        const TextLayout & layout = layoutStage.GetOutput();
+
+        const int sheetWidth = layout.width + 2 * padding;
+        const int sheetHeight = layout.height + 2 * padding;
+
+        // one sheet per output mode, top to bottom
+        RenderedImage & image = compositeStage.Begin();
+        image.Resize(sheetWidth, sheetHeight * static_cast<int>(key.modes.size()), key.background);
+
+        for (size_t i = 0; i < key.modes.size(); ++i)
+        {
+            const CoverageBitmap & channels = gammaStages[key.modes[i]].GetOutput();
+
+            // shadow, then the text itself
+            const int top = sheetHeight * static_cast<int>(i) + padding;
+
+            std::vector<CoverageLayer> layers;
+            AddShadowLayer(layers, channels, padding, top, shadow);
+            layers.push_back(CoverageLayer(channels, padding, top, 255));
+
+            CompositeLayers(image, layers, key.foreground, &pool);
+        }
+
+        compositeStage.Commit(key);
+    }
+
+    const RenderedImage & SoftwareRenderer::Render(const PreviewRequest & request,
+                                                   const GDIPPConfiguration::Values & values)
+    {
+        GDIPP_TRACE_SCOPE("SoftwareRenderer::Render");
+        Metrics::ScopedLatency latency(Metrics::Histogram_PreviewRender);
+
+        LoadFont(request.fontFileName);
+
+        // values which are not set are treated as neutral
+        const int embolden = ResolveEmbolden(values);
+
+        LayoutKey layoutKey;
+        layoutKey.request = request;
+        layoutKey.hinting = ResolveHinting(values);
+        layoutKey.kerning = ResolveKerning(values);
+        layoutKey.margin = request.margin + GetEmboldenMargin(embolden);
+
+        if (!layoutStage.IsCurrent(layoutKey))
+        {
+            RunLayout(layoutKey);
+        }
+
+        if (!rasterizeStage.IsCurrent(layoutStage.GetGeneration()))
+        {
+            RunRasterize();
+        }
+
+        EmboldenKey emboldenKey;
+        emboldenKey.rasterizeGeneration = rasterizeStage.GetGeneration();
+        emboldenKey.strength = embolden;
+
+        if (!emboldenStage.IsCurrent(emboldenKey))
+        {
+            RunEmbolden(emboldenKey);
+        }
+
+        CompositeKey compositeKey;
+
+        if (request.allOutputModes)
+        {
+            compositeKey.modes.push_back(Output_Mono);
+            compositeKey.modes.push_back(Output_Gray);
+            compositeKey.modes.push_back(Output_Subpixel);
+        }
+        else
+        {
+            compositeKey.modes.push_back(ResolveOutputMode(values));
+        }
+
+        for (size_t i = 0; i < compositeKey.modes.size(); ++i)
+        {
+            const OutputMode mode = compositeKey.modes[i];
+
+            SubpixelKey subpixelKey;
+            subpixelKey.emboldenGeneration = emboldenStage.GetGeneration();
+            subpixelKey.lcdFilter = values.lcdFilter();
+            subpixelKey.pixelGeometry = values.pixelGeometry();
+
+            if (!subpixelStages[mode].IsCurrent(subpixelKey))
+            {
+                RunSubpixel(mode, subpixelKey);
+            }
+
+            GammaKey gammaKey;
+            gammaKey.subpixelGeneration = subpixelStages[mode].GetGeneration();
+            gammaKey.red = values.gamma.GetRValue();
+            gammaKey.green = values.gamma.GetGValue();
+            gammaKey.blue = values.gamma.GetBValue();
+
+            if (!gammaStages[mode].IsCurrent(gammaKey))
+            {
+                RunGamma(mode, gammaKey);
+            }
+
+            compositeKey.gammaGenerations.push_back(gammaStages[mode].GetGeneration());
+        }
+
+        // zero when the shadow is not visible
+        const ShadowParameters shadow(values.shadow);
+        compositeKey.shadowOffsetX = shadow.offsetX;
+        compositeKey.shadowOffsetY = shadow.offsetY;
+        compositeKey.shadowAlpha = shadow.alpha;
+        compositeKey.foreground = request.foreground;
+        compositeKey.background = request.background;
+
+        if (!compositeStage.IsCurrent(compositeKey))
+        {
+            RunComposite(compositeKey);
+        }
+
+        return compositeStage.GetOutput();
+    }
+} // namespace GDIPPRenderer
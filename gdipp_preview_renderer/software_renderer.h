@@ -0,0 +1,199 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "preview_renderer.h"
+#include "truetype_font.h"
+#include "rasterizer.h"
+#include "render_mode.h"
+#include "gamma_table.h"
+#include "thread_pool.h"
+#include "text_layout.h"
+#include "preview_stage.h"
+#include "glyph_cache.h"
+
+namespace GDIPPRenderer
+{
+    class SoftwareRenderer : public PreviewRenderer
+    {
+        /*
+        *   Portable in-process renderer emulating the gdipp pipeline:
+        *   layout -> rasterize -> embolden -> LCD filter -> gamma -> shadow.
+        *   Glyphs are rasterized once at 3x horizontal resolution, mono,
+        *   gray and subpixel output are all resolved from that coverage.
+        *
+        *   Every stage keeps its last output and re-runs only when the
+        *   Values fields it depends on, or a stage before it, change.
+        *   Changing the shadow re-runs compositing only, changing gamma the
+        *   table, gamma and compositing stages.
+        */
+
+    public:
+        enum Stage
+        {
+            Stage_Layout = 0,
+            Stage_Rasterize,
+            Stage_Embolden,
+            Stage_Subpixel,
+            Stage_GammaTable,
+            Stage_Gamma,
+            Stage_Composite,
+            Stage_Count
+        };
+
+        static const char * GetStageName(Stage stage);
+
+        // threadCount 0 - one render thread per processor, the output is
+        // the same for every thread count; glyphCache NULL - a cache of the
+        // renderer's own, otherwise one shared with other renderers
+        explicit SoftwareRenderer(int threadCount = 0, GlyphCache * glyphCache = NULL);
+
+        virtual const RenderedImage & Render(const PreviewRequest & request,
+                                             const GDIPPConfiguration::Values & values);
+
+        // times the stage actually ran since the renderer was created
+        size_t GetStageRunCount(Stage stage) const;
+
+        // changes every time Render returns a different image
+        unsigned int GetImageGeneration() const
+        {
+            return compositeStage.GetGeneration();
+        }
+
+        GlyphCache & GetGlyphCache()
+        {
+            return * glyphCache;
+        }
+
+        // glyph positions of the last rendered image
+        const TextLayout & GetLayout() const
+        {
+            return layoutStage.GetOutput();
+        }
+
+    private:
+        class LayoutKey
+        {
+        public:
+            LayoutKey();
+
+            bool operator==(const LayoutKey & other) const;
+
+            PreviewRequest request;
+            int hinting;
+            bool kerning;
+
+            // request margin plus room for emboldening
+            int margin;
+        };
+
+        class EmboldenKey
+        {
+        public:
+            EmboldenKey();
+
+            bool operator==(const EmboldenKey & other) const;
+
+            unsigned int rasterizeGeneration;
+            int strength;
+        };
+
+        class SubpixelKey
+        {
+        public:
+            SubpixelKey();
+
+            bool operator==(const SubpixelKey & other) const;
+
+            unsigned int emboldenGeneration;
+            int lcdFilter;
+            int pixelGeometry;
+        };
+
+        class GammaKey
+        {
+        public:
+            GammaKey();
+
+            bool operator==(const GammaKey & other) const;
+
+            unsigned int subpixelGeneration;
+            double red;
+            double green;
+            double blue;
+        };
+
+        class CompositeKey
+        {
+        public:
+            CompositeKey();
+
+            bool operator==(const CompositeKey & other) const;
+
+            // output modes top to bottom and the gamma stage of each
+            std::vector<OutputMode> modes;
+            std::vector<unsigned int> gammaGenerations;
+
+            int shadowOffsetX;
+            int shadowOffsetY;
+            int shadowAlpha;
+
+            unsigned int foreground;
+            unsigned int background;
+        };
+
+        TrueTypeFont font;
+        ThreadPool pool;
+
+        // one per pool thread
+        std::vector<GlyphRasterizer> glyphRasterizers;
+        GammaTableCache gammaTables;
+
+        GlyphCache ownGlyphCache;
+        GlyphCache * glyphCache;
+
+        PreviewStage<LayoutKey, TextLayout> layoutStage;
+
+        // coverage, SubpixelOversample samples per pixel
+        PreviewStage<unsigned int, CoverageBitmap> rasterizeStage;
+        PreviewStage<EmboldenKey, CoverageBitmap> emboldenStage;
+
+        // per OutputMode, interleaved R, G, B coverage before and after
+        // gamma correction
+        PreviewStage<SubpixelKey, CoverageBitmap> subpixelStages[3];
+        PreviewStage<GammaKey, CoverageBitmap> gammaStages[3];
+
+        PreviewStage<CompositeKey, RenderedImage> compositeStage;
+
+        void LoadFont(const MetaString & fileName);
+
+        void RunLayout(const LayoutKey & key);
+        void RunRasterize();
+        void RunEmbolden(const EmboldenKey & key);
+        void RunSubpixel(OutputMode mode, const SubpixelKey & key);
+        void RunGamma(OutputMode mode, const GammaKey & key);
+        void RunComposite(const CompositeKey & key);
+    };
+} // namespace GDIPPRenderer
@@ -0,0 +1,155 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "text_layout.h"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../gdipp-conf-editor/util.h"
+
+namespace GDIPPRenderer
+{
+    static unsigned long NextCodePoint(const std::wstring & text, size_t & position)
+    {
+        unsigned long codePoint = static_cast<unsigned long>(text[position++]);
+
+        // wchar_t is UTF-16 on Windows
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF && position < text.length())
+        {
+            unsigned long low = static_cast<unsigned long>(text[position]);
+
+            if (low >= 0xDC00 && low <= 0xDFFF)
+            {
+                ++position;
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+        }
+
+        return codePoint;
+    }
+
+    TextLayout LayoutText(const TrueTypeFont & font,
+                          const PreviewRequest & request,
+                          int oversample,
+                          int hinting,
+                          bool kerning,
+                          int margin)
+    {
+        /*
+        *   Lines are stacked top to bottom, every line repeated for each
+        *   pixel size. Hinting 1 and above puts glyphs on whole pixels,
+        *   hinting 2 and above also rounds the advance widths and kerning.
+        */
+
+        TextLayout layout;
+
+        const float unitsPerEm = static_cast<float>(font.GetUnitsPerEm());
+        int y = margin;
+        int width = 0;
+
+        for (size_t s = 0; s < request.pixelSizes.size(); ++s)
+        {
+            const int pixelSize = request.pixelSizes[s];
+
+            if (!Util::ValueInRange(pixelSize, 1, 512))
+            {
+                throw std::runtime_error("Invalid pixel size in the preview request.");
+            }
+
+            const float scale = pixelSize / unitsPerEm;
+
+            const int ascent = static_cast<int>(std::ceil(font.GetAscender() * scale));
+            const int descent = static_cast<int>(std::ceil(-font.GetDescender() * scale));
+            const int gap = static_cast<int>(std::floor(font.GetLineGap() * scale + 0.5f));
+
+            for (size_t l = 0; l < request.lines.size(); ++l)
+            {
+                const std::wstring & line = request.lines[l];
+                const int baseline = y + ascent;
+                float penX = static_cast<float>(margin);
+                size_t position = 0;
+                bool first = true;
+                unsigned int previousGlyph = 0;
+
+                while (position < line.length())
+                {
+                    unsigned long codePoint = NextCodePoint(line, position);
+
+                    if (codePoint == L'\t')
+                    {
+                        codePoint = L' ';
+                    }
+
+                    PositionedGlyph glyph;
+                    glyph.glyphIndex = font.GetGlyphIndex(codePoint);
+                    glyph.pixelSize = pixelSize;
+                    glyph.baseline = baseline;
+
+                    if (kerning && !first)
+                    {
+                        float adjustment = font.GetKerning(previousGlyph, glyph.glyphIndex) * scale;
+
+                        if (hinting >= 2)
+                        {
+                            adjustment = std::floor(adjustment + 0.5f);
+                        }
+
+                        penX += adjustment;
+                    }
+
+                    first = false;
+                    previousGlyph = glyph.glyphIndex;
+
+                    if (hinting >= 1)
+                    {
+                        glyph.x = static_cast<int>(std::floor(penX + 0.5f)) * oversample;
+                    }
+                    else
+                    {
+                        glyph.x = static_cast<int>(std::floor(penX * oversample + 0.5f));
+                    }
+
+                    layout.glyphs.push_back(glyph);
+
+                    float advance = font.GetAdvanceWidth(glyph.glyphIndex) * scale;
+
+                    if (hinting >= 2)
+                    {
+                        advance = std::floor(advance + 0.5f);
+                    }
+
+                    penX += advance;
+                }
+
+                width = std::max(width, static_cast<int>(std::ceil(penX)) + margin);
+                y += ascent + descent + gap;
+            }
+        }
+
+        layout.width = std::max(width, 2 * margin + 1);
+        layout.height = y + margin;
+
+        return layout;
+    }
+} // namespace GDIPPRenderer
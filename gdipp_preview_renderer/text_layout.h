@@ -0,0 +1,66 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "preview_renderer.h"
+#include "truetype_font.h"
+
+namespace GDIPPRenderer
+{
+    class PositionedGlyph
+    {
+    public:
+        unsigned int glyphIndex;
+        int pixelSize;
+
+        // pen position, horizontally in oversampled pixels
+        int x;
+        int baseline;
+    };
+
+    class TextLayout
+    {
+    public:
+        TextLayout()
+            : width(0), height(0)
+        {
+
+        }
+
+        std::vector<PositionedGlyph> glyphs;
+
+        // size of the whole sheet in (not oversampled) pixels
+        int width;
+        int height;
+    };
+
+    // throws std::runtime_error for a pixel size outside 1..512
+    extern TextLayout LayoutText(const TrueTypeFont & font,
+                                 const PreviewRequest & request,
+                                 int oversample,
+                                 int hinting,
+                                 bool kerning,
+                                 int margin);
+}
@@ -0,0 +1,459 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "thread_pool.h"
+#include "mutex.h"
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <climits>
+#include <stdexcept>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+namespace GDIPPRenderer
+{
+#if defined(_WIN32)
+    class Semaphore
+    {
+    public:
+        Semaphore()
+        {
+            handle = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+
+            if (handle == NULL)
+            {
+                throw std::runtime_error("ThreadPool: cannot create a semaphore.");
+            }
+        }
+
+        ~Semaphore()
+        {
+            CloseHandle(handle);
+        }
+
+        void Post(int count)
+        {
+            ReleaseSemaphore(handle, count, NULL);
+        }
+
+        void Wait()
+        {
+            WaitForSingleObject(handle, INFINITE);
+        }
+
+    private:
+        HANDLE handle;
+
+        Semaphore(const Semaphore &);
+        Semaphore & operator=(const Semaphore &);
+    };
+
+    static long AtomicDecrement(volatile long * value)
+    {
+        return InterlockedDecrement(value);
+    }
+#else
+    class Semaphore
+    {
+    public:
+        Semaphore()
+            : count(0)
+        {
+            pthread_mutex_init(&mutex, NULL);
+            pthread_cond_init(&condition, NULL);
+        }
+
+        ~Semaphore()
+        {
+            pthread_cond_destroy(&condition);
+            pthread_mutex_destroy(&mutex);
+        }
+
+        void Post(int count)
+        {
+            pthread_mutex_lock(&mutex);
+            this->count += count;
+            pthread_cond_broadcast(&condition);
+            pthread_mutex_unlock(&mutex);
+        }
+
+        void Wait()
+        {
+            pthread_mutex_lock(&mutex);
+
+            while (count == 0)
+            {
+                pthread_cond_wait(&condition, &mutex);
+            }
+
+            --count;
+            pthread_mutex_unlock(&mutex);
+        }
+
+    private:
+        pthread_mutex_t mutex;
+        pthread_cond_t condition;
+        int count;
+
+        Semaphore(const Semaphore &);
+        Semaphore & operator=(const Semaphore &);
+    };
+
+    static long AtomicDecrement(volatile long * value)
+    {
+        return __sync_sub_and_fetch(value, 1);
+    }
+#endif
+
+    class ThreadPool::Implementation
+    {
+    public:
+        class Worker
+        {
+        public:
+            Worker()
+                : owner(NULL), index(0)
+            {
+
+            }
+
+            Implementation * owner;
+            int index;
+
+            Mutex lock;
+            std::deque<int> queue;
+
+#if defined(_WIN32)
+            HANDLE thread;
+#else
+            pthread_t thread;
+#endif
+        };
+
+        Implementation(int threadCount);
+        ~Implementation();
+
+        void Run(ParallelTask & task, int count);
+
+    private:
+        std::vector<Worker*> workers;
+
+        ParallelTask * volatile task;
+        volatile long remaining;
+        Mutex stopLock;
+        bool stopping;
+
+        Semaphore wake;
+        Semaphore done;
+
+        Mutex errorLock;
+        bool failed;
+        std::string error;
+
+        void Shutdown(int startedThreads);
+        bool Pop(int index, int & item);
+        void Drain(int index);
+        void WorkerMain(int index);
+
+#if defined(_WIN32)
+        static DWORD WINAPI ThreadEntry(LPVOID parameter);
+#else
+        static void * ThreadEntry(void * parameter);
+#endif
+    };
+
+    ThreadPool::Implementation::Implementation(int threadCount)
+        : task(NULL),
+          remaining(0),
+          stopping(false),
+          failed(false)
+    {
+        for (int i = 0; i < threadCount; ++i)
+        {
+            Worker * worker = new Worker();
+            worker->owner = this;
+            worker->index = i;
+            workers.push_back(worker);
+        }
+
+        // worker 0 is the thread calling Run()
+        for (int i = 1; i < threadCount; ++i)
+        {
+#if defined(_WIN32)
+            workers[i]->thread = CreateThread(NULL, 0, ThreadEntry, workers[i], 0, NULL);
+            const bool started = workers[i]->thread != NULL;
+#else
+            const bool started = pthread_create(&workers[i]->thread, NULL, ThreadEntry, workers[i]) == 0;
+#endif
+
+            if (!started)
+            {
+                Shutdown(i);
+                throw std::runtime_error("ThreadPool: cannot start a worker thread.");
+            }
+        }
+    }
+
+    ThreadPool::Implementation::~Implementation()
+    {
+        Shutdown(static_cast<int>(workers.size()));
+    }
+
+    void ThreadPool::Implementation::Shutdown(int startedThreads)
+    {
+        {
+            ScopedLock lock(stopLock);
+            stopping = true;
+        }
+
+        wake.Post(startedThreads);
+
+        for (int i = 1; i < startedThreads; ++i)
+        {
+#if defined(_WIN32)
+            WaitForSingleObject(workers[i]->thread, INFINITE);
+            CloseHandle(workers[i]->thread);
+#else
+            pthread_join(workers[i]->thread, NULL);
+#endif
+        }
+
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            delete workers[i];
+        }
+
+        workers.clear();
+    }
+
+#if defined(_WIN32)
+    DWORD WINAPI ThreadPool::Implementation::ThreadEntry(LPVOID parameter)
+    {
+        Worker * worker = static_cast<Worker*>(parameter);
+        worker->owner->WorkerMain(worker->index);
+
+        return 0;
+    }
+#else
+    void * ThreadPool::Implementation::ThreadEntry(void * parameter)
+    {
+        Worker * worker = static_cast<Worker*>(parameter);
+        worker->owner->WorkerMain(worker->index);
+
+        return NULL;
+    }
+#endif
+
+    bool ThreadPool::Implementation::Pop(int index, int & item)
+    {
+        // own queue from the front, the ranges stay in order
+        {
+            Worker & own = *workers[index];
+            ScopedLock lock(own.lock);
+
+            if (!own.queue.empty())
+            {
+                item = own.queue.front();
+                own.queue.pop_front();
+                return true;
+            }
+        }
+
+        // steal from the back of another queue
+        for (size_t i = 1; i < workers.size(); ++i)
+        {
+            Worker & victim = *workers[(index + i) % workers.size()];
+            ScopedLock lock(victim.lock);
+
+            if (!victim.queue.empty())
+            {
+                item = victim.queue.back();
+                victim.queue.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void ThreadPool::Implementation::Drain(int index)
+    {
+        int item;
+
+        while (Pop(index, item))
+        {
+            try
+            {
+                task->Run(item, index);
+            }
+            catch (const std::exception & e)
+            {
+                ScopedLock lock(errorLock);
+
+                if (!failed)
+                {
+                    failed = true;
+                    error = e.what();
+                }
+            }
+            catch (...)
+            {
+                ScopedLock lock(errorLock);
+
+                if (!failed)
+                {
+                    failed = true;
+                    error = "ThreadPool: unknown error in a parallel task.";
+                }
+            }
+
+            if (AtomicDecrement(&remaining) == 0)
+            {
+                done.Post(1);
+            }
+        }
+    }
+
+    void ThreadPool::Implementation::WorkerMain(int index)
+    {
+        for (;;)
+        {
+            wake.Wait();
+
+            {
+                ScopedLock lock(stopLock);
+
+                if (stopping)
+                {
+                    return;
+                }
+            }
+
+            Drain(index);
+        }
+    }
+
+    void ThreadPool::Implementation::Run(ParallelTask & task, int count)
+    {
+        const int threads = static_cast<int>(workers.size());
+
+        this->task = &task;
+        remaining = count;
+        failed = false;
+        error.clear();
+
+        for (int i = 0; i < threads; ++i)
+        {
+            ScopedLock lock(workers[i]->lock);
+
+            const int begin = static_cast<int>(static_cast<long long>(count) * i / threads);
+            const int end = static_cast<int>(static_cast<long long>(count) * (i + 1) / threads);
+
+            for (int item = begin; item < end; ++item)
+            {
+                workers[i]->queue.push_back(item);
+            }
+        }
+
+        wake.Post(threads - 1);
+
+        Drain(0);
+        done.Wait();
+
+        this->task = NULL;
+
+        if (failed)
+        {
+            throw std::runtime_error(error);
+        }
+    }
+
+    ThreadPool::ThreadPool(int threadCount)
+        : threadCount(threadCount > 0 ? threadCount : GetProcessorCount()),
+          implementation(NULL)
+    {
+        if (this->threadCount > 1)
+        {
+            implementation = new Implementation(this->threadCount);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        delete implementation;
+    }
+
+    void ThreadPool::Run(ParallelTask & task, int count)
+    {
+        if (count <= 0)
+        {
+            return;
+        }
+
+        if (implementation == NULL || count == 1)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                task.Run(i, 0);
+            }
+
+            return;
+        }
+
+        implementation->Run(task, count);
+    }
+
+    int ThreadPool::GetProcessorCount()
+    {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+
+        const int count = static_cast<int>(info.dwNumberOfProcessors);
+#else
+        const int count = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+
+        return count > 0 ? count : 1;
+    }
+
+    void RunParallel(ThreadPool * pool, ParallelTask & task, int count)
+    {
+        if (pool != NULL)
+        {
+            pool->Run(task, count);
+            return;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            task.Run(i, 0);
+        }
+    }
+} // namespace GDIPPRenderer
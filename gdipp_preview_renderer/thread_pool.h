@@ -0,0 +1,86 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace GDIPPRenderer
+{
+    class ParallelTask
+    {
+        /*
+        *   A batch of independent work items. Run() is called once for every
+        *   index, worker identifies the calling thread (0 - thread count - 1)
+        *   so items can use per-thread scratch memory.
+        */
+
+    public:
+        virtual ~ParallelTask()
+        {
+
+        }
+
+        virtual void Run(int index, int worker) = 0;
+    };
+
+    class ThreadPool
+    {
+        /*
+        *   Fixed set of worker threads with one task queue each. A batch is
+        *   split into contiguous ranges, one per queue; a thread which runs
+        *   out of work steals from the back of the other queues. The calling
+        *   thread works as worker 0 until the whole batch is done.
+        *
+        *   Items must write to disjoint memory, then the result does not
+        *   depend on the thread count or on the order of execution.
+        */
+
+    public:
+        // 0 - one thread per processor
+        explicit ThreadPool(int threadCount = 0);
+        ~ThreadPool();
+
+        int GetThreadCount() const
+        {
+            return threadCount;
+        }
+
+        // calls task.Run() for every index in 0 - count - 1 and waits for all
+        // of them, an exception thrown by an item is rethrown here
+        void Run(ParallelTask & task, int count);
+
+        static int GetProcessorCount();
+
+    private:
+        class Implementation;
+
+        int threadCount;
+        Implementation * implementation;
+
+        ThreadPool(const ThreadPool &);
+        ThreadPool & operator=(const ThreadPool &);
+    };
+
+    // runs the task serially when there is no pool
+    extern void RunParallel(ThreadPool * pool, ParallelTask & task, int count);
+}
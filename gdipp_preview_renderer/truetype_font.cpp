@@ -0,0 +1,599 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "truetype_font.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+
+#include "../gdipp-conf-editor/util.h"
+
+namespace GDIPPRenderer
+{
+    // simple glyph flags
+    static const unsigned int Flag_OnCurve = 0x01;
+    static const unsigned int Flag_XShort = 0x02;
+    static const unsigned int Flag_YShort = 0x04;
+    static const unsigned int Flag_Repeat = 0x08;
+    static const unsigned int Flag_XSameOrPositive = 0x10;
+    static const unsigned int Flag_YSameOrPositive = 0x20;
+
+    // composite glyph flags
+    static const unsigned int Composite_ArgsAreWords = 0x0001;
+    static const unsigned int Composite_ArgsAreXYValues = 0x0002;
+    static const unsigned int Composite_HaveScale = 0x0008;
+    static const unsigned int Composite_MoreComponents = 0x0020;
+    static const unsigned int Composite_HaveXYScale = 0x0040;
+    static const unsigned int Composite_Have2x2 = 0x0080;
+
+    static const int MaxCompositeDepth = 8;
+
+    TrueTypeFont::TrueTypeFont()
+        : glyfOffset(0),
+          locaOffset(0),
+          hmtxOffset(0),
+          cmapOffset(0),
+          cmapFormat(0),
+          indexToLocFormat(0),
+          numGlyphs(0),
+          numberOfHMetrics(0),
+          unitsPerEm(0),
+          ascender(0),
+          descender(0),
+          lineGap(0)
+    {
+
+    }
+
+    void TrueTypeFont::Load(const MetaString & fileName)
+    {
+        std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+
+        if (!file)
+        {
+            throw std::runtime_error("Unable to open font file: " + Util::MetaStringToAnsi(fileName));
+        }
+
+        std::vector<unsigned char> fontData;
+
+        file.seekg(0, std::ios::end);
+        std::streamoff fileSize = file.tellg();
+        file.seekg(0, std::ios::beg);
+
+        if (fileSize <= 0)
+        {
+            throw std::runtime_error("Font file is empty: " + Util::MetaStringToAnsi(fileName));
+        }
+
+        fontData.resize(static_cast<size_t>(fileSize));
+        file.read(reinterpret_cast<char*>(&fontData[0]), fileSize);
+
+        Load(fontData);
+        this->fileName = fileName;
+    }
+
+    void TrueTypeFont::Load(const std::vector<unsigned char> & fontData)
+    {
+        data = fontData;
+        fileName.clear();
+
+        Parse();
+    }
+
+    bool TrueTypeFont::IsLoaded() const
+    {
+        return unitsPerEm != 0;
+    }
+
+    const MetaString & TrueTypeFont::GetFileName() const
+    {
+        return fileName;
+    }
+
+    void TrueTypeFont::Parse()
+    {
+        unitsPerEm = 0;
+
+        unsigned int version = ReadU32(0);
+
+        if (version != 0x00010000 && version != 0x74727565 /* 'true' */)
+        {
+            throw std::runtime_error("Unsupported font format, only TrueType outlines are supported.");
+        }
+
+        unsigned int headTable = FindTable("head");
+        unsigned int maxpTable = FindTable("maxp");
+        unsigned int hheaTable = FindTable("hhea");
+        unsigned int cmapTable = FindTable("cmap");
+
+        hmtxOffset = FindTable("hmtx");
+        locaOffset = FindTable("loca");
+        glyfOffset = FindTable("glyf");
+
+        if (headTable == 0 || maxpTable == 0 || hheaTable == 0 || cmapTable == 0 ||
+            hmtxOffset == 0 || locaOffset == 0 || glyfOffset == 0)
+        {
+            throw std::runtime_error("Font file is missing required TrueType tables.");
+        }
+
+        indexToLocFormat = ReadS16(headTable + 50);
+        numGlyphs = static_cast<int>(ReadU16(maxpTable + 4));
+        ascender = ReadS16(hheaTable + 4);
+        descender = ReadS16(hheaTable + 6);
+        lineGap = ReadS16(hheaTable + 8);
+        numberOfHMetrics = static_cast<int>(ReadU16(hheaTable + 34));
+
+        SelectCharacterMap(cmapTable);
+
+        kerning.Build(data, FindTable("kern"), FindTable("GPOS"), numGlyphs);
+
+        // set last, marks the font as loaded
+        unitsPerEm = static_cast<int>(ReadU16(headTable + 18));
+
+        if (unitsPerEm == 0 || numberOfHMetrics == 0)
+        {
+            unitsPerEm = 0;
+            throw std::runtime_error("Font file has invalid header values.");
+        }
+    }
+
+    unsigned int TrueTypeFont::FindTable(const char * tag) const
+    {
+        unsigned int numTables = ReadU16(4);
+
+        for (unsigned int i = 0; i < numTables; ++i)
+        {
+            unsigned int record = 12 + 16 * i;
+
+            if (record + 16 > data.size())
+            {
+                throw std::runtime_error("Unexpected end of font data.");
+            }
+
+            if (memcmp(&data[record], tag, 4) == 0)
+            {
+                return ReadU32(record + 8);
+            }
+        }
+
+        return 0;
+    }
+
+    void TrueTypeFont::SelectCharacterMap(unsigned int cmapTable)
+    {
+        /*
+        *   Prefer the full Unicode repertoire (format 12), fall back to the
+        *   BMP (format 4).
+        */
+
+        unsigned int numSubtables = ReadU16(cmapTable + 2);
+        unsigned int bmpSubtable = 0;
+        unsigned int fullSubtable = 0;
+
+        for (unsigned int i = 0; i < numSubtables; ++i)
+        {
+            unsigned int record = cmapTable + 4 + 8 * i;
+            unsigned int platformId = ReadU16(record);
+            unsigned int encodingId = ReadU16(record + 2);
+            unsigned int subtable = cmapTable + ReadU32(record + 4);
+            unsigned int format = ReadU16(subtable);
+
+            bool unicodePlatform = (platformId == 0) ||
+                                   (platformId == 3 && (encodingId == 1 || encodingId == 10));
+
+            if (!unicodePlatform)
+            {
+                continue;
+            }
+
+            if (format == 12 && fullSubtable == 0)
+            {
+                fullSubtable = subtable;
+            }
+            else if (format == 4 && bmpSubtable == 0)
+            {
+                bmpSubtable = subtable;
+            }
+        }
+
+        if (fullSubtable)
+        {
+            cmapOffset = fullSubtable;
+            cmapFormat = 12;
+        }
+        else if (bmpSubtable)
+        {
+            cmapOffset = bmpSubtable;
+            cmapFormat = 4;
+        }
+        else
+        {
+            throw std::runtime_error("Font file has no Unicode character map.");
+        }
+    }
+
+    unsigned int TrueTypeFont::GetGlyphIndex(unsigned long codePoint) const
+    {
+        if (cmapFormat == 12)
+        {
+            unsigned int numGroups = ReadU32(cmapOffset + 12);
+            unsigned int low = 0;
+            unsigned int high = numGroups;
+
+            while (low < high)
+            {
+                unsigned int middle = (low + high) / 2;
+                unsigned int group = cmapOffset + 16 + 12 * middle;
+                unsigned long startCode = ReadU32(group);
+                unsigned long endCode = ReadU32(group + 4);
+
+                if (codePoint < startCode)
+                {
+                    high = middle;
+                }
+                else if (codePoint > endCode)
+                {
+                    low = middle + 1;
+                }
+                else
+                {
+                    return static_cast<unsigned int>(ReadU32(group + 8) + (codePoint - startCode));
+                }
+            }
+
+            return 0;
+        }
+
+        if (cmapFormat == 4 && codePoint <= 0xFFFF)
+        {
+            unsigned int segCountX2 = ReadU16(cmapOffset + 6);
+            unsigned int endCodes = cmapOffset + 14;
+            unsigned int startCodes = endCodes + segCountX2 + 2;
+            unsigned int idDeltas = startCodes + segCountX2;
+            unsigned int idRangeOffsets = idDeltas + segCountX2;
+
+            unsigned int low = 0;
+            unsigned int high = segCountX2 / 2;
+
+            while (low < high)
+            {
+                unsigned int middle = (low + high) / 2;
+
+                if (ReadU16(endCodes + 2 * middle) < codePoint)
+                {
+                    low = middle + 1;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+
+            if (low >= segCountX2 / 2)
+            {
+                return 0;
+            }
+
+            unsigned int startCode = ReadU16(startCodes + 2 * low);
+
+            if (startCode > codePoint)
+            {
+                return 0;
+            }
+
+            unsigned int idDelta = ReadU16(idDeltas + 2 * low);
+            unsigned int idRangeOffset = ReadU16(idRangeOffsets + 2 * low);
+
+            if (idRangeOffset == 0)
+            {
+                return (codePoint + idDelta) & 0xFFFF;
+            }
+
+            unsigned int glyphIndex = ReadU16(idRangeOffsets + 2 * low + idRangeOffset +
+                                              2 * (static_cast<unsigned int>(codePoint) - startCode));
+
+            if (glyphIndex == 0)
+            {
+                return 0;
+            }
+
+            return (glyphIndex + idDelta) & 0xFFFF;
+        }
+
+        return 0;
+    }
+
+    int TrueTypeFont::GetAdvanceWidth(unsigned int glyphIndex) const
+    {
+        if (static_cast<int>(glyphIndex) >= numberOfHMetrics)
+        {
+            glyphIndex = numberOfHMetrics - 1;
+        }
+
+        return static_cast<int>(ReadU16(hmtxOffset + 4 * glyphIndex));
+    }
+
+    int TrueTypeFont::GetUnitsPerEm() const
+    {
+        return unitsPerEm;
+    }
+
+    int TrueTypeFont::GetAscender() const
+    {
+        return ascender;
+    }
+
+    int TrueTypeFont::GetDescender() const
+    {
+        return descender;
+    }
+
+    int TrueTypeFont::GetLineGap() const
+    {
+        return lineGap;
+    }
+
+    GlyphOutline TrueTypeFont::GetGlyphOutline(unsigned int glyphIndex) const
+    {
+        GlyphOutline outline;
+        AppendGlyphOutline(glyphIndex, outline, 0);
+
+        return outline;
+    }
+
+    bool TrueTypeFont::GetGlyphRange(unsigned int glyphIndex,
+                                     unsigned int & offset,
+                                     unsigned int & length) const
+    {
+        if (static_cast<int>(glyphIndex) >= numGlyphs)
+        {
+            return false;
+        }
+
+        unsigned int start, end;
+
+        if (indexToLocFormat == 0)
+        {
+            start = ReadU16(locaOffset + 2 * glyphIndex) * 2;
+            end = ReadU16(locaOffset + 2 * glyphIndex + 2) * 2;
+        }
+        else
+        {
+            start = ReadU32(locaOffset + 4 * glyphIndex);
+            end = ReadU32(locaOffset + 4 * glyphIndex + 4);
+        }
+
+        if (end <= start)
+        {
+            // no outline (e.g. space)
+            return false;
+        }
+
+        offset = glyfOffset + start;
+        length = end - start;
+
+        return true;
+    }
+
+    void TrueTypeFont::AppendGlyphOutline(unsigned int glyphIndex,
+                                          GlyphOutline & outline,
+                                          int depth) const
+    {
+        unsigned int glyph, length;
+
+        if (depth > MaxCompositeDepth || GetGlyphRange(glyphIndex, glyph, length) == false)
+        {
+            return;
+        }
+
+        int numberOfContours = ReadS16(glyph);
+
+        if (numberOfContours >= 0)
+        {
+            const size_t firstPoint = outline.points.size();
+            unsigned int endPoints = glyph + 10;
+            int numPoints = 0;
+
+            for (int i = 0; i < numberOfContours; ++i)
+            {
+                int contourEnd = static_cast<int>(ReadU16(endPoints + 2 * i));
+
+                if (contourEnd < numPoints - 1)
+                {
+                    throw std::runtime_error("Malformed glyph outline in font file.");
+                }
+
+                numPoints = contourEnd + 1;
+                outline.contourEnds.push_back(static_cast<int>(firstPoint) + contourEnd);
+            }
+
+            unsigned int instructionLength = ReadU16(endPoints + 2 * numberOfContours);
+            unsigned int cursor = endPoints + 2 * numberOfContours + 2 + instructionLength;
+
+            std::vector<unsigned char> flags(numPoints);
+
+            for (int i = 0; i < numPoints; )
+            {
+                unsigned char flag = static_cast<unsigned char>(ReadU8(cursor++));
+                flags[i++] = flag;
+
+                if (flag & Flag_Repeat)
+                {
+                    unsigned int repeat = ReadU8(cursor++);
+
+                    while (repeat-- > 0 && i < numPoints)
+                    {
+                        flags[i++] = flag;
+                    }
+                }
+            }
+
+            outline.points.resize(firstPoint + numPoints);
+
+            int x = 0;
+
+            for (int i = 0; i < numPoints; ++i)
+            {
+                if (flags[i] & Flag_XShort)
+                {
+                    int delta = static_cast<int>(ReadU8(cursor++));
+                    x += (flags[i] & Flag_XSameOrPositive) ? delta : -delta;
+                }
+                else if ((flags[i] & Flag_XSameOrPositive) == 0)
+                {
+                    x += ReadS16(cursor);
+                    cursor += 2;
+                }
+
+                outline.points[firstPoint + i].x = static_cast<float>(x);
+                outline.points[firstPoint + i].onCurve = (flags[i] & Flag_OnCurve) != 0;
+            }
+
+            int y = 0;
+
+            for (int i = 0; i < numPoints; ++i)
+            {
+                if (flags[i] & Flag_YShort)
+                {
+                    int delta = static_cast<int>(ReadU8(cursor++));
+                    y += (flags[i] & Flag_YSameOrPositive) ? delta : -delta;
+                }
+                else if ((flags[i] & Flag_YSameOrPositive) == 0)
+                {
+                    y += ReadS16(cursor);
+                    cursor += 2;
+                }
+
+                outline.points[firstPoint + i].y = static_cast<float>(y);
+            }
+
+            return;
+        }
+
+        // composite glyph
+        unsigned int cursor = glyph + 10;
+        unsigned int componentFlags;
+
+        do
+        {
+            componentFlags = ReadU16(cursor);
+            unsigned int componentIndex = ReadU16(cursor + 2);
+            cursor += 4;
+
+            float dx = 0, dy = 0;
+
+            if (componentFlags & Composite_ArgsAreWords)
+            {
+                dx = static_cast<float>(ReadS16(cursor));
+                dy = static_cast<float>(ReadS16(cursor + 2));
+                cursor += 4;
+            }
+            else
+            {
+                dx = static_cast<float>(static_cast<signed char>(ReadU8(cursor)));
+                dy = static_cast<float>(static_cast<signed char>(ReadU8(cursor + 1)));
+                cursor += 2;
+            }
+
+            if ((componentFlags & Composite_ArgsAreXYValues) == 0)
+            {
+                // point matching is not supported, place the component at the origin
+                dx = dy = 0;
+            }
+
+            float a = 1, b = 0, c = 0, d = 1;
+
+            if (componentFlags & Composite_HaveScale)
+            {
+                a = d = ReadS16(cursor) / 16384.0f;
+                cursor += 2;
+            }
+            else if (componentFlags & Composite_HaveXYScale)
+            {
+                a = ReadS16(cursor) / 16384.0f;
+                d = ReadS16(cursor + 2) / 16384.0f;
+                cursor += 4;
+            }
+            else if (componentFlags & Composite_Have2x2)
+            {
+                a = ReadS16(cursor) / 16384.0f;
+                b = ReadS16(cursor + 2) / 16384.0f;
+                c = ReadS16(cursor + 4) / 16384.0f;
+                d = ReadS16(cursor + 6) / 16384.0f;
+                cursor += 8;
+            }
+
+            const size_t firstPoint = outline.points.size();
+            AppendGlyphOutline(componentIndex, outline, depth + 1);
+
+            for (size_t i = firstPoint; i < outline.points.size(); ++i)
+            {
+                GlyphOutline::Point & point = outline.points[i];
+                float px = point.x;
+                float py = point.y;
+
+                point.x = a * px + c * py + dx;
+                point.y = b * px + d * py + dy;
+            }
+        }
+        while (componentFlags & Composite_MoreComponents);
+    }
+
+    unsigned int TrueTypeFont::ReadU8(unsigned int offset) const
+    {
+        if (offset >= data.size())
+        {
+            throw std::runtime_error("Unexpected end of font data.");
+        }
+
+        return data[offset];
+    }
+
+    unsigned int TrueTypeFont::ReadU16(unsigned int offset) const
+    {
+        if (offset + 2 > data.size() || offset + 2 < offset)
+        {
+            throw std::runtime_error("Unexpected end of font data.");
+        }
+
+        return (static_cast<unsigned int>(data[offset]) << 8) | data[offset + 1];
+    }
+
+    int TrueTypeFont::ReadS16(unsigned int offset) const
+    {
+        return static_cast<short>(static_cast<unsigned short>(ReadU16(offset)));
+    }
+
+    unsigned int TrueTypeFont::ReadU32(unsigned int offset) const
+    {
+        if (offset + 4 > data.size() || offset + 4 < offset)
+        {
+            throw std::runtime_error("Unexpected end of font data.");
+        }
+
+        return (static_cast<unsigned int>(data[offset]) << 24) |
+               (static_cast<unsigned int>(data[offset + 1]) << 16) |
+               (static_cast<unsigned int>(data[offset + 2]) << 8) |
+               data[offset + 3];
+    }
+} // namespace GDIPPRenderer
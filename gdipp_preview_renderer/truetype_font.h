@@ -0,0 +1,134 @@
+/*
+    Copyright (c) 2019 Dawid Bautsch
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "../gdipp-conf-editor/local_types.h"
+
+#include "kerning_table.h"
+
+namespace GDIPPRenderer
+{
+    class GlyphOutline
+    {
+    public:
+        class Point
+        {
+        public:
+            Point()
+                : x(0), y(0), onCurve(true)
+            {
+
+            }
+
+            Point(float x, float y, bool onCurve)
+                : x(x), y(y), onCurve(onCurve)
+            {
+
+            }
+
+            float x;
+            float y;
+            bool onCurve;
+        };
+
+        // font units, y axis pointing up
+        std::vector<Point> points;
+
+        // index of the last point of every contour
+        std::vector<int> contourEnds;
+    };
+
+    class TrueTypeFont
+    {
+        /*
+        *   Minimal reader of TrueType (glyf based) font files: character map,
+        *   horizontal metrics, pair kerning and quadratic glyph outlines.
+        *   Hinting instructions are not interpreted.
+        */
+
+    public:
+        TrueTypeFont();
+
+        void Load(const MetaString & fileName);
+        void Load(const std::vector<unsigned char> & fontData);
+
+        bool IsLoaded() const;
+        const MetaString & GetFileName() const;
+
+        unsigned int GetGlyphIndex(unsigned long codePoint) const;
+        GlyphOutline GetGlyphOutline(unsigned int glyphIndex) const;
+        int GetAdvanceWidth(unsigned int glyphIndex) const;
+
+        // font units to add to the advance of left when followed by right
+        int GetKerning(unsigned int left, unsigned int right) const
+        {
+            return kerning.GetAdjustment(left, right);
+        }
+
+        const KerningTable & GetKerningTable() const
+        {
+            return kerning;
+        }
+
+        int GetUnitsPerEm() const;
+        int GetAscender() const;
+        int GetDescender() const;
+        int GetLineGap() const;
+
+    private:
+        MetaString fileName;
+        std::vector<unsigned char> data;
+
+        unsigned int glyfOffset;
+        unsigned int locaOffset;
+        unsigned int hmtxOffset;
+        unsigned int cmapOffset;
+        int cmapFormat;
+        int indexToLocFormat;
+        int numGlyphs;
+        int numberOfHMetrics;
+        int unitsPerEm;
+        int ascender;
+        int descender;
+        int lineGap;
+
+        KerningTable kerning;
+
+        void Parse();
+        unsigned int FindTable(const char * tag) const;
+        void SelectCharacterMap(unsigned int cmapTable);
+        bool GetGlyphRange(unsigned int glyphIndex,
+                           unsigned int & offset,
+                           unsigned int & length) const;
+        void AppendGlyphOutline(unsigned int glyphIndex,
+                                GlyphOutline & outline,
+                                int depth) const;
+
+        unsigned int ReadU8(unsigned int offset) const;
+        unsigned int ReadU16(unsigned int offset) const;
+        int ReadS16(unsigned int offset) const;
+        unsigned int ReadU32(unsigned int offset) const;
+    };
+} // namespace GDIPPRenderer